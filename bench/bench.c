@@ -0,0 +1,333 @@
+#include "generator.h"
+#include "types.h"
+
+#include <Psapi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma comment(lib, "psapi.lib")
+
+#define MAX_BENCH_RUNS 64           // maximum number of runs per benchmark
+#define MAX_COMMAND_LINE 2048       // maximum length of the command line
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Listing mode to benchmark with the arguments for 'ls' and for the
+ * GNU 'ls' baseline.
+ *
+ * 'name'       : name of the mode
+ * 'lsArgs'     : arguments of this 'ls'
+ * 'gnuArgs'    : equivalent arguments of GNU 'ls'
+ * 'recursive'  : the whole tree is listed
+ */
+typedef struct bench_mode_t
+{
+    const char *name;
+    const char *lsArgs, *gnuArgs;
+    BOOL recursive;
+} bench_mode_t;
+
+/**
+ * @brief Result of running a command several times.
+ *
+ * 'seconds'    : median of the wall time of the runs
+ * 'peakMemory' : largest peak working set of the runs, in bytes
+ */
+typedef struct bench_result_t
+{
+    double seconds;
+    size_t peakMemory;
+} bench_result_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+global_variable const bench_mode_t g_BenchModes[] =
+{
+    { "short",      "",                 "",         FALSE   },
+    { "long",       "-l",               "-l",       FALSE   },
+    { "recursive",  "-R",               "-R",       TRUE    },
+    { "long-rec",   "-lR",              "-lR",      TRUE    },
+    { "sorted",     "-l --sort SIZE",   "-lS",      FALSE   },
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Function used by 'qsort' algorithm to order the run times.
+ *
+ * @param lhv pointer to the first element to compare
+ * @param rhv pointer to the second element to compare
+ */
+local_function int OrderByTime(const void *lhv, const void *rhv)
+{
+    const double *a = lhv; const double *b = rhv;
+    return (*a > *b) - (*a < *b);
+}
+
+/**
+ * @brief Count the assets of a directory that 'ls' lists by default, the
+ * hidden ones and the names starting with '.' or '$' are skipped as the
+ * listing does (the hidden directories are not walked either).
+ *
+ * @param path      directory to count
+ * @param recursive count the assets of the sub-directories too
+ * @return size_t   number of assets
+ */
+local_function size_t CountEntries(const char *path, BOOL recursive)
+{
+    char buffer[MAX_PATH] = { 0 };
+    WIN32_FIND_DATAA fd = { 0 };
+    size_t count = 0;
+
+    snprintf(buffer, sizeof(buffer), "%s\\*", path);
+
+    HANDLE hFind = FindFirstFileExA(buffer, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) return 0;
+
+    do
+    {
+        if ((fd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) || fd.cFileName[0] == '.' || fd.cFileName[0] == '$')
+        {
+            continue;
+        }
+
+        ++count;
+
+        if (recursive && (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        {
+            snprintf(buffer, sizeof(buffer), "%s\\%s", path, fd.cFileName);
+            count += CountEntries(buffer, recursive);
+        }
+    } while (FindNextFileA(hFind, &fd));
+
+    FindClose(hFind);
+    return count;
+}
+
+/**
+ * @brief Run a command with the output redirected to 'NUL' and measure it.
+ *
+ * @param commandLine   command line to run
+ * @param seconds       valid pointer where the wall time is stored
+ * @param peakMemory    valid pointer where the peak working set is stored
+ * @return BOOL         TRUE if it could run, FALSE otherwise
+ */
+local_function BOOL RunCommand(const char *commandLine, double *seconds, size_t *peakMemory)
+{
+    char command[MAX_COMMAND_LINE] = { 0 };
+    strcpy_s(command, MAX_COMMAND_LINE, commandLine);
+
+    SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), NULL, TRUE };
+    HANDLE hNul = CreateFileA("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa, OPEN_EXISTING, 0, NULL);
+    if (hNul == INVALID_HANDLE_VALUE) return FALSE;
+
+    STARTUPINFOA si = { sizeof(STARTUPINFOA) };
+    PROCESS_INFORMATION pi = { 0 };
+
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdOutput = si.hStdError = hNul;
+
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    if (!CreateProcessA(NULL, command, NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi))
+    {
+        CloseHandle(hNul);
+        return FALSE;
+    }
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    QueryPerformanceCounter(&end);
+
+    PROCESS_MEMORY_COUNTERS pmc = { sizeof(PROCESS_MEMORY_COUNTERS) };
+    GetProcessMemoryInfo(pi.hProcess, &pmc, sizeof(pmc));
+
+    *seconds = (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+    *peakMemory = pmc.PeakWorkingSetSize;
+
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    CloseHandle(hNul);
+
+    return TRUE;
+}
+
+/**
+ * @brief Run a listing several times, the first run warms up the file
+ * system cache and it is not measured.
+ *
+ * @param program   path of the program to run
+ * @param args      arguments of the program
+ * @param path      directory to list
+ * @param runs      number of measured runs
+ * @param result    valid pointer where the result is stored
+ * @return BOOL     TRUE if all the runs could run, FALSE otherwise
+ */
+local_function BOOL RunListing(const char *program, const char *args, const char *path, size_t runs, bench_result_t *result)
+{
+    char commandLine[MAX_COMMAND_LINE] = { 0 };
+    double times[MAX_BENCH_RUNS] = { 0 };
+
+    sprintf_s(commandLine, MAX_COMMAND_LINE, "\"%s\" %s \"%s\"", program, args, path);
+    memset(result, 0, sizeof(bench_result_t));
+
+    for (size_t i = 0; i <= runs; ++i)
+    {
+        double seconds = 0.0;
+        size_t peakMemory = 0;
+
+        if (!RunCommand(commandLine, &seconds, &peakMemory))
+        {
+            return FALSE;
+        }
+
+        if (i > 0)
+        {
+            times[i - 1] = seconds;
+            result->peakMemory = peakMemory > result->peakMemory ? peakMemory : result->peakMemory;
+        }
+    }
+
+    qsort(times, runs, sizeof(double), OrderByTime);
+    result->seconds = times[runs / 2];
+
+    return TRUE;
+}
+
+/**
+ * @brief Print a result row of the report.
+ *
+ * @param tree      name of the tree
+ * @param mode      name of the listing mode
+ * @param tool      name of the tool
+ * @param entries   number of listed assets
+ * @param result    pointer to the result
+ */
+local_function void PrintResult(const char *tree, const char *mode, const char *tool, size_t entries, const bench_result_t *result)
+{
+    double entriesPerSecond = result->seconds > 0.0 ? entries / result->seconds : 0.0;
+    double peakMemory = result->peakMemory / (1024.0 * 1024.0);
+
+    printf_s("%-8s  %-9s  %-4s  %10zu  %10.2lf  %12.0lf  %9.2lf\n", tree, mode, tool, entries, result->seconds * 1000.0, entriesPerSecond, peakMemory);
+}
+
+/**
+ * @brief Run all the listing modes against all the generated trees.
+ *
+ * @param root      directory with the generated trees
+ * @param lsPath    path of the 'ls' to benchmark
+ * @param gnuPath   path of GNU 'ls' used as baseline or NULL
+ * @param runs      number of measured runs per benchmark
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+local_function BOOL RunBenchmarks(const char *root, const char *lsPath, const char *gnuPath, size_t runs)
+{
+    char path[MAX_PATH] = { 0 };
+    printf_s("%-8s  %-9s  %-4s  %10s  %10s  %12s  %9s\n", "tree", "mode", "tool", "entries", "median ms", "entries/s", "peak MB");
+
+    for (size_t i = 0; i < g_NumBenchTrees; ++i)
+    {
+        sprintf_s(path, MAX_PATH, "%s\\%s", root, g_BenchTrees[i].name);
+
+        for (size_t j = 0; j < ARRAY_SIZE(g_BenchModes); ++j)
+        {
+            const bench_mode_t *mode = &g_BenchModes[j];
+            size_t entries = CountEntries(path, mode->recursive);
+            bench_result_t result = { 0 };
+
+            if (!RunListing(lsPath, mode->lsArgs, path, runs, &result))
+            {
+                printf_s("Can not run \"%s\"\n", lsPath);
+                return FALSE;
+            }
+
+            PrintResult(g_BenchTrees[i].name, mode->name, "ls", entries, &result);
+
+            if (gnuPath != NULL)
+            {
+                if (!RunListing(gnuPath, mode->gnuArgs, path, runs, &result))
+                {
+                    printf_s("Can not run \"%s\"\n", gnuPath);
+                    return FALSE;
+                }
+
+                PrintResult(g_BenchTrees[i].name, mode->name, "gnu", entries, &result);
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Prints the help of the benchmark to the screen.
+ */
+local_function void ShowBenchHelp()
+{
+    const char *help =
+        "Usage\n"
+        "  ls_bench generate [root] [options]\n"
+        "  ls_bench run [root] [options]\n\n"
+
+        "GENERATE OPTIONS\n"
+        "      --scale [N]                  multiply the number of files and directories (default 1.0)\n"
+        "      --seed [N]                   seed of the random names and sizes (default 0)\n\n"
+
+        "RUN OPTIONS\n"
+        "      --ls [PATH]                  ls to benchmark (default ls.exe next to ls_bench.exe)\n"
+        "      --baseline [PATH]            GNU ls used as baseline, ex: C:\\msys64\\usr\\bin\\ls.exe\n"
+        "      --runs [N]                   number of measured runs per benchmark (default 5)\n";
+
+    printf_s("%s", help);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        ShowBenchHelp();
+        return EXIT_FAILURE;
+    }
+
+    char lsPath[MAX_PATH] = { 0 };
+    const char *gnuPath = NULL;
+
+    double scale = 1.0;
+    unsigned long long seed = 0;
+    size_t runs = 5;
+
+    // NOTE(Andrei): By default use the ls built with the benchmark.
+    GetModuleFileNameA(NULL, lsPath, MAX_PATH);
+    char *c = strrchr(lsPath, '\\');
+    if (c != NULL) strcpy_s(c + 1, MAX_PATH - (c + 1 - lsPath), "ls.exe");
+
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--scale") == 0) scale = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--ls") == 0) strcpy_s(lsPath, MAX_PATH, argv[i + 1]);
+        else if (strcmp(argv[i], "--baseline") == 0) gnuPath = argv[i + 1];
+        else if (strcmp(argv[i], "--runs") == 0) runs = strtoul(argv[i + 1], NULL, 10);
+    }
+
+    runs = runs < 1 ? 1 : runs > MAX_BENCH_RUNS ? MAX_BENCH_RUNS : runs;
+
+    if (strcmp(argv[1], "generate") == 0)
+    {
+        return GenerateBenchTrees(argv[2], scale, seed) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (strcmp(argv[1], "run") == 0)
+    {
+        return RunBenchmarks(argv[2], lsPath, gnuPath, runs) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    ShowBenchHelp();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,195 @@
+#include "generator.h"
+#include "types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+
+// Maximum length of a generated path (UTF-16 characters)
+#define MAX_BENCH_PATH 1024
+
+// Maximum size in bytes of a generated file, small files stay resident in the MFT
+#define MAX_BENCH_FILE_SIZE 600
+
+///////////////////////////////////////////////////////////////////////////////
+
+const tree_spec_t g_BenchTrees[] =
+{
+    //  name        depth   dirs    files       minName maxName unicode
+    {   "flat",     0,      0,      1000000,    8,      8,      FALSE   },
+    {   "deep",     40,     1,      8,          4,      4,      FALSE   },
+    {   "wide",     1,      5000,   40,         8,      16,     FALSE   },
+    {   "mixed",    1,      50,     2000,       1,      120,    FALSE   },
+    {   "unicode",  1,      50,     1000,       4,      40,     TRUE    },
+};
+
+const size_t g_NumBenchTrees = ARRAY_SIZE(g_BenchTrees);
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Non ASCII characters used for the Unicode names: latin accents,
+ * greek, cyrillic, CJK and a surrogate pair (emoji).
+ */
+global_variable const wchar_t *g_UnicodeSyllables[] =
+{
+    L"\u00e1", L"\u00f1", L"\u00fc", L"\u00e7", // á ñ ü ç
+    L"\u03b1\u03b2", L"\u03a9",                 // αβ Ω
+    L"\u0436", L"\u044f\u0449",                 // ж ящ
+    L"\u65e5\u672c", L"\u6587", L"\uac00",      // 日本 文 가
+    L"\u05d0", L"\u0627", L"\U0001F600",        // א ا emoji
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Next number of the xorshift64* pseudo random generator.
+ *
+ * @param state                 pointer to the generator state (not zero)
+ * @return unsigned long long   random number
+ */
+local_function unsigned long long NextRandom(unsigned long long *state)
+{
+    unsigned long long x = *state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Random number in the range [low, high].
+ *
+ * @param state     pointer to the generator state
+ * @param low       minimum value
+ * @param high      maximum value
+ * @return size_t   random number
+ */
+local_function size_t RandomRange(unsigned long long *state, size_t low, size_t high)
+{
+    return low + (size_t)(NextRandom(state) % (high - low + 1));
+}
+
+/**
+ * @brief Build a random file name with the tree constraints. The index is
+ * always part of the name so the names are unique.
+ *
+ * @param spec      pointer to the tree specification
+ * @param state     pointer to the generator state
+ * @param index     index of the file inside the directory
+ * @param name      buffer where the name is stored
+ * @param nameSize  size in characters of the buffer
+ */
+local_function void BuildFileName(const tree_spec_t *spec, unsigned long long *state, size_t index, wchar_t *name, size_t nameSize)
+{
+    local_variable const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789_-.";
+
+    size_t length = RandomRange(state, spec->minName, spec->maxName);
+    size_t i = (size_t)swprintf_s(name, nameSize, L"%zx_", index);
+
+    while (i < length && i + 3 < nameSize)
+    {
+        if (spec->unicode && NextRandom(state) % 3 == 0)
+        {
+            const wchar_t *s = g_UnicodeSyllables[NextRandom(state) % ARRAY_SIZE(g_UnicodeSyllables)];
+            while (*s != L'\0' && i + 1 < nameSize) name[i++] = *s++;
+        }
+        else
+        {
+            name[i++] = (wchar_t)alphabet[NextRandom(state) % (ARRAY_SIZE(alphabet) - 1)];
+        }
+    }
+
+    // NOTE(Andrei): Windows removes the trailing dots of the names.
+    if (name[i - 1] == L'.') name[i - 1] = L'_';
+    name[i] = L'\0';
+}
+
+/**
+ * @brief Create a file with a random size.
+ *
+ * @param path      full path of the file
+ * @param state     pointer to the generator state
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+local_function BOOL CreateBenchFile(const wchar_t *path, unsigned long long *state)
+{
+    HANDLE h = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return FALSE;
+
+    LARGE_INTEGER size = { 0 };
+    size.QuadPart = (LONGLONG)RandomRange(state, 0, MAX_BENCH_FILE_SIZE);
+
+    BOOL oK = SetFilePointerEx(h, size, NULL, FILE_BEGIN) && SetEndOfFile(h);
+    CloseHandle(h);
+
+    return oK;
+}
+
+/**
+ * @brief Populate a directory with its files and create the sub-directories
+ * recursively until the tree depth is reached.
+ *
+ * @param spec      pointer to the tree specification
+ * @param state     pointer to the generator state
+ * @param path      buffer with the directory path, it is extended in-place
+ * @param level     current level of the tree
+ * @param dirs      number of sub-directories per directory (scaled)
+ * @param files     number of files per directory (scaled)
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+local_function BOOL PopulateDirectory(const tree_spec_t *spec, unsigned long long *state, wchar_t *path, size_t level, size_t dirs, size_t files)
+{
+    wchar_t name[MAX_PATH] = { 0 };
+    size_t length = wcslen(path);
+
+    for (size_t i = 0; i < files; ++i)
+    {
+        BuildFileName(spec, state, i, name, MAX_PATH);
+        swprintf_s(path + length, MAX_BENCH_PATH - length, L"\\%s", name);
+
+        if (!CreateBenchFile(path, state)) return FALSE;
+    }
+
+    for (size_t i = 0; i < dirs && level < spec->depth; ++i)
+    {
+        swprintf_s(path + length, MAX_BENCH_PATH - length, L"\\d%02zu", i);
+
+        if (!CreateDirectoryW(path, NULL)) return FALSE;
+        if (!PopulateDirectory(spec, state, path, level + 1, dirs, files)) return FALSE;
+    }
+
+    path[length] = L'\0';
+    return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BOOL GenerateBenchTrees(const char *root, double scale, unsigned long long seed)
+{
+    wchar_t path[MAX_BENCH_PATH] = { 0 };
+    CreateDirectoryA(root, NULL);
+
+    for (size_t i = 0; i < g_NumBenchTrees; ++i)
+    {
+        const tree_spec_t *spec = &g_BenchTrees[i];
+        unsigned long long state = seed ? seed + i : 0x9E3779B97F4A7C15ULL + i;
+
+        size_t dirs = spec->dirs > 1 ? (size_t)(spec->dirs * scale + 0.5) : spec->dirs;
+        size_t files = (size_t)(spec->files * scale + 0.5);
+
+        swprintf_s(path, MAX_BENCH_PATH, L"%S\\%S", root, spec->name);
+        printf_s("Generating %-8s (%zu levels, %zu dirs, %zu files per dir)\n", spec->name, spec->depth, dirs, files);
+
+        if (!CreateDirectoryW(path, NULL) || !PopulateDirectory(spec, &state, path, 0, dirs, files))
+        {
+            printf_s("Can not generate \"%s\\%s\", does it already exist?\n", root, spec->name);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Shape of the generated trees, each one is created in its own
+ * directory inside the benchmark root.
+ *
+ * 'name'       : name of the tree directory
+ * 'depth'      : number of nested directory levels
+ * 'dirs'       : number of directories on each level
+ * 'files'      : number of files inside each directory
+ * 'minName'    : minimum length of the file names
+ * 'maxName'    : maximum length of the file names
+ * 'unicode'    : use non ASCII characters on the file names
+ */
+typedef struct tree_spec_t
+{
+    const char *name;
+
+    size_t depth, dirs, files;
+    size_t minName, maxName;
+
+    BOOL unicode;
+} tree_spec_t;
+
+/**
+ * @brief Trees used by the benchmark: flat million-entry directory, deep
+ * narrow tree, wide shallow tree, mixed name lengths and Unicode names.
+ * The number of directories and files is multiplied by the scale.
+ */
+extern const tree_spec_t g_BenchTrees[];
+
+/**
+ * @brief Number of trees in 'g_BenchTrees'.
+ */
+extern const size_t g_NumBenchTrees;
+
+/**
+ * @brief Generate all the benchmark trees. The same seed and scale always
+ * produce the same trees (names, sizes and layout).
+ *
+ * @param root      directory where the trees are generated
+ * @param scale     multiplier of the number of directories and files
+ * @param seed      seed of the pseudo random generator
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+BOOL GenerateBenchTrees(const char *root, double scale, unsigned long long seed);
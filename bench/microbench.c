@@ -0,0 +1,429 @@
+#include "arena.h"
+#include "datetime.h"
+#include "directory.h"
+#include "format.h"
+#include "screen.h"
+#include "sort.h"
+#include "types.h"
+#include "utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_MICROBENCH_ITERATIONS 1000  // maximum number of measured iterations per kernel
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief In-memory data used by the kernels, nothing touches the disk.
+ *
+ * 'assets'     : directory with the generated assets, never modified
+ * 'work'       : copy of the assets the kernels can modify (sort)
+ * 'fd'         : Win32 find data of each asset (timestamps)
+ * 'strings'    : arena with the names of the assets
+ * 'scratch'    : arena of the temporary memory of the kernels (layout)
+ * 'arguments'  : arguments used by the kernels that need them
+ * 'width'      : screen width used by the grid layout
+ * 'sink'       : keeps the results alive so they are not optimized out
+ */
+typedef struct fixture_t
+{
+    directory_t *assets, *work;
+    WIN32_FIND_DATAA *fd;
+    arena_t strings, scratch;
+
+    arguments_t arguments;
+    size_t width;
+
+    volatile size_t sink;
+} fixture_t;
+
+/**
+ * @brief Kernel to measure.
+ *
+ * 'name'       : name shown on the report
+ * 'prepare'    : untimed work done before each run, can be NULL
+ * 'run'        : timed work, processes all the assets of the fixture
+ */
+typedef struct kernel_t
+{
+    const char *name;
+    void (*prepare)(fixture_t *fixture);
+    void (*run)(fixture_t *fixture);
+} kernel_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Next number of the xorshift64* pseudo random generator.
+ *
+ * @param state                 pointer to the generator state (not zero)
+ * @return unsigned long long   random number
+ */
+local_function unsigned long long NextRandom(unsigned long long *state)
+{
+    unsigned long long x = *state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Fill the fixture with random assets: names with the known extensions,
+ * sizes from bytes to terabytes, timestamps of the last two years and a few
+ * owners and groups.
+ *
+ * @param fixture   pointer to the fixture
+ * @param entries   number of assets
+ * @param seed      seed of the pseudo random generator
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+local_function BOOL CreateFixture(fixture_t *fixture, size_t entries, unsigned long long seed)
+{
+    local_variable const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789_-";
+    local_variable const char *owners[] = { "Andrei", "Administrator", "SYSTEM", "TrustedInstaller" };
+    local_variable const char *domains[] = { "DESKTOP-01", "BUILTIN", "NT AUTHORITY", "NT SERVICE" };
+
+    // NOTE(Andrei): A year has 365.25 * 24 * 3600 seconds of 10^7 FILETIME ticks.
+    const unsigned long long twoYears = 2ULL * 31557600ULL * 10000000ULL;
+    unsigned long long state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+
+    FILETIME now = { 0 };
+    GetSystemTimeAsFileTime(&now);
+    unsigned long long nowTicks = ((unsigned long long)now.dwHighDateTime << 32) | now.dwLowDateTime;
+
+    size_t bytes = sizeof(directory_t) + sizeof(asset_t) * entries;
+    fixture->assets = (directory_t *)calloc(1, bytes);
+    fixture->work = (directory_t *)calloc(1, bytes);
+    fixture->fd = (WIN32_FIND_DATAA *)calloc(entries, sizeof(WIN32_FIND_DATAA));
+
+    if (fixture->assets == NULL || fixture->work == NULL || fixture->fd == NULL)
+    {
+        return FALSE;
+    }
+
+    fixture->assets->size = fixture->assets->capacity = entries;
+    fixture->work->size = fixture->work->capacity = entries;
+    fixture->assets->arena = fixture->work->arena = &fixture->scratch;
+
+    for (size_t i = 0; i < entries; ++i)
+    {
+        asset_t *asset = &fixture->assets->data[i];
+        WIN32_FIND_DATAA *fd = &fixture->fd[i];
+        char name[MAX_PATH] = { 0 };
+
+        size_t length = 1 + (size_t)(NextRandom(&state) % 32);
+        for (size_t j = 0; j < length; ++j)
+        {
+            name[j] = alphabet[NextRandom(&state) % (ARRAY_SIZE(alphabet) - 1)];
+        }
+
+        asset->type.directory = NextRandom(&state) % 8 == 0;
+        asset->type.document = !asset->type.directory;
+        asset->type.hidden = NextRandom(&state) % 16 == 0;
+
+        if (asset->type.document)
+        {
+            const char *ext = g_AssetExtensionMetaData[NextRandom(&state) % ARRAY_SIZE(g_AssetExtensionMetaData)].ext;
+            strcat_s(name, MAX_PATH, ext);
+
+            // NOTE(Andrei): Exponent up to 2^40 so all the size units are used.
+            asset->size = (size_t)(NextRandom(&state) % (1ULL << (NextRandom(&state) % 41)));
+        }
+
+        asset->name = asset->path = PushArenaString(&fixture->strings, name);
+        if (asset->name == NULL) return FALSE;
+
+        strcpy_s(asset->owner, OWNER_SIZE, owners[NextRandom(&state) % ARRAY_SIZE(owners)]);
+        strcpy_s(asset->domain, DOMAIN_SIZE, domains[NextRandom(&state) % ARRAY_SIZE(domains)]);
+
+        unsigned long long times[3] = { 0 };
+        for (size_t j = 0; j < ARRAY_SIZE(times); ++j)
+        {
+            times[j] = nowTicks - NextRandom(&state) % twoYears;
+        }
+
+        fd->ftCreationTime.dwHighDateTime = (DWORD)(times[0] >> 32); fd->ftCreationTime.dwLowDateTime = (DWORD)times[0];
+        fd->ftLastAccessTime.dwHighDateTime = (DWORD)(times[1] >> 32); fd->ftLastAccessTime.dwLowDateTime = (DWORD)times[1];
+        fd->ftLastWriteTime.dwHighDateTime = (DWORD)(times[2] >> 32); fd->ftLastWriteTime.dwLowDateTime = (DWORD)times[2];
+
+        GetTimestaps(fd, asset);
+        asset->metadata = GetAssetMetadata(asset);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Release the memory of the fixture.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void DeleteFixture(fixture_t *fixture)
+{
+    CHECK_DELETE(fixture->assets);
+    CHECK_DELETE(fixture->work);
+    CHECK_DELETE(fixture->fd);
+
+    DeleteArena(&fixture->strings);
+    DeleteArena(&fixture->scratch);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Restore the unsorted assets on the working copy.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void PrepareSort(fixture_t *fixture)
+{
+    memcpy(fixture->work->data, fixture->assets->data, sizeof(asset_t) * fixture->assets->size);
+}
+
+local_function void RunSortByDirectoryFirst(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderByDirectoryFirst); }
+local_function void RunSortByName(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderByName); }
+local_function void RunSortByGroup(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderByGroup); }
+local_function void RunSortByOwner(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderByOwner); }
+local_function void RunSortBySize(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderBySize); }
+local_function void RunSortByCreation(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderByCreationTimestamp); }
+local_function void RunSortByAccess(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderByAccessedTimestamp); }
+local_function void RunSortByModification(fixture_t *f) { qsort(f->work->data, f->work->size, sizeof(asset_t), OrderByModifiedTimestamp); }
+
+/**
+ * @brief Look up the icon and color of each asset.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void RunMetadata(fixture_t *fixture)
+{
+    for (size_t i = 0; i < fixture->assets->size; ++i)
+    {
+        fixture->sink += (size_t)GetAssetMetadata(&fixture->assets->data[i]);
+    }
+}
+
+/**
+ * @brief Release the temporary memory of the previous layout.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void PrepareColumns(fixture_t *fixture)
+{
+    ResetArena(&fixture->scratch);
+}
+
+/**
+ * @brief Compute the grid layout of all the assets with icons.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void RunColumns(fixture_t *fixture)
+{
+    row_t row = GetNumberOfColumns(fixture->assets, TRUE, 3, fixture->width);
+    fixture->sink += row.size;
+}
+
+/**
+ * @brief Format the size of each asset.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void RunSizeText(fixture_t *fixture)
+{
+    char size[SIZE_TEXT_SIZE];
+
+    for (size_t i = 0; i < fixture->assets->size; ++i)
+    {
+        fixture->sink += FormatSize(fixture->assets->data[i].size, fixture->arguments.sizeFormat, size, SIZE_TEXT_SIZE);
+    }
+}
+
+/**
+ * @brief Convert and format the timestamps of each asset.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void RunTimestamps(fixture_t *fixture)
+{
+    char date[DATE_SIZE];
+
+    for (size_t i = 0; i < fixture->work->size; ++i)
+    {
+        GetTimestaps(&fixture->fd[i], &fixture->work->data[i]);
+        fixture->sink += FormatDateTime(fixture->work->data[i].timestamp.creation, date, DATE_SIZE);
+    }
+}
+
+/**
+ * @brief Print the names with the console attributes, or without them if the
+ * colors are disabled.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void RunPrint(fixture_t *fixture)
+{
+    for (size_t i = 0; i < fixture->assets->size; ++i)
+    {
+        color_printf(WHITE, "%s  ", fixture->assets->data[i].name);
+    }
+}
+
+/**
+ * @brief Print the names with the virtual terminal colors of the metadata.
+ *
+ * @param fixture   pointer to the fixture
+ */
+local_function void RunPrintVirtualTerminal(fixture_t *fixture)
+{
+    for (size_t i = 0; i < fixture->assets->size; ++i)
+    {
+        const asset_t *asset = &fixture->assets->data[i];
+        color_printf_vt(asset->metadata->r, asset->metadata->g, asset->metadata->b, "%s  ", asset->name);
+    }
+}
+
+local_function void PrepareColorOff(fixture_t *fixture) { SetColorOutput(FALSE); }
+local_function void PrepareColorOn(fixture_t *fixture) { SetColorOutput(TRUE); }
+
+///////////////////////////////////////////////////////////////////////////////
+
+global_variable const kernel_t g_Kernels[] =
+{
+    { "sort/dirs-first",    PrepareSort,        RunSortByDirectoryFirst },
+    { "sort/name",          PrepareSort,        RunSortByName           },
+    { "sort/group",         PrepareSort,        RunSortByGroup          },
+    { "sort/owner",         PrepareSort,        RunSortByOwner          },
+    { "sort/size",          PrepareSort,        RunSortBySize           },
+    { "sort/ctime",         PrepareSort,        RunSortByCreation       },
+    { "sort/atime",         PrepareSort,        RunSortByAccess         },
+    { "sort/mtime",         PrepareSort,        RunSortByModification   },
+    { "metadata",           NULL,               RunMetadata             },
+    { "columns",            PrepareColumns,     RunColumns              },
+    { "size-text",          NULL,               RunSizeText             },
+    { "timestamps",         NULL,               RunTimestamps           },
+    { "print/plain",        PrepareColorOff,    RunPrint                },
+    { "print/console",      PrepareColorOn,     RunPrint                },
+    { "print/plain-vt",     PrepareColorOff,    RunPrintVirtualTerminal },
+    { "print/vt",           PrepareColorOn,     RunPrintVirtualTerminal },
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Run a kernel several times, the first run warms up the caches and
+ * it is not measured.
+ *
+ * @param kernel        pointer to the kernel
+ * @param fixture       pointer to the fixture
+ * @param iterations    number of measured runs
+ * @return double       fastest run in nanoseconds per asset
+ */
+local_function double RunKernel(const kernel_t *kernel, fixture_t *fixture, size_t iterations)
+{
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+
+    double best = 0.0;
+
+    for (size_t i = 0; i <= iterations; ++i)
+    {
+        if (kernel->prepare != NULL) kernel->prepare(fixture);
+
+        QueryPerformanceCounter(&start);
+        kernel->run(fixture);
+        QueryPerformanceCounter(&end);
+
+        double ns = (double)(end.QuadPart - start.QuadPart) * 1e9 / (double)frequency.QuadPart;
+        if (i == 1 || (i > 1 && ns < best)) best = ns;
+    }
+
+    return best / (double)fixture->assets->size;
+}
+
+/**
+ * @brief Prints the help of the microbenchmark to the screen.
+ */
+local_function void ShowMicrobenchHelp()
+{
+    const char *help =
+        "Usage\n"
+        "  ls_microbench [options] > NUL\n\n"
+
+        "OPTIONS\n"
+        "      --entries [N]                number of assets of the fixture (default 10000)\n"
+        "      --iterations [N]             number of measured runs per kernel (default 20)\n"
+        "      --seed [N]                   seed of the random assets (default 0)\n"
+        "      --width [N]                  screen width used by the grid layout (default 120)\n"
+        "      --kernel [NAME]              only run the kernels starting with the name\n\n"
+
+        "The report is written to stderr, the output of the print kernels to stdout.\n";
+
+    fprintf(stderr, "%s", help);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    fixture_t fixture = { 0 };
+    fixture.width = 120;
+    fixture.arguments.sortField = SORT_BY_NAME;
+
+    size_t entries = 10000, iterations = 20;
+    unsigned long long seed = 0;
+    const char *only = NULL;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+        {
+            ShowMicrobenchHelp();
+            return EXIT_FAILURE;
+        }
+
+        if (strcmp(argv[i], "--entries") == 0) entries = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--iterations") == 0) iterations = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--width") == 0) fixture.width = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--kernel") == 0) only = argv[i + 1];
+        else
+        {
+            ShowMicrobenchHelp();
+            return EXIT_FAILURE;
+        }
+    }
+
+    entries = entries < 1 ? 1 : entries;
+    iterations = iterations < 1 ? 1 : iterations > MAX_MICROBENCH_ITERATIONS ? MAX_MICROBENCH_ITERATIONS : iterations;
+
+    InitializeDateTime(NULL);
+
+    if (!CreateFixture(&fixture, entries, seed))
+    {
+        fprintf(stderr, "Not enough memory for %zu entries\n", entries);
+        DeleteFixture(&fixture);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "%-16s  %12s\n", "kernel", "ns/entry");
+
+    for (size_t i = 0; i < ARRAY_SIZE(g_Kernels); ++i)
+    {
+        if (only != NULL && strncmp(g_Kernels[i].name, only, strlen(only)) != 0)
+        {
+            continue;
+        }
+
+        double ns = RunKernel(&g_Kernels[i], &fixture, iterations);
+        fprintf(stderr, "%-16s  %12.2lf\n", g_Kernels[i].name, ns);
+    }
+
+    DeleteFixture(&fixture);
+    return EXIT_SUCCESS;
+}
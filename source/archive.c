@@ -0,0 +1,694 @@
+#include "archive.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "glob.h"
+#include "win32.h"
+
+#define ZIP_END_SIGNATURE           0x06054b50  // end of central directory record
+#define ZIP64_LOCATOR_SIGNATURE     0x07064b50  // zip64 end of central directory locator
+#define ZIP64_END_SIGNATURE         0x06064b50  // zip64 end of central directory record
+#define ZIP_CENTRAL_SIGNATURE       0x02014b50  // central directory file header
+
+#define ZIP_END_SIZE        22      // end record without the comment
+#define ZIP_MAX_COMMENT     65535   // maximum size of the archive comment
+#define ZIP64_LOCATOR_SIZE  20
+#define ZIP64_END_SIZE      56
+#define ZIP_CENTRAL_SIZE    46      // file header without name, extra field and comment
+
+#define TAR_BLOCK_SIZE      512
+#define TAR_MAX_NAME        1024    // longest member path kept from the long name records
+
+// FILETIME ticks between 01 Jan 1601 and 01 Jan 1970
+#define UNIX_EPOCH_TICKS    116444736000000000ULL
+
+/**
+ * @brief State while the members of an archive are read.
+ *
+ * 'directory'      : directory where the entries are added
+ * 'prefix'         : directory inside the archive with '/' delimiters, empty for the root
+ * 'filter'         : wild card pattern of the names, empty for all of them
+ * 'archiveTime'    : modification time of the archive, used for the implicit directories
+ *
+ * 'found'          : the directory exists inside the archive
+ * 'document'       : the member named by the prefix if it is a document
+ * 'hasDocument'    : 'document' is valid
+ */
+typedef struct archive_scan_t
+{
+    archive_directory_t *directory;
+
+    char prefix[MAX_PATH];
+    size_t prefixLength;
+    char filter[MAX_PATH];
+    FILETIME archiveTime;
+
+    BOOL found;
+    archive_entry_t document;
+    BOOL hasDocument;
+} archive_scan_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Read a little endian 16 bit value.
+ *
+ * @param p         pointer to the bytes
+ * @return WORD     the value
+ */
+local_function WORD ReadLittleEndian16(const unsigned char *p)
+{
+    return (WORD)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Read a little endian 32 bit value.
+ *
+ * @param p         pointer to the bytes
+ * @return DWORD    the value
+ */
+local_function DWORD ReadLittleEndian32(const unsigned char *p)
+{
+    return (DWORD)p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24);
+}
+
+/**
+ * @brief Read a little endian 64 bit value.
+ *
+ * @param p                     pointer to the bytes
+ * @return unsigned long long   the value
+ */
+local_function unsigned long long ReadLittleEndian64(const unsigned char *p)
+{
+    return (unsigned long long)ReadLittleEndian32(p) | ((unsigned long long)ReadLittleEndian32(p + 4) << 32);
+}
+
+/**
+ * @brief Convert the seconds since 1970 to a FILETIME.
+ *
+ * @param seconds       seconds since 01 Jan 1970 (UTC)
+ * @return FILETIME     the same time as a FILETIME
+ */
+local_function FILETIME UnixTimeToFileTime(unsigned long long seconds)
+{
+    unsigned long long ticks = seconds * 10000000ULL + UNIX_EPOCH_TICKS;
+    FILETIME ft = { (DWORD)ticks, (DWORD)(ticks >> 32) };
+
+    return ft;
+}
+
+/**
+ * @brief Compare two entries by name.
+ *
+ * @param a     pointer to the first entry
+ * @param b     pointer to the second entry
+ * @return int  negative if 'a' goes first, positive if 'b' goes first, 0 otherwise
+ */
+local_function int CompareArchiveEntry(const void *a, const void *b)
+{
+    return strcmp(((const archive_entry_t *)a)->name, ((const archive_entry_t *)b)->name);
+}
+
+/**
+ * @brief Map a range of the archive, the view starts at the allocation
+ * granularity before the range.
+ *
+ * @param hMapping                  mapping of the archive
+ * @param offset                    first byte of the range
+ * @param size                      number of bytes of the range
+ * @param view                      pointer where the view is stored (release with UnmapViewOfFile)
+ * @return const unsigned char*     first byte of the range or NULL on error
+ */
+local_function const unsigned char *MapArchiveRange(HANDLE hMapping, unsigned long long offset, size_t size, void **view)
+{
+    SYSTEM_INFO info = { 0 };
+    GetSystemInfo(&info);
+
+    unsigned long long start = offset - offset % info.dwAllocationGranularity;
+    *view = MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)start, (SIZE_T)(offset - start + size));
+
+    return *view != NULL ? (const unsigned char *)*view + (offset - start) : NULL;
+}
+
+/**
+ * @brief Add a member of the archive to the directory if it is inside it. The
+ * members deeper in the tree add their first segment as a directory.
+ *
+ * @param scan          state of the read
+ * @param name          path of the member inside the archive (not terminated)
+ * @param length        length of the path
+ * @param size          uncompressed size of the member
+ * @param modification  modification time of the member
+ * @param attributes    Win32 attributes of the member
+ */
+local_function void AddArchiveMember(archive_scan_t *scan, const char *name, size_t length, unsigned long long size, FILETIME modification, DWORD attributes)
+{
+    char path[TAR_MAX_NAME];
+    archive_directory_t *directory = scan->directory;
+
+    if (length >= sizeof(path)) return;
+
+    memcpy(path, name, length);
+    path[length] = '\0';
+
+    for (char *c = path; *c != '\0'; ++c) if (*c == '\\') *c = '/';
+
+    // NOTE(Andrei): Some tools store "./dir/file" or absolute paths.
+    char *member = path;
+    while (member[0] == '/' || (member[0] == '.' && member[1] == '/')) member += member[0] == '/' ? 1 : 2;
+
+    length = strlen(member);
+
+    if (length > 0 && member[length - 1] == '/')
+    {
+        attributes = FILE_ATTRIBUTE_DIRECTORY;
+        member[--length] = '\0';
+    }
+
+    if (length == 0) return;
+
+    if (scan->prefixLength > 0)
+    {
+        if (_strnicmp(member, scan->prefix, scan->prefixLength) != 0) return;
+
+        if (member[scan->prefixLength] == '\0')
+        {
+            scan->found = TRUE;
+            if (attributes & FILE_ATTRIBUTE_DIRECTORY) return;
+
+            const char *last = strrchr(member, '/');
+            scan->document.name = PushArenaString(&directory->arena, last ? last + 1 : member);
+            scan->document.size = size;
+            scan->document.modification = modification;
+            scan->document.attributes = attributes;
+            scan->document.explicit = TRUE;
+            scan->hasDocument = scan->document.name != NULL;
+
+            return;
+        }
+
+        if (member[scan->prefixLength] != '/') return;
+        member += scan->prefixLength + 1;
+    }
+
+    scan->found = TRUE;
+
+    // NOTE(Andrei): "sub/file" inside the directory is the implicit
+    //               directory "sub", the archives do not need a record
+    //               for each directory.
+    char *slash = strchr(member, '/');
+    BOOL explicit = slash == NULL;
+
+    if (slash != NULL)
+    {
+        *slash = '\0';
+        attributes = FILE_ATTRIBUTE_DIRECTORY;
+    }
+
+    if (scan->filter[0] != '\0' && !MatchPattern(scan->filter, member)) return;
+
+    // NOTE(Andrei): The members of a directory are usually stored together,
+    //               the repeated implicit directories are skipped here and
+    //               the rest when the entries are sorted.
+    if (!explicit && directory->count > 0 && strcmp(directory->entries[directory->count - 1].name, member) == 0) return;
+
+    if (directory->count == directory->capacity)
+    {
+        size_t newCapacity = directory->capacity ? directory->capacity * 2 : STARTUP_CONTAINER_SIZE;
+        archive_entry_t *entries = realloc(directory->entries, sizeof(archive_entry_t) * newCapacity);
+        if (entries == NULL) return;
+
+        directory->entries = entries;
+        directory->capacity = newCapacity;
+    }
+
+    archive_entry_t *entry = &directory->entries[directory->count];
+    entry->name = PushArenaString(&directory->arena, member);
+    if (entry->name == NULL) return;
+
+    entry->size = explicit && !(attributes & FILE_ATTRIBUTE_DIRECTORY) ? size : 0;
+    entry->modification = explicit ? modification : scan->archiveTime;
+    entry->attributes = attributes;
+    entry->explicit = explicit;
+
+    ++directory->count;
+}
+
+/**
+ * @brief Read the members of a zip archive from its central directory, only
+ * the end of the archive and the central directory are mapped.
+ *
+ * @param hFile     handle of the archive
+ * @param fileSize  size of the archive
+ * @param scan      state of the read
+ * @return BOOL     TRUE if it is a valid zip archive, FALSE otherwise
+ */
+local_function BOOL ReadZipDirectory(HANDLE hFile, unsigned long long fileSize, archive_scan_t *scan)
+{
+    HANDLE hMapping = NULL;
+    void *tailView = NULL, *view = NULL;
+    BOOL retValue = FALSE;
+
+    if (fileSize < ZIP_END_SIZE) return FALSE;
+
+    hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping == NULL) goto clean_up;
+
+    // NOTE(Andrei): The end record is followed by a comment of up to 64 KB,
+    //               it is searched backwards from the end.
+    size_t tailSize = (size_t)(fileSize < ZIP_END_SIZE + ZIP_MAX_COMMENT + ZIP64_LOCATOR_SIZE ? fileSize : ZIP_END_SIZE + ZIP_MAX_COMMENT + ZIP64_LOCATOR_SIZE);
+    unsigned long long tailOffset = fileSize - tailSize;
+
+    const unsigned char *tail = MapArchiveRange(hMapping, tailOffset, tailSize, &tailView);
+    if (tail == NULL) goto clean_up;
+
+    const unsigned char *end = NULL;
+
+    for (size_t i = tailSize - ZIP_END_SIZE + 1; i-- > 0;)
+    {
+        if (ReadLittleEndian32(tail + i) == ZIP_END_SIGNATURE)
+        {
+            end = tail + i;
+            break;
+        }
+    }
+
+    if (end == NULL) goto clean_up;
+
+    unsigned long long numEntries = ReadLittleEndian16(end + 10);
+    unsigned long long directorySize = ReadLittleEndian32(end + 12);
+    unsigned long long directoryOffset = ReadLittleEndian32(end + 16);
+
+    // NOTE(Andrei): The archives with more than 65535 members or bigger
+    //               than 4 GB keep the real values on the zip64 record.
+    if ((numEntries == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) && end - tail >= ZIP64_LOCATOR_SIZE)
+    {
+        const unsigned char *locator = end - ZIP64_LOCATOR_SIZE;
+        if (ReadLittleEndian32(locator) != ZIP64_LOCATOR_SIGNATURE) goto clean_up;
+
+        unsigned long long recordOffset = ReadLittleEndian64(locator + 8);
+        if (recordOffset + ZIP64_END_SIZE > fileSize) goto clean_up;
+
+        const unsigned char *record = MapArchiveRange(hMapping, recordOffset, ZIP64_END_SIZE, &view);
+        if (record == NULL || ReadLittleEndian32(record) != ZIP64_END_SIGNATURE) goto clean_up;
+
+        numEntries = ReadLittleEndian64(record + 32);
+        directorySize = ReadLittleEndian64(record + 40);
+        directoryOffset = ReadLittleEndian64(record + 48);
+
+        UnmapViewOfFile(view);
+        view = NULL;
+    }
+
+    if (directoryOffset + directorySize > fileSize) goto clean_up;
+    retValue = TRUE;
+
+    if (directorySize == 0) goto clean_up;
+
+    const unsigned char *p = MapArchiveRange(hMapping, directoryOffset, (size_t)directorySize, &view);
+    if (p == NULL) { retValue = FALSE; goto clean_up; }
+
+    const unsigned char *last = p + directorySize;
+
+    for (unsigned long long i = 0; i < numEntries && last - p >= ZIP_CENTRAL_SIZE; ++i)
+    {
+        if (ReadLittleEndian32(p) != ZIP_CENTRAL_SIGNATURE) break;
+
+        WORD madeBy = ReadLittleEndian16(p + 4);
+        WORD method = ReadLittleEndian16(p + 10);
+        unsigned long long size = ReadLittleEndian32(p + 24);
+        size_t nameLength = ReadLittleEndian16(p + 28);
+        size_t extraLength = ReadLittleEndian16(p + 30);
+        size_t commentLength = ReadLittleEndian16(p + 32);
+        DWORD external = ReadLittleEndian32(p + 38);
+
+        const char *name = (const char *)p + ZIP_CENTRAL_SIZE;
+        const unsigned char *extra = p + ZIP_CENTRAL_SIZE + nameLength;
+        if ((size_t)(last - p) < ZIP_CENTRAL_SIZE + nameLength + extraLength + commentLength) break;
+
+        // NOTE(Andrei): The DOS time is local time, the extended timestamp
+        //               field (if any) has the UTC time.
+        FILETIME local = { 0 }, modification = { 0 };
+        DosDateTimeToFileTime(ReadLittleEndian16(p + 14), ReadLittleEndian16(p + 12), &local);
+        LocalFileTimeToFileTime(&local, &modification);
+
+        for (const unsigned char *e = extra; e + 4 <= extra + extraLength;)
+        {
+            WORD id = ReadLittleEndian16(e);
+            WORD length = ReadLittleEndian16(e + 2);
+            const unsigned char *data = e + 4;
+
+            if (data + length > extra + extraLength) break;
+
+            if (id == 0x0001 && size == 0xFFFFFFFF && length >= 8) size = ReadLittleEndian64(data);
+            else if (id == 0x5455 && length >= 5 && (data[0] & 1)) modification = UnixTimeToFileTime(ReadLittleEndian32(data + 1));
+
+            e = data + length;
+        }
+
+        // NOTE(Andrei): The external attributes are the DOS ones only when
+        //               the archive was made on DOS / Windows (host 0).
+        DWORD attributes = method != 0 ? FILE_ATTRIBUTE_COMPRESSED : FILE_ATTRIBUTE_NORMAL;
+        if ((madeBy >> 8) == 0 && (external & FILE_ATTRIBUTE_DIRECTORY)) attributes = FILE_ATTRIBUTE_DIRECTORY;
+
+        AddArchiveMember(scan, name, nameLength, size, modification, attributes);
+        p += ZIP_CENTRAL_SIZE + nameLength + extraLength + commentLength;
+    }
+
+clean_up:
+    if (view != NULL) UnmapViewOfFile(view);
+    if (tailView != NULL) UnmapViewOfFile(tailView);
+    if (hMapping != NULL) CloseHandle(hMapping);
+
+    return retValue;
+}
+
+/**
+ * @brief Read a numeric field of a tar header, octal text or base-256 for
+ * the values that do not fit.
+ *
+ * @param field                 bytes of the field
+ * @param size                  size of the field
+ * @return unsigned long long   the value
+ */
+local_function unsigned long long ReadTarNumber(const unsigned char *field, size_t size)
+{
+    unsigned long long value = 0;
+
+    if (field[0] & 0x80)
+    {
+        value = field[0] & 0x3F;
+        for (size_t i = 1; i < size; ++i) value = (value << 8) | field[i];
+
+        return value;
+    }
+
+    size_t i = 0;
+    while (i < size && (field[i] == ' ' || field[i] == '\0')) ++i;
+    while (i < size && field[i] >= '0' && field[i] <= '7') value = value * 8 + (field[i++] - '0');
+
+    return value;
+}
+
+/**
+ * @brief Check the checksum of a tar header, the sum of its bytes with the
+ * checksum field as spaces. Old archives used signed bytes.
+ *
+ * @param header    bytes of the header
+ * @return BOOL     TRUE if it is a valid header, FALSE otherwise
+ */
+local_function BOOL IsTarHeader(const unsigned char *header)
+{
+    unsigned long long expected = ReadTarNumber(header + 148, 8);
+    long long sum = 0, signedSum = 0;
+
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; ++i)
+    {
+        unsigned char c = i >= 148 && i < 156 ? ' ' : header[i];
+        sum += c;
+        signedSum += (signed char)c;
+    }
+
+    return (unsigned long long)sum == expected || (unsigned long long)signedSum == expected;
+}
+
+/**
+ * @brief Read bytes of the archive at an offset.
+ *
+ * @param hFile     handle of the archive
+ * @param offset    first byte to read
+ * @param buffer    buffer where the bytes are stored
+ * @param size      number of bytes to read
+ * @return BOOL     TRUE if all the bytes are read, FALSE otherwise
+ */
+local_function BOOL ReadArchiveBytes(HANDLE hFile, unsigned long long offset, void *buffer, DWORD size)
+{
+    LARGE_INTEGER position = { 0 };
+    DWORD read = 0;
+
+    position.QuadPart = (LONGLONG)offset;
+    if (!SetFilePointerEx(hFile, position, NULL, FILE_BEGIN)) return FALSE;
+
+    return ReadFile(hFile, buffer, size, &read, NULL) && read == size;
+}
+
+/**
+ * @brief Read the members of an uncompressed tar archive. Only the headers
+ * are read, the content of the members is skipped seeking over it. GNU long
+ * names and the path, size and mtime of pax headers are supported.
+ *
+ * @param hFile     handle of the archive
+ * @param fileSize  size of the archive
+ * @param scan      state of the read
+ * @return BOOL     TRUE if it is a valid tar archive, FALSE otherwise
+ */
+local_function BOOL ReadTarHeaders(HANDLE hFile, unsigned long long fileSize, archive_scan_t *scan)
+{
+    unsigned char header[TAR_BLOCK_SIZE];
+    char longName[TAR_MAX_NAME] = { 0 };
+    char extended[TAR_MAX_NAME * 2];
+
+    unsigned long long offset = 0, paxSize = 0, paxTime = 0;
+    BOOL hasPaxSize = FALSE, hasPaxTime = FALSE;
+
+    for (size_t numHeaders = 0; offset + TAR_BLOCK_SIZE <= fileSize; ++numHeaders)
+    {
+        if (!ReadArchiveBytes(hFile, offset, header, TAR_BLOCK_SIZE)) return numHeaders > 0;
+
+        // NOTE(Andrei): The archive ends with two blocks of zeros.
+        if (header[0] == '\0') return TRUE;
+        if (!IsTarHeader(header)) return numHeaders > 0;
+
+        unsigned long long size = ReadTarNumber(header + 124, 12);
+        unsigned long long seconds = hasPaxTime ? paxTime : ReadTarNumber(header + 136, 12);
+        char type = (char)header[156];
+
+        offset += TAR_BLOCK_SIZE;
+
+        // NOTE(Andrei): The sizes can hold any 64 bit value, a content that
+        //               does not fit in the archive would wrap the offset
+        //               or jump anywhere. A pax size like that is ignored.
+        if (hasPaxSize && paxSize <= fileSize - offset) size = paxSize;
+        if (size > fileSize - offset) return FALSE;
+
+        unsigned long long dataSize = (size + TAR_BLOCK_SIZE - 1) & ~(unsigned long long)(TAR_BLOCK_SIZE - 1);
+        if (dataSize > fileSize - offset) return FALSE;
+
+        if (type == 'L' || type == 'x')
+        {
+            DWORD length = (DWORD)(size < sizeof(extended) - 1 ? size : sizeof(extended) - 1);
+            if (!ReadArchiveBytes(hFile, offset, extended, length)) return FALSE;
+            extended[length] = '\0';
+
+            if (type == 'L')
+            {
+                strncpy_s(longName, sizeof(longName), extended, _TRUNCATE);
+            }
+
+            // NOTE(Andrei): Each pax record is "<length> <key>=<value>\n".
+            for (const char *record = extended; type == 'x' && *record != '\0';)
+            {
+                size_t recordLength = strtoul(record, NULL, 10);
+                const char *key = strchr(record, ' ');
+                if (recordLength == 0 || key == NULL || record + recordLength > extended + length) break;
+
+                ++key;
+                size_t valueLength = (size_t)(record + recordLength - key);
+
+                if (strncmp(key, "path=", 5) == 0 && valueLength > 6)
+                {
+                    size_t nameLength = valueLength - 6 < sizeof(longName) - 1 ? valueLength - 6 : sizeof(longName) - 1;
+                    memcpy(longName, key + 5, nameLength);
+                    longName[nameLength] = '\0';
+                }
+                else if (strncmp(key, "size=", 5) == 0)
+                {
+                    paxSize = strtoull(key + 5, NULL, 10);
+                    hasPaxSize = TRUE;
+                }
+                else if (strncmp(key, "mtime=", 6) == 0)
+                {
+                    paxTime = strtoull(key + 6, NULL, 10);
+                    hasPaxTime = TRUE;
+                }
+
+                record += recordLength;
+            }
+
+            offset += dataSize;
+            continue;
+        }
+
+        if (type != 'K' && type != 'g' && type != 'V')
+        {
+            char name[TAR_MAX_NAME];
+
+            if (longName[0] != '\0')
+            {
+                strcpy_s(name, sizeof(name), longName);
+            }
+            else if (memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0')
+            {
+                snprintf(name, sizeof(name), "%.155s/%.100s", (const char *)header + 345, (const char *)header);
+            }
+            else
+            {
+                snprintf(name, sizeof(name), "%.100s", (const char *)header);
+            }
+
+            DWORD attributes = type == '5' ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+            AddArchiveMember(scan, name, strlen(name), type == '5' ? 0 : size, UnixTimeToFileTime(seconds), attributes);
+
+            longName[0] = '\0';
+            hasPaxSize = hasPaxTime = FALSE;
+        }
+
+        // NOTE(Andrei): Only regular files, directories and the records above
+        //               have content, the size of the links is their target.
+        if (type == '0' || type == '\0' || type == '7' || type == 'K' || type == 'g' || type == 'V' || (type >= 'A' && type <= 'Z'))
+        {
+            offset += dataSize;
+        }
+    }
+
+    return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BOOL SplitArchivePath(const char *path, char *archive, size_t archiveSize, const char **inner)
+{
+    for (const char *c = path; *c != '\0'; ++c)
+    {
+        if (*c != '\\' && *c != '/') continue;
+
+        size_t length = (size_t)(c - path);
+        if (length < 4 || length >= archiveSize) continue;
+        if (_strnicmp(c - 4, ".zip", 4) != 0 && _strnicmp(c - 4, ".tar", 4) != 0) continue;
+
+        memcpy(archive, path, length);
+        archive[length] = '\0';
+
+        if (!IsValidDocument(archive)) continue;
+
+        while (*c == '\\' || *c == '/') ++c;
+        *inner = c;
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+BOOL OpenArchiveDirectory(archive_directory_t *directory, const char *archive, const char *inner)
+{
+    archive_scan_t scan = { 0 };
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    BOOL retValue = FALSE;
+
+    memset(directory, 0, sizeof(archive_directory_t));
+    scan.directory = directory;
+
+    // NOTE(Andrei): The members use '/', a wild card last segment is
+    //               applied to the names of the directory.
+    strcpy_s(scan.prefix, MAX_PATH, inner);
+    for (char *c = scan.prefix; *c != '\0'; ++c) if (*c == '\\') *c = '/';
+
+    size_t length = strlen(scan.prefix);
+    while (length > 0 && scan.prefix[length - 1] == '/') scan.prefix[--length] = '\0';
+
+    char *last = strrchr(scan.prefix, '/');
+    char *segment = last ? last + 1 : scan.prefix;
+
+    if (HasWildcards(segment))
+    {
+        strcpy_s(scan.filter, MAX_PATH, segment);
+        *segment = '\0';
+        if (last != NULL) *last = '\0';
+    }
+
+    scan.prefixLength = strlen(scan.prefix);
+    scan.found = scan.prefixLength == 0;
+
+    hFile = CreateFileA(archive, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) goto clean_up;
+
+    LARGE_INTEGER fileSize = { 0 };
+    if (!GetFileSizeEx(hFile, &fileSize)) goto clean_up;
+
+    GetFileTime(hFile, NULL, NULL, &scan.archiveTime);
+
+    length = strlen(archive);
+    BOOL isZip = length >= 4 && _stricmp(archive + length - 4, ".zip") == 0;
+
+    if (isZip && !ReadZipDirectory(hFile, (unsigned long long)fileSize.QuadPart, &scan)) goto clean_up;
+    if (!isZip && !ReadTarHeaders(hFile, (unsigned long long)fileSize.QuadPart, &scan)) goto clean_up;
+
+    if (!scan.found) goto clean_up;
+
+    if (directory->count == 0 && scan.hasDocument && scan.filter[0] == '\0')
+    {
+        directory->entries = malloc(sizeof(archive_entry_t));
+        if (directory->entries == NULL) goto clean_up;
+
+        directory->entries[0] = scan.document;
+        directory->count = directory->capacity = 1;
+        directory->document = TRUE;
+    }
+
+    // NOTE(Andrei): Keep one entry per name, the record of a directory
+    //               wins over the paths that imply it.
+    qsort(directory->entries, directory->count, sizeof(archive_entry_t), CompareArchiveEntry);
+    size_t count = 0;
+
+    for (size_t i = 0; i < directory->count; ++i)
+    {
+        if (count > 0 && strcmp(directory->entries[count - 1].name, directory->entries[i].name) == 0)
+        {
+            if (!directory->entries[count - 1].explicit) directory->entries[count - 1] = directory->entries[i];
+            continue;
+        }
+
+        directory->entries[count++] = directory->entries[i];
+    }
+
+    directory->count = count;
+    directory->open = TRUE;
+    retValue = TRUE;
+
+clean_up:
+    if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+    if (!retValue) CloseArchiveDirectory(directory);
+
+    return retValue;
+}
+
+BOOL NextArchiveEntry(archive_directory_t *directory, WIN32_FIND_DATAA *fd)
+{
+    if (directory->next >= directory->count) return FALSE;
+
+    const archive_entry_t *entry = &directory->entries[directory->next++];
+    memset(fd, 0, sizeof(WIN32_FIND_DATAA));
+
+    fd->dwFileAttributes = entry->attributes;
+    fd->ftCreationTime = entry->modification;
+    fd->ftLastAccessTime = entry->modification;
+    fd->ftLastWriteTime = entry->modification;
+    fd->nFileSizeHigh = (DWORD)(entry->size >> 32);
+    fd->nFileSizeLow = (DWORD)entry->size;
+
+    strncpy_s(fd->cFileName, MAX_PATH, entry->name, _TRUNCATE);
+    return TRUE;
+}
+
+void CloseArchiveDirectory(archive_directory_t *directory)
+{
+    CHECK_DELETE(directory->entries);
+    DeleteArena(&directory->arena);
+
+    directory->count = directory->capacity = directory->next = 0;
+    directory->open = directory->document = FALSE;
+}
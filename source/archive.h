@@ -0,0 +1,97 @@
+#pragma once
+
+#include "types.h"
+#include "arena.h"
+
+/**
+ * @brief Member of an archive seen as an asset of a virtual directory.
+ *
+ * 'name'           : name inside its directory (first segment after the directory)
+ * 'size'           : uncompressed size in bytes, 0 for directories
+ * 'modification'   : FILETIME of the last modification
+ * 'attributes'     : Win32 attributes (directory, compressed)
+ * 'explicit'       : the archive has a record for it, the implicit directories
+ *                    only appear in the path of other members
+ */
+typedef struct archive_entry_t
+{
+    const char *name;
+    unsigned long long size;
+
+    FILETIME modification;
+    DWORD attributes;
+    BOOL explicit;
+} archive_entry_t;
+
+/**
+ * @brief Directory inside an archive, see 'OpenArchiveDirectory'.
+ *
+ * 'entries'    : assets of the directory sorted by name
+ * 'count'      : number of entries
+ * 'capacity'   : space available on the 'entries' array
+ * 'next'       : index of the entry returned by the next 'NextArchiveEntry'
+ *
+ * 'arena'      : arena where the names are stored
+ * 'open'       : the directory was found inside the archive
+ * 'document'   : the path names a single document of the archive, not a directory
+ */
+typedef struct archive_directory_t
+{
+    archive_entry_t *entries;
+    size_t count, capacity, next;
+
+    arena_t arena;
+    BOOL open, document;
+} archive_directory_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Split a path that goes through an archive (.zip or .tar) into the
+ * path of the archive and the path inside it. The archive has to be
+ * followed by a delimiter, a path ending with the archive is the archive
+ * document itself.
+ *
+ * ex: "D:\builds\bundle.zip\bin\x64" -> "D:\builds\bundle.zip" and "bin\x64"
+ *
+ * @param path          path given by the user or found while recursing
+ * @param archive       buffer where the path of the archive is stored
+ * @param archiveSize   size in bytes of the archive buffer
+ * @param inner         pointer where the path inside the archive is stored
+ * @return BOOL         TRUE if the path goes through an archive, FALSE otherwise
+ */
+BOOL SplitArchivePath(const char *path, char *archive, size_t archiveSize, const char **inner);
+
+/**
+ * @brief Read the members of an archive that are inside a directory, nothing
+ * is extracted. The zip central directory is read through a file mapping,
+ * the tar headers are read one by one seeking over the content. The sub-
+ * directories that have no record of their own are derived from the paths.
+ *
+ * The last segment of the inner path can have wild cards, only the members
+ * matching it are returned. If the inner path names a document it is the
+ * only member returned.
+ *
+ * @param directory     pointer where the directory is stored
+ * @param archive       path of the archive
+ * @param inner         path inside the archive, empty for the root
+ * @return BOOL         TRUE if the directory is in the archive, FALSE otherwise
+ */
+BOOL OpenArchiveDirectory(archive_directory_t *directory, const char *archive, const char *inner);
+
+/**
+ * @brief Get the next member of the directory as Win32 find data, the same
+ * way 'FindNextFileA' does for the real directories.
+ *
+ * @param directory     pointer to the directory
+ * @param fd            pointer where the member is stored
+ * @return BOOL         TRUE if a member is returned, FALSE at the end
+ */
+BOOL NextArchiveEntry(archive_directory_t *directory, WIN32_FIND_DATAA *fd);
+
+/**
+ * @brief Release the members of the directory.
+ *
+ * @param directory     pointer to the directory
+ */
+void CloseArchiveDirectory(archive_directory_t *directory);
@@ -0,0 +1,114 @@
+#include "arena.h"
+#include "types.h"
+#include "stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)    // minimum number of bytes of a block
+#define ARENA_ALIGNMENT 16              // alignment of the allocations
+
+// Round up a size to the arena alignment
+#define ALIGN_SIZE(x) (((x) + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Pointer to the first byte available for allocations of the block.
+ *
+ * @param block             pointer to the block
+ * @return unsigned char*   pointer to the memory after the header
+ */
+local_function unsigned char *GetBlockMemory(arena_block_t *block)
+{
+    return (unsigned char *)block + ALIGN_SIZE(sizeof(arena_block_t));
+}
+
+/**
+ * @brief Allocate a new block big enough for the allocation.
+ *
+ * @param size              size of the allocation that did not fit
+ * @return arena_block_t*   the new block or NULL if there is not enough memory
+ */
+local_function arena_block_t *CreateArenaBlock(size_t size)
+{
+    size_t capacity = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    size_t blockSize = ALIGN_SIZE(sizeof(arena_block_t)) + capacity;
+
+    arena_block_t *block = malloc(blockSize);
+    if (block == NULL) return NULL;
+
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+
+    CountStatsMemory(blockSize, 0);
+    return block;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void *PushArena(arena_t *arena, size_t size)
+{
+    size = ALIGN_SIZE(size);
+
+    // NOTE(Andrei): After a reset the next blocks are empty, the ones
+    //               too small for the allocation are skipped.
+    while (arena->current != NULL && arena->current->used + size > arena->current->capacity)
+    {
+        if (arena->current->next == NULL) break;
+        arena->current = arena->current->next;
+    }
+
+    if (arena->current == NULL || arena->current->used + size > arena->current->capacity)
+    {
+        arena_block_t *block = CreateArenaBlock(size);
+        if (block == NULL) return NULL;
+
+        if (arena->current == NULL) arena->first = block;
+        else arena->current->next = block;
+
+        arena->current = block;
+    }
+
+    void *memory = GetBlockMemory(arena->current) + arena->current->used;
+    arena->current->used += size;
+
+    return memory;
+}
+
+char *PushArenaString(arena_t *arena, const char *text)
+{
+    size_t size = strlen(text) + 1;
+    char *copy = PushArena(arena, size);
+
+    if (copy != NULL) memcpy(copy, text, size);
+    return copy;
+}
+
+void ResetArena(arena_t *arena)
+{
+    for (arena_block_t *block = arena->first; block != NULL; block = block->next)
+    {
+        block->used = 0;
+    }
+
+    arena->current = arena->first;
+}
+
+void DeleteArena(arena_t *arena)
+{
+    arena_block_t *block = arena->first;
+
+    while (block != NULL)
+    {
+        arena_block_t *next = block->next;
+
+        CountStatsMemory(0, ALIGN_SIZE(sizeof(arena_block_t)) + block->capacity);
+        free(block);
+
+        block = next;
+    }
+
+    arena->first = arena->current = NULL;
+}
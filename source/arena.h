@@ -0,0 +1,64 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Block of memory of an arena, the allocations follow the header.
+ *
+ * 'next'       : next block of the arena
+ * 'capacity'   : number of bytes available for allocations
+ * 'used'       : number of bytes already allocated
+ */
+typedef struct arena_block_t
+{
+    struct arena_block_t *next;
+    size_t capacity, used;
+} arena_block_t;
+
+/**
+ * @brief Bump pointer allocator, the allocations are never released one by
+ * one, all of them are released at once with 'ResetArena'. The blocks are
+ * kept after a reset so the next directory reuses them. Zero initialize it
+ * before the first use.
+ *
+ * 'first'      : first block of the arena
+ * 'current'    : block where the next allocation is done
+ */
+struct arena_t
+{
+    arena_block_t *first, *current;
+};
+
+/**
+ * @brief Allocate memory from the arena, the memory is not initialized and
+ * it is aligned to 16 bytes.
+ *
+ * @param arena     pointer to the arena
+ * @param size      number of bytes to allocate
+ * @return void*    pointer to the memory or NULL if there is not enough memory
+ */
+void *PushArena(arena_t *arena, size_t size);
+
+/**
+ * @brief Copy a string to the arena.
+ *
+ * @param arena     pointer to the arena
+ * @param text      string to copy
+ * @return char*    pointer to the copy or NULL if there is not enough memory
+ */
+char *PushArenaString(arena_t *arena, const char *text);
+
+/**
+ * @brief Release all the allocations of the arena, the blocks are kept for
+ * the next allocations.
+ *
+ * @param arena     pointer to the arena
+ */
+void ResetArena(arena_t *arena);
+
+/**
+ * @brief Release the memory of the arena, it can be used again.
+ *
+ * @param arena     pointer to the arena
+ */
+void DeleteArena(arena_t *arena);
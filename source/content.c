@@ -0,0 +1,590 @@
+#include "content.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CONTENT_VIEW_SIZE   (16 * 1024 * 1024)  // bytes mapped at once, multiple of the allocation granularity
+#define CONTENT_MAGIC_SIZE  512                 // leading bytes used to detect the MIME type
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+/**
+ * @brief State of a XXH64 hash computed by parts.
+ *
+ * 'total'      : number of bytes hashed
+ * 'v'          : accumulators of the 32 byte stripes
+ * 'buffer'     : bytes that do not fill a stripe yet
+ * 'buffered'   : number of bytes on the buffer
+ */
+typedef struct xxh64_state_t
+{
+    unsigned long long total;
+    unsigned long long v[4];
+
+    unsigned char buffer[32];
+    size_t buffered;
+} xxh64_state_t;
+
+/**
+ * @brief Leading bytes of a document type.
+ *
+ * 'offset'     : position of the bytes on the document
+ * 'magic'      : bytes to compare
+ * 'length'     : number of bytes to compare
+ * 'mime'       : MIME type of the document
+ */
+typedef struct content_magic_t
+{
+    size_t offset;
+    const char *magic;
+    size_t length;
+    const char *mime;
+} content_magic_t;
+
+/**
+ * @brief Tasks shared by the threads of the pool, see 'RunContentTasks'.
+ *
+ * 'task'       : function run for each index
+ * 'context'    : data of the tasks
+ * 'count'      : number of tasks
+ * 'next'       : index of the next task to run
+ */
+typedef struct content_pool_t
+{
+    content_task_t task;
+    void *context;
+    size_t count;
+
+    volatile LONG next;
+} content_pool_t;
+
+/**
+ * @brief Documents read by 'ReadAssetsContent'.
+ *
+ * 'assets'     : documents to read, the biggest first
+ * 'arguments'  : columns to compute
+ */
+typedef struct content_batch_t
+{
+    asset_t **assets;
+    const arguments_t *arguments;
+} content_batch_t;
+
+global_variable const content_magic_t g_ContentMagic[] =
+{
+    {  0, "\x89PNG\r\n\x1a\n"        , 8, "image/png"                               },
+    {  0, "\xff\xd8\xff"             , 3, "image/jpeg"                              },
+    {  0, "GIF8"                     , 4, "image/gif"                               },
+    {  0, "BM"                       , 2, "image/bmp"                               },
+    {  0, "\x00\x00\x01\x00"         , 4, "image/vnd.microsoft.icon"                },
+    {  8, "WEBP"                     , 4, "image/webp"                              },
+    {  8, "WAVE"                     , 4, "audio/wav"                               },
+    {  8, "AVI "                     , 4, "video/x-msvideo"                         },
+    {  0, "ID3"                      , 3, "audio/mpeg"                              },
+    {  0, "OggS"                     , 4, "audio/ogg"                               },
+    {  0, "fLaC"                     , 4, "audio/flac"                              },
+    {  4, "ftyp"                     , 4, "video/mp4"                               },
+    {  0, "%PDF-"                    , 5, "application/pdf"                         },
+    {  0, "%!PS"                     , 4, "application/postscript"                  },
+    {  0, "{\\rtf"                   , 5, "application/rtf"                         },
+    {  0, "PK\x03\x04"               , 4, "application/zip"                         },
+    {  0, "PK\x05\x06"               , 4, "application/zip"                         },
+    {  0, "\x1f\x8b"                 , 2, "application/gzip"                        },
+    {  0, "BZh"                      , 3, "application/x-bzip2"                     },
+    {  0, "\xfd" "7zXZ\x00"          , 6, "application/x-xz"                        },
+    {  0, "7z\xbc\xaf\x27\x1c"       , 6, "application/x-7z-compressed"             },
+    {  0, "Rar!\x1a\x07"             , 6, "application/vnd.rar"                     },
+    {257, "ustar"                    , 5, "application/x-tar"                       },
+    {  0, "MSCF"                     , 4, "application/vnd.ms-cab-compressed"       },
+    {  0, "\xd0\xcf\x11\xe0\xa1\xb1\x1a\xe1", 8, "application/x-ole-storage"       },
+    {  0, "MZ"                       , 2, "application/vnd.microsoft.portable-executable" },
+    {  0, "\x7f" "ELF"               , 4, "application/x-elf"                       },
+    {  0, "\0asm"                    , 4, "application/wasm"                        },
+    {  0, "SQLite format 3"          , 15, "application/vnd.sqlite3"                },
+    {  0, "\xef\xbb\xbf"             , 3, "text/plain; charset=utf-8"               },
+    {  0, "\xff\xfe"                 , 2, "text/plain; charset=utf-16le"            },
+    {  0, "\xfe\xff"                 , 2, "text/plain; charset=utf-16be"            },
+    {  0, "<?xml"                    , 5, "text/xml"                                },
+    {  0, "<!DOCTYPE html"           , 14, "text/html"                              },
+    {  0, "<html"                    , 5, "text/html"                               },
+    {  0, "#!"                       , 2, "text/x-shellscript"                      },
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Rotate the bits of a value to the left.
+ *
+ * @param x                     value to rotate
+ * @param r                     number of bits (1 to 63)
+ * @return unsigned long long   rotated value
+ */
+local_function unsigned long long RotateLeft64(unsigned long long x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * @brief Read 8 bytes as a little endian value.
+ *
+ * @param p                     pointer to the bytes
+ * @return unsigned long long   the value
+ */
+local_function unsigned long long ReadLittleEndian64(const unsigned char *p)
+{
+    unsigned long long value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Read 4 bytes as a little endian value.
+ *
+ * @param p                     pointer to the bytes
+ * @return unsigned long long   the value
+ */
+local_function unsigned long long ReadLittleEndian32(const unsigned char *p)
+{
+    unsigned int value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Mix 8 bytes of the input into an accumulator.
+ *
+ * @param acc                   accumulator
+ * @param input                 bytes of the input
+ * @return unsigned long long   the new accumulator
+ */
+local_function unsigned long long RoundXXH64(unsigned long long acc, unsigned long long input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = RotateLeft64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+/**
+ * @brief Merge an accumulator into the hash.
+ *
+ * @param hash                  hash
+ * @param acc                   accumulator
+ * @return unsigned long long   the new hash
+ */
+local_function unsigned long long MergeRoundXXH64(unsigned long long hash, unsigned long long acc)
+{
+    hash ^= RoundXXH64(0, acc);
+    return hash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+/**
+ * @brief Start a XXH64 hash with seed 0.
+ *
+ * @param state     pointer to the state
+ */
+local_function void ResetXXH64(xxh64_state_t *state)
+{
+    memset(state, 0, sizeof(xxh64_state_t));
+
+    state->v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+    state->v[1] = XXH_PRIME64_2;
+    state->v[2] = 0;
+    state->v[3] = 0 - XXH_PRIME64_1;
+}
+
+/**
+ * @brief Hash the next bytes of the input.
+ *
+ * @param state     pointer to the state
+ * @param data      bytes to hash
+ * @param size      number of bytes
+ */
+local_function void UpdateXXH64(xxh64_state_t *state, const unsigned char *data, size_t size)
+{
+    state->total += size;
+
+    if (state->buffered + size < 32)
+    {
+        memcpy(state->buffer + state->buffered, data, size);
+        state->buffered += size;
+        return;
+    }
+
+    if (state->buffered > 0)
+    {
+        size_t fill = 32 - state->buffered;
+        memcpy(state->buffer + state->buffered, data, fill);
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            state->v[i] = RoundXXH64(state->v[i], ReadLittleEndian64(state->buffer + i * 8));
+        }
+
+        data += fill;
+        size -= fill;
+        state->buffered = 0;
+    }
+
+    // NOTE(Andrei): The accumulators are kept on locals so the compiler can
+    //               hold them on registers for the whole mapped view.
+    unsigned long long v0 = state->v[0], v1 = state->v[1];
+    unsigned long long v2 = state->v[2], v3 = state->v[3];
+
+    for (; size >= 32; data += 32, size -= 32)
+    {
+        v0 = RoundXXH64(v0, ReadLittleEndian64(data));
+        v1 = RoundXXH64(v1, ReadLittleEndian64(data + 8));
+        v2 = RoundXXH64(v2, ReadLittleEndian64(data + 16));
+        v3 = RoundXXH64(v3, ReadLittleEndian64(data + 24));
+    }
+
+    state->v[0] = v0; state->v[1] = v1;
+    state->v[2] = v2; state->v[3] = v3;
+
+    memcpy(state->buffer, data, size);
+    state->buffered = size;
+}
+
+/**
+ * @brief Finish the hash of the input.
+ *
+ * @param state                 pointer to the state
+ * @return unsigned long long   the hash
+ */
+local_function unsigned long long DigestXXH64(const xxh64_state_t *state)
+{
+    unsigned long long hash = 0;
+
+    if (state->total >= 32)
+    {
+        hash = RotateLeft64(state->v[0], 1) + RotateLeft64(state->v[1], 7) + RotateLeft64(state->v[2], 12) + RotateLeft64(state->v[3], 18);
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            hash = MergeRoundXXH64(hash, state->v[i]);
+        }
+    }
+    else
+    {
+        hash = state->v[2] + XXH_PRIME64_5;
+    }
+
+    hash += state->total;
+
+    const unsigned char *p = state->buffer;
+    const unsigned char *end = state->buffer + state->buffered;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        hash ^= RoundXXH64(0, ReadLittleEndian64(p));
+        hash = RotateLeft64(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+
+    if (p + 4 <= end)
+    {
+        hash ^= ReadLittleEndian32(p) * XXH_PRIME64_1;
+        hash = RotateLeft64(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+    {
+        hash ^= *p * XXH_PRIME64_5;
+        hash = RotateLeft64(hash, 11) * XXH_PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/**
+ * @brief Count the end of lines of a block.
+ *
+ * @param data      bytes of the block
+ * @param size      number of bytes
+ * @return size_t   number of '\n' characters
+ */
+local_function size_t CountLines(const unsigned char *data, size_t size)
+{
+    size_t lines = 0;
+    const unsigned char *end = data + size;
+
+    while (data < end && (data = memchr(data, '\n', (size_t)(end - data))) != NULL)
+    {
+        ++lines;
+        ++data;
+    }
+
+    return lines;
+}
+
+/**
+ * @brief Detect the MIME type from the leading bytes of a document. If no
+ * signature matches, the documents without control characters are text.
+ *
+ * @param data          leading bytes of the document
+ * @param size          number of bytes
+ * @return const char*  the MIME type
+ */
+local_function const char *DetectMimeType(const unsigned char *data, size_t size)
+{
+    if (size == 0) return "inode/x-empty";
+
+    for (size_t i = 0; i < ARRAY_SIZE(g_ContentMagic); ++i)
+    {
+        const content_magic_t *m = &g_ContentMagic[i];
+
+        if (m->offset + m->length <= size && memcmp(data + m->offset, m->magic, m->length) == 0)
+        {
+            return m->mime;
+        }
+    }
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (data[i] < 0x20 && data[i] != '\t' && data[i] != '\n' && data[i] != '\r' && data[i] != '\f')
+        {
+            return "application/octet-stream";
+        }
+    }
+
+    return "text/plain";
+}
+
+/**
+ * @brief Map the document view by view and compute the content columns.
+ *
+ * @param asset         document to read
+ * @param arguments     columns to compute
+ */
+local_function void ComputeAssetContent(asset_t *asset, const arguments_t *arguments)
+{
+    HANDLE hFile = INVALID_HANDLE_VALUE, hMapping = NULL;
+
+    xxh64_state_t hash;
+    ResetXXH64(&hash);
+
+    BOOL whole = arguments->showChecksum || arguments->showLines;
+    asset->content.mime = "inode/x-empty";
+
+    hFile = CreateFileA(asset->path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) goto clean_up;
+
+    LARGE_INTEGER fileSize = { 0 };
+    if (!GetFileSizeEx(hFile, &fileSize)) goto clean_up;
+
+    // NOTE(Andrei): Empty documents can not be mapped, they are read
+    //               as they are (the hash of no bytes and no lines).
+    unsigned long long size = (unsigned long long)fileSize.QuadPart;
+
+    if (size > 0)
+    {
+        hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (hMapping == NULL) goto clean_up;
+    }
+
+    if (!whole && size > CONTENT_MAGIC_SIZE)
+    {
+        size = CONTENT_MAGIC_SIZE;
+    }
+
+    for (unsigned long long offset = 0; offset < size; offset += CONTENT_VIEW_SIZE)
+    {
+        size_t viewSize = size - offset < CONTENT_VIEW_SIZE ? (size_t)(size - offset) : CONTENT_VIEW_SIZE;
+        const unsigned char *view = MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)offset, viewSize);
+        if (view == NULL) goto clean_up;
+
+        if (offset == 0)
+        {
+            asset->content.mime = DetectMimeType(view, viewSize < CONTENT_MAGIC_SIZE ? viewSize : CONTENT_MAGIC_SIZE);
+        }
+
+        if (arguments->showChecksum) UpdateXXH64(&hash, view, viewSize);
+        if (arguments->showLines) asset->content.lines += CountLines(view, viewSize);
+
+        UnmapViewOfFile(view);
+    }
+
+    asset->content.checksum = DigestXXH64(&hash);
+    asset->content.read = TRUE;
+
+clean_up:
+    if (hMapping != NULL) CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+}
+
+/**
+ * @brief Compare two documents by size, the biggest first.
+ *
+ * @param a     pointer to the first asset pointer
+ * @param b     pointer to the second asset pointer
+ * @return int  negative if 'a' goes first, positive if 'b' goes first, 0 otherwise
+ */
+local_function int CompareContentSize(const void *a, const void *b)
+{
+    size_t sa = (*(const asset_t **)a)->size;
+    size_t sb = (*(const asset_t **)b)->size;
+
+    return (sb > sa) - (sb < sa);
+}
+
+/**
+ * @brief Thread of the pool, it runs tasks until all of them are taken.
+ *
+ * @param parameter     pointer to the pool
+ * @return DWORD        always 0
+ */
+local_function DWORD WINAPI ContentWorker(LPVOID parameter)
+{
+    content_pool_t *pool = parameter;
+
+    for (;;)
+    {
+        size_t i = (size_t)(InterlockedIncrement(&pool->next) - 1);
+        if (i >= pool->count) break;
+
+        pool->task(pool->context, i);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Task of 'ReadAssetsContent', it reads one document.
+ *
+ * @param context   pointer to the batch
+ * @param index     index of the document
+ */
+local_function void ReadBatchContent(void *context, size_t index)
+{
+    content_batch_t *batch = context;
+    ComputeAssetContent(batch->assets[index], batch->arguments);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RunContentTasks(size_t count, content_task_t task, void *context)
+{
+    content_pool_t pool = { 0 };
+    HANDLE threads[MAX_CONTENT_THREADS] = { 0 };
+    DWORD numThreads = 0;
+
+    pool.task = task;
+    pool.context = context;
+    pool.count = count;
+
+    SYSTEM_INFO info = { 0 };
+    GetSystemInfo(&info);
+
+    DWORD maxThreads = info.dwNumberOfProcessors < MAX_CONTENT_THREADS ? info.dwNumberOfProcessors : MAX_CONTENT_THREADS;
+    maxThreads = count < maxThreads ? (DWORD)count : maxThreads;
+
+    // NOTE(Andrei): The calling thread is one of the workers, if a thread
+    //               can not be created the rest of the pool does its part.
+    for (DWORD i = 1; i < maxThreads; ++i)
+    {
+        threads[numThreads] = CreateThread(NULL, 0, ContentWorker, &pool, 0, NULL);
+        if (threads[numThreads] != NULL) ++numThreads;
+    }
+
+    ContentWorker(&pool);
+
+    if (numThreads > 0)
+    {
+        WaitForMultipleObjects(numThreads, threads, TRUE, INFINITE);
+    }
+
+    for (DWORD i = 0; i < numThreads; ++i)
+    {
+        CloseHandle(threads[i]);
+    }
+}
+
+BOOL HashDocumentContent(const char *path, unsigned long long limit, unsigned long long *hash)
+{
+    HANDLE hFile = INVALID_HANDLE_VALUE, hMapping = NULL;
+    BOOL retValue = FALSE;
+
+    xxh64_state_t state;
+    ResetXXH64(&state);
+
+    hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) goto clean_up;
+
+    LARGE_INTEGER fileSize = { 0 };
+    if (!GetFileSizeEx(hFile, &fileSize)) goto clean_up;
+
+    unsigned long long size = (unsigned long long)fileSize.QuadPart;
+    if (limit != 0 && size > limit) size = limit;
+
+    if (size > 0)
+    {
+        hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (hMapping == NULL) goto clean_up;
+    }
+
+    for (unsigned long long offset = 0; offset < size; offset += CONTENT_VIEW_SIZE)
+    {
+        size_t viewSize = size - offset < CONTENT_VIEW_SIZE ? (size_t)(size - offset) : CONTENT_VIEW_SIZE;
+        const unsigned char *view = MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)offset, viewSize);
+        if (view == NULL) goto clean_up;
+
+        UpdateXXH64(&state, view, viewSize);
+        UnmapViewOfFile(view);
+    }
+
+    *hash = DigestXXH64(&state);
+    retValue = TRUE;
+
+clean_up:
+    if (hMapping != NULL) CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+
+    return retValue;
+}
+
+void ReadAssetsContent(asset_t *assets, size_t count, const arguments_t *arguments)
+{
+    content_batch_t batch = { 0 };
+    size_t numDocuments = 0;
+
+    batch.assets = malloc(sizeof(asset_t *) * (count + 1));
+    batch.arguments = arguments;
+    if (batch.assets == NULL) return;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        memset(&assets[i].content, 0, sizeof(content_info_t));
+        if (assets[i].type.directory) continue;
+
+        batch.assets[numDocuments++] = &assets[i];
+    }
+
+    qsort(batch.assets, numDocuments, sizeof(asset_t *), CompareContentSize);
+    RunContentTasks(numDocuments, ReadBatchContent, &batch);
+
+    CHECK_DELETE(batch.assets);
+}
+
+void ReadAssetContent(asset_t *asset, const arguments_t *arguments)
+{
+    memset(&asset->content, 0, sizeof(content_info_t));
+    if (asset->type.directory) return;
+
+    ComputeAssetContent(asset, arguments);
+}
+
+BOOL HasContentColumns(const arguments_t *arguments)
+{
+    return arguments->showChecksum || arguments->showLines || arguments->showMime;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Task run by the pool for each index, see 'RunContentTasks'.
+ */
+typedef void (*content_task_t)(void *context, size_t index);
+
+/**
+ * @brief Run a task for each index on a pool of threads (one per processor,
+ * up to 'MAX_CONTENT_THREADS'), the calling thread is part of the pool. The
+ * indices are taken in order so the longest tasks should go first.
+ *
+ * @param count     number of tasks
+ * @param task      function run for each index
+ * @param context   data passed to the task
+ */
+void RunContentTasks(size_t count, content_task_t task, void *context);
+
+/**
+ * @brief Compute the XXH64 hash (seed 0) of the content of a document, the
+ * document is mapped view by view.
+ *
+ * @param path      full path of the document
+ * @param limit     number of leading bytes to hash, 0 hashes the whole document
+ * @param hash      pointer where the hash is stored
+ * @return BOOL     TRUE if the document can be read, FALSE otherwise
+ */
+BOOL HashDocumentContent(const char *path, unsigned long long limit, unsigned long long *hash);
+
+/**
+ * @brief Read the content of the documents and compute the columns enabled
+ * by the arguments (checksum, lines and MIME type), see 'content_info_t'.
+ *
+ * The documents are read by the pool of threads (see 'RunContentTasks')
+ * through file mappings, the biggest documents are scheduled first so the
+ * threads finish at the same time. The directories and the documents that
+ * can not be read are left as not read.
+ *
+ * @param assets        assets to read
+ * @param count         number of assets
+ * @param arguments     pointer to the parsed arguments structure
+ */
+void ReadAssetsContent(asset_t *assets, size_t count, const arguments_t *arguments);
+
+/**
+ * @brief Read the content of a single document on the calling thread, see
+ * 'ReadAssetsContent'.
+ *
+ * @param asset         asset to read
+ * @param arguments     pointer to the parsed arguments structure
+ */
+void ReadAssetContent(asset_t *asset, const arguments_t *arguments);
+
+/**
+ * @brief Check if any of the content columns is enabled.
+ *
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if the content of the documents is needed, FALSE otherwise
+ */
+BOOL HasContentColumns(const arguments_t *arguments);
@@ -0,0 +1,327 @@
+#include "count.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "content.h"
+#include "format.h"
+#include "glob.h"
+#include "filter.h"
+#include "directory.h"
+#include "win32.h"
+
+// Check if the find data belongs to a symbolic link or a junction
+#define IS_LINK(fd)         (((fd)->dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && \
+                            ((fd)->dwReserved0 == IO_REPARSE_TAG_SYMLINK || (fd)->dwReserved0 == IO_REPARSE_TAG_MOUNT_POINT))
+
+/**
+ * @brief Walk of a tree, the root and each task of the pool have their own.
+ *
+ * 'arguments'      : pointer to the parsed arguments structure
+ * 'totals'         : totals of the assets found by this walk
+ * 'printDirs'      : print each directory with the totals of its sub-tree ('--by-dir')
+ * 'pattern'        : name pattern of the counted assets, NULL to count all of them
+ *
+ * 'pending'        : sub-directories left for the pool
+ * 'numPending'     : number of pending sub-directories
+ * 'capacity'       : space available on the 'pending' array
+ * 'arena'          : arena where the pending paths are stored, NULL to walk
+ *                    the sub-directories inline
+ */
+typedef struct count_walk_t
+{
+    const arguments_t *arguments;
+    count_totals_t totals;
+    BOOL printDirs;
+
+    const char *pattern;
+
+    const char **pending;
+    size_t numPending, capacity;
+    arena_t *arena;
+} count_walk_t;
+
+/**
+ * @brief Sub-directories of the root counted by the pool.
+ *
+ * 'paths'      : path of each sub-directory
+ * 'walks'      : walk of each sub-directory, its totals are added at the end
+ */
+typedef struct count_batch_t
+{
+    const char **paths;
+    count_walk_t *walks;
+} count_batch_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Add the totals of a walk to other totals.
+ *
+ * @param totals    pointer to the totals that are increased
+ * @param other     totals to add
+ */
+local_function void AddCountTotals(count_totals_t *totals, const count_totals_t *other)
+{
+    totals->documents += other->documents;
+    totals->directories += other->directories;
+    totals->links += other->links;
+    totals->bytes += other->bytes;
+}
+
+/**
+ * @brief Print the totals of a tree on a single line.
+ *
+ * @param path          root of the tree
+ * @param totals        totals of the tree
+ * @param arguments     pointer to the parsed arguments structure
+ */
+local_function void PrintCountTotals(const char *path, const count_totals_t *totals, const arguments_t *arguments)
+{
+    char size[SIZE_TEXT_SIZE];
+    FormatSize(totals->bytes, arguments->sizeFormat, size, SIZE_TEXT_SIZE);
+
+    const char *sizeText = size;
+    while (*sizeText == ' ') ++sizeText;
+
+    printf_s("%s: %zu documents, %zu directories, %zu links, %s\n", path, totals->documents, totals->directories, totals->links, sizeText);
+}
+
+/**
+ * @brief Check if a sub-directory has to be walked, based on the depth and
+ * the prune patterns.
+ *
+ * @param name          name of the sub-directory
+ * @param depth         depth of the directory that contains it (root is 0)
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if it has to be walked, FALSE otherwise
+ */
+local_function BOOL ShouldCountRecurse(const char *name, size_t depth, const arguments_t *arguments)
+{
+    if (depth >= arguments->maxDepth) return FALSE;
+
+    for (size_t i = 0; i < arguments->numPrune; ++i)
+    {
+        if (MatchPattern(arguments->prune[i], name)) return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Check if an asset found by the walk is counted: its name has to
+ * match the pattern and it has to pass the name and stat stages of the
+ * filter ('--where'), all of them only need the find data.
+ *
+ * @param walk      pointer to the walk
+ * @param fd        find data of the asset
+ * @return BOOL     TRUE if the asset is counted, FALSE otherwise
+ */
+local_function BOOL IsAssetCounted(const count_walk_t *walk, const WIN32_FIND_DATAA *fd)
+{
+    const filter_t *filter = walk->arguments->filter;
+    asset_t asset = { 0 };
+
+    if (walk->pattern != NULL && !MatchPattern(walk->pattern, fd->cFileName)) return FALSE;
+    if (filter == NULL) return TRUE;
+
+    asset.name = fd->cFileName;
+    TranslateAttributes(fd->dwFileAttributes, &asset);
+
+    if (!EvaluateFilter(filter, FILTER_STAGE_NAME, &asset)) return FALSE;
+
+    GetTimestaps(fd, &asset);
+    asset.size = ((size_t)fd->nFileSizeHigh << 32) | fd->nFileSizeLow;
+
+    return EvaluateFilter(filter, FILTER_STAGE_STAT, &asset);
+}
+
+/**
+ * @brief Count the assets of a directory and walk its sub-directories, or
+ * leave them as pending for the pool.
+ *
+ * @param walk      pointer to the walk
+ * @param path      buffer with the path of the directory, it is extended in-place
+ * @param length    length of the path
+ * @param depth     depth of the directory (root is 0)
+ * @return BOOL     TRUE if the directory can be enumerated, FALSE otherwise
+ */
+local_function BOOL CountDirectory(count_walk_t *walk, char *path, size_t length, size_t depth)
+{
+    const arguments_t *arguments = walk->arguments;
+    count_totals_t before = walk->totals;
+    WIN32_FIND_DATAA fd;
+
+    if (length + 2 >= MAX_PATH) return FALSE;
+    strcpy_s(path + length, MAX_PATH - length, "\\*");
+
+    // NOTE(Andrei): The basic information level skips the short names and
+    //               the large fetch asks for bigger batches of entries, the
+    //               find data already has the attributes and the size.
+    HANDLE hFind = FindFirstFileExA(path, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    path[length] = '\0';
+
+    if (hFind == INVALID_HANDLE_VALUE) return FALSE;
+
+    do
+    {
+        const char *name = fd.cFileName;
+
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+        if (!arguments->showAll && !arguments->showAlmostAll)
+        {
+            if ((fd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) || name[0] == '.' || name[0] == '$') continue;
+        }
+
+        BOOL counted = IsAssetCounted(walk, &fd);
+
+        if (IS_LINK(&fd))
+        {
+            walk->totals.links += counted;
+            continue;
+        }
+
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        {
+            walk->totals.documents += counted;
+            walk->totals.bytes += counted ? ((size_t)fd.nFileSizeHigh << 32) | fd.nFileSizeLow : 0;
+            continue;
+        }
+
+        walk->totals.directories += counted;
+
+        // NOTE(Andrei): Recurse before filtering, a directory that is not
+        //               counted can still have counted assets.
+        size_t nameLength = strlen(name);
+        if (!ShouldCountRecurse(name, depth, arguments) || length + 1 + nameLength >= MAX_PATH) continue;
+
+        path[length] = '\\';
+        memcpy(path + length + 1, name, nameLength + 1);
+
+        if (walk->arena == NULL)
+        {
+            CountDirectory(walk, path, length + 1 + nameLength, depth + 1);
+            goto next_entry;
+        }
+
+        if (walk->numPending == walk->capacity)
+        {
+            size_t newCapacity = walk->capacity ? walk->capacity * 2 : STARTUP_CONTAINER_SIZE;
+            const char **pending = realloc(walk->pending, sizeof(const char *) * newCapacity);
+
+            if (pending == NULL) goto next_entry;
+
+            walk->pending = pending;
+            walk->capacity = newCapacity;
+        }
+
+        const char *pendingPath = PushArenaString(walk->arena, path);
+        if (pendingPath != NULL) walk->pending[walk->numPending++] = pendingPath;
+
+    next_entry:
+        path[length] = '\0';
+    } while (FindNextFileA(hFind, &fd));
+
+    FindClose(hFind);
+
+    if (walk->printDirs && depth > 0)
+    {
+        count_totals_t subtree = walk->totals;
+
+        subtree.documents -= before.documents;
+        subtree.directories -= before.directories;
+        subtree.links -= before.links;
+        subtree.bytes -= before.bytes;
+
+        PrintCountTotals(path, &subtree, arguments);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Task of the pool, it walks a sub-directory of the root.
+ *
+ * @param context   batch of sub-directories
+ * @param index     index of the sub-directory
+ */
+local_function void CountPendingDirectory(void *context, size_t index)
+{
+    count_batch_t *batch = context;
+    char path[MAX_PATH];
+
+    strcpy_s(path, MAX_PATH, batch->paths[index]);
+    CountDirectory(&batch->walks[index], path, strlen(path), 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BOOL IsCountPattern(const char *pattern)
+{
+    if (strncmp(pattern, "**", 2) == 0 && (pattern[2] == '\\' || pattern[2] == '/')) pattern += 3;
+    else if (strcmp(pattern, "**") == 0) return TRUE;
+
+    return strpbrk(pattern, "\\/") == NULL && strcmp(pattern, "**") != 0;
+}
+
+BOOL CountAssetTree(const char *path, const char *pattern, const arguments_t *arguments, count_totals_t *totals)
+{
+    count_walk_t root = { 0 };
+    arena_t arena = { 0 };
+    char buffer[MAX_PATH];
+
+    root.arguments = arguments;
+    root.printDirs = arguments->countByDir;
+
+    // NOTE(Andrei): The count always walks the whole tree, as without a
+    //               pattern, '*.log' and '**\*.log' count the same assets.
+    if (strncmp(pattern, "**", 2) == 0 && (pattern[2] == '\\' || pattern[2] == '/')) pattern += 3;
+    else if (strcmp(pattern, "**") == 0) pattern += 2;
+
+    root.pattern = pattern[0] != '\0' ? pattern : NULL;
+
+    // NOTE(Andrei): Printing each directory needs the walk in order, only
+    //               the summary is counted in parallel.
+    if (!root.printDirs) root.arena = &arena;
+
+    strcpy_s(buffer, MAX_PATH, path);
+    size_t length = strlen(buffer);
+    while (length > 1 && (buffer[length - 1] == '\\' || buffer[length - 1] == '/') && buffer[length - 2] != ':') buffer[--length] = '\0';
+
+    if (!CountDirectory(&root, buffer, length, 0))
+    {
+        DeleteArena(&arena);
+        return FALSE;
+    }
+
+    count_batch_t batch = { root.pending, calloc(root.numPending + 1, sizeof(count_walk_t)) };
+
+    if (batch.walks != NULL)
+    {
+        for (size_t i = 0; i < root.numPending; ++i)
+        {
+            batch.walks[i].arguments = arguments;
+            batch.walks[i].pattern = root.pattern;
+        }
+
+        RunContentTasks(root.numPending, CountPendingDirectory, &batch);
+
+        for (size_t i = 0; i < root.numPending; ++i)
+        {
+            AddCountTotals(&root.totals, &batch.walks[i].totals);
+        }
+    }
+
+    *totals = root.totals;
+    PrintCountTotals(buffer, totals, arguments);
+
+    CHECK_DELETE(batch.walks);
+    CHECK_DELETE(root.pending);
+    DeleteArena(&arena);
+
+    return TRUE;
+}
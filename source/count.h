@@ -0,0 +1,54 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Number of assets of a tree by type, see 'CountAssetTree'.
+ *
+ * 'documents'      : number of documents
+ * 'directories'    : number of directories (the root is not counted)
+ * 'links'          : number of symbolic links and junctions, they are not followed
+ * 'bytes'          : sum of the sizes of the documents
+ */
+typedef struct count_totals_t
+{
+    size_t documents, directories, links;
+    size_t bytes;
+} count_totals_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Count the assets of a tree and print a summary ('--count'). Only the
+ * names and the attributes returned by the enumeration are used, no asset is
+ * opened and no permission or owner is read.
+ *
+ * The sub-directories of the root are counted by the pool of threads (see
+ * 'RunContentTasks'), each task has its own totals and they are added at the
+ * end. With '--by-dir' the tree is walked on the calling thread and each
+ * directory is printed after its sub-directories with the totals of its
+ * sub-tree, as 'du' does.
+ *
+ * The hidden assets are skipped unless '-a' or '-A' is used, '--max-depth'
+ * and '--prune' limit the directories that are walked. Only the assets
+ * matching the name pattern and the name and stat predicates of '--where'
+ * are counted (see 'IsCountPattern'), the directories are walked even if
+ * they are not counted. The pattern is matched at any depth, as '-R' does.
+ *
+ * @param path          root of the tree
+ * @param pattern       name pattern relative to the root, empty to count all the assets
+ * @param arguments     pointer to the parsed arguments structure
+ * @param totals        pointer where the totals of the tree are stored
+ * @return BOOL         TRUE if the root is a directory, FALSE otherwise
+ */
+BOOL CountAssetTree(const char *path, const char *pattern, const arguments_t *arguments, count_totals_t *totals);
+
+/**
+ * @brief Check if a glob pattern can be counted, only a name pattern, with
+ * or without a leading globstar, is supported. Both are matched at any depth.
+ * ex: "*.log" or "**\*.log"
+ *
+ * @param pattern       glob pattern relative to the root
+ * @return BOOL         TRUE if it can be counted, FALSE otherwise
+ */
+BOOL IsCountPattern(const char *pattern);
@@ -0,0 +1,571 @@
+#include "daemon.h"
+#include "types.h"
+#include "win32.h"
+
+#include <sddl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define DAEMON_PROTOCOL         1               // version of the requests and responses
+#define DAEMON_CACHE_SIZE       256             // number of directory snapshots kept
+#define DAEMON_PIPE_BUFFER      (64 * 1024)     // size of the pipe buffers
+#define DAEMON_CONNECT_WAIT     50              // milliseconds to wait for a busy daemon
+#define DAEMON_MAX_SNAPSHOT     (64 * 1024 * 1024) // largest snapshot accepted by the clients
+
+// Round up the size of a record to keep the next one aligned
+#define ALIGN_RECORD(x) (((x) + 7) & ~(size_t)7)
+
+// Changes of a directory that invalidate its snapshot
+#define DAEMON_NOTIFY_FILTER    (FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES | \
+                                FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SECURITY)
+
+/**
+ * @brief Request of a client, the directory is a full path since the daemon
+ * has its own working directory.
+ */
+typedef struct daemon_request_t
+{
+    DWORD protocol;
+    char directory[MAX_PATH];
+} daemon_request_t;
+
+/**
+ * @brief Response of the daemon, the records of the entries follow it.
+ */
+typedef struct daemon_response_t
+{
+    DWORD protocol;
+    BOOL found;
+    unsigned long long size;
+} daemon_response_t;
+
+/**
+ * @brief Snapshot of a directory kept by the daemon.
+ *
+ * 'directory'  : full path of the directory
+ * 'change'     : change notification of the directory, signaled when the snapshot is stale
+ * 'data'       : records of the entries
+ * 'size'       : number of bytes of the records
+ * 'lastUse'    : request number of the last use, the oldest snapshot is replaced
+ */
+typedef struct daemon_cache_entry_t
+{
+    char directory[MAX_PATH];
+    HANDLE change;
+
+    unsigned char *data;
+    size_t size;
+
+    unsigned long long lastUse;
+} daemon_cache_entry_t;
+
+global_variable daemon_cache_entry_t g_DaemonCache[DAEMON_CACHE_SIZE];
+global_variable unsigned long long g_DaemonRequests = 0;
+
+// NOTE(Andrei): The clients can run on several threads (concurrent roots,
+//               'libls.h'), the name is built once and the flag is only
+//               changed with interlocked operations.
+global_variable INIT_ONCE g_DaemonPipeNameOnce = INIT_ONCE_STATIC_INIT;
+global_variable char g_DaemonPipeName[MAX_PATH] = { 0 };
+
+// The daemon was not found, is busy or is not trusted
+global_variable volatile LONG g_DaemonUnavailable = FALSE;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Build the name of the pipe, run once by 'GetDaemonPipeName'.
+ *
+ * @param once          one-time initialization of the name
+ * @param parameter     not used
+ * @param context       not used
+ * @return BOOL         always TRUE
+ */
+local_function BOOL CALLBACK InitDaemonPipeName(PINIT_ONCE once, PVOID parameter, PVOID *context)
+{
+    char user[MAX_PATH] = { 0 };
+    DWORD userSize = MAX_PATH;
+
+    if (!GetUserNameA(user, &userSize)) strcpy_s(user, MAX_PATH, "default");
+    sprintf_s(g_DaemonPipeName, MAX_PATH, "\\\\.\\pipe\\ls-daemon-%s", user);
+
+    return TRUE;
+}
+
+/**
+ * @brief Name of the pipe of the daemon, one per user.
+ *
+ * @return const char*  name of the pipe
+ */
+local_function const char *GetDaemonPipeName()
+{
+    InitOnceExecuteOnce(&g_DaemonPipeNameOnce, InitDaemonPipeName, NULL, NULL);
+    return g_DaemonPipeName;
+}
+
+/**
+ * @brief Get the user SID of the token of a process.
+ *
+ * @param process   handle of the process, with query access
+ * @param sid       buffer of SECURITY_MAX_SID_SIZE bytes where the SID is stored
+ * @return BOOL     TRUE if the SID can be retrieved, FALSE otherwise
+ */
+local_function BOOL GetProcessUserSid(HANDLE process, BYTE *sid)
+{
+    DWORD_PTR buffer[(sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE) / sizeof(DWORD_PTR) + 1];
+    HANDLE hToken = NULL;
+    DWORD length = 0;
+    BOOL result = FALSE;
+
+    if (!OpenProcessToken(process, TOKEN_QUERY, &hToken)) return FALSE;
+
+    if (GetTokenInformation(hToken, TokenUser, buffer, sizeof(buffer), &length))
+    {
+        const TOKEN_USER *user = (const TOKEN_USER *)buffer;
+        result = CopySid(SECURITY_MAX_SID_SIZE, sid, user->User.Sid);
+    }
+
+    CloseHandle(hToken);
+    return result;
+}
+
+/**
+ * @brief Check that the server of a connected pipe runs as the current user.
+ * The name of the pipe does not prove it, any local user can create it first.
+ *
+ * @param pipe      handle of the connected pipe
+ * @return BOOL     TRUE if the server is a process of the current user, FALSE otherwise
+ */
+local_function BOOL IsDaemonOfCurrentUser(HANDLE pipe)
+{
+    BYTE userSid[SECURITY_MAX_SID_SIZE] = { 0 };
+    BYTE serverSid[SECURITY_MAX_SID_SIZE] = { 0 };
+    ULONG processId = 0;
+
+    if (!GetNamedPipeServerProcessId(pipe, &processId)) return FALSE;
+
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+    if (process == NULL) return FALSE;
+
+    BOOL result = GetProcessUserSid(process, serverSid) && GetProcessUserSid(GetCurrentProcess(), userSid) && EqualSid(userSid, serverSid);
+    CloseHandle(process);
+
+    return result;
+}
+
+/**
+ * @brief Build the security attributes of the pipe, only the current user
+ * can open it. Release the descriptor with 'LocalFree'.
+ *
+ * @param attributes    pointer where the attributes are stored
+ * @return BOOL         TRUE if the descriptor is created, FALSE otherwise
+ */
+local_function BOOL GetDaemonPipeSecurity(SECURITY_ATTRIBUTES *attributes)
+{
+    BYTE sid[SECURITY_MAX_SID_SIZE] = { 0 };
+    char descriptor[256] = { 0 };
+    char *sidString = NULL;
+
+    if (!GetProcessUserSid(GetCurrentProcess(), sid) || !ConvertSidToStringSidA(sid, &sidString)) return FALSE;
+
+    // NOTE(Andrei): Protected DACL with a single entry, full access for the user.
+    sprintf_s(descriptor, sizeof(descriptor), "D:P(A;;GA;;;%s)", sidString);
+    LocalFree(sidString);
+
+    memset(attributes, 0, sizeof(SECURITY_ATTRIBUTES));
+    attributes->nLength = sizeof(SECURITY_ATTRIBUTES);
+
+    return ConvertStringSecurityDescriptorToSecurityDescriptorA(descriptor, SDDL_REVISION_1, &attributes->lpSecurityDescriptor, NULL);
+}
+
+/**
+ * @brief Read from a pipe until the buffer is full.
+ *
+ * @param pipe      handle of the pipe
+ * @param buffer    buffer where the bytes are stored
+ * @param size      number of bytes to read
+ * @return BOOL     TRUE if all the bytes are read, FALSE otherwise
+ */
+local_function BOOL ReadPipe(HANDLE pipe, void *buffer, size_t size)
+{
+    unsigned char *at = buffer;
+
+    while (size > 0)
+    {
+        DWORD chunk = size > DAEMON_PIPE_BUFFER ? DAEMON_PIPE_BUFFER : (DWORD)size, read = 0;
+        if (!ReadFile(pipe, at, chunk, &read, NULL) || read == 0) return FALSE;
+
+        at += read;
+        size -= read;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Write to a pipe all the bytes of the buffer.
+ *
+ * @param pipe      handle of the pipe
+ * @param buffer    bytes to write
+ * @param size      number of bytes to write
+ * @return BOOL     TRUE if all the bytes are written, FALSE otherwise
+ */
+local_function BOOL WritePipe(HANDLE pipe, const void *buffer, size_t size)
+{
+    const unsigned char *at = buffer;
+
+    while (size > 0)
+    {
+        DWORD chunk = size > DAEMON_PIPE_BUFFER ? DAEMON_PIPE_BUFFER : (DWORD)size, written = 0;
+        if (!WriteFile(pipe, at, chunk, &written, NULL) || written == 0) return FALSE;
+
+        at += written;
+        size -= written;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Probe an entry of a directory and append its record to the snapshot.
+ *
+ * @param snapshot      snapshot where the record is appended
+ * @param capacity      pointer to the capacity of the snapshot data
+ * @param fd            find data of the entry
+ * @return BOOL         TRUE if there is enough memory, FALSE otherwise
+ */
+local_function BOOL AppendDaemonEntry(daemon_cache_entry_t *snapshot, size_t *capacity, const WIN32_FIND_DATAA *fd)
+{
+    char path[MAX_PATH] = { 0 };
+    char link[MAX_PATH] = { 0 };
+    asset_t asset = { 0 };
+
+    snprintf(path, sizeof(path), "%s\\%s", snapshot->directory, fd->cFileName);
+    TranslateAttributes(fd->dwFileAttributes, &asset);
+
+    GetPermissions(path, &asset);
+    GetOwnerAndDomain(path, &asset);
+
+    BOOL hasLink = asset.type.symlink && GetLinkTarget(path, link, MAX_PATH);
+
+    size_t nameLength = strlen(fd->cFileName) + 1;
+    size_t linkLength = hasLink ? strlen(link) + 1 : 0;
+    size_t recordSize = ALIGN_RECORD(sizeof(daemon_entry_t) + nameLength + linkLength);
+
+    if (snapshot->size + recordSize > *capacity)
+    {
+        size_t newCapacity = *capacity ? *capacity * 2 : DAEMON_PIPE_BUFFER;
+        while (newCapacity < snapshot->size + recordSize) newCapacity *= 2;
+
+        unsigned char *data = realloc(snapshot->data, newCapacity);
+        if (data == NULL) return FALSE;
+
+        snapshot->data = data;
+        *capacity = newCapacity;
+    }
+
+    unsigned char *record = snapshot->data + snapshot->size;
+    daemon_entry_t *entry = (daemon_entry_t *)record;
+
+    memset(record, 0, recordSize);
+    entry->attributes = fd->dwFileAttributes;
+    entry->reparseTag = fd->dwReserved0;
+    entry->creation = fd->ftCreationTime;
+    entry->access = fd->ftLastAccessTime;
+    entry->modification = fd->ftLastWriteTime;
+    entry->sizeHigh = fd->nFileSizeHigh;
+    entry->sizeLow = fd->nFileSizeLow;
+
+    entry->accessRights = asset.accessRights;
+    strcpy_s(entry->owner, OWNER_SIZE, asset.owner);
+    strcpy_s(entry->domain, DOMAIN_SIZE, asset.domain);
+
+    entry->nameLength = (DWORD)nameLength;
+    entry->linkLength = (DWORD)linkLength;
+
+    memcpy(record + sizeof(daemon_entry_t), fd->cFileName, nameLength);
+    if (hasLink) memcpy(record + sizeof(daemon_entry_t) + nameLength, link, linkLength);
+
+    snapshot->size += recordSize;
+    return TRUE;
+}
+
+/**
+ * @brief Enumerate and probe a directory. The change notification is created
+ * before the enumeration, a change while enumerating makes it stale.
+ *
+ * @param snapshot      snapshot with the directory to enumerate
+ * @return BOOL         TRUE if the directory can be enumerated, FALSE otherwise
+ */
+local_function BOOL BuildDaemonSnapshot(daemon_cache_entry_t *snapshot)
+{
+    char search[MAX_PATH] = { 0 };
+    WIN32_FIND_DATAA fd = { 0 };
+    size_t capacity = 0;
+
+    snapshot->change = FindFirstChangeNotificationA(snapshot->directory, FALSE, DAEMON_NOTIFY_FILTER);
+    snprintf(search, sizeof(search), "%s\\*", snapshot->directory);
+
+    HANDLE hFind = FindFirstFileExA(search, FindExInfoStandard, &fd, FindExSearchNameMatch, NULL, 0);
+    if (hFind == INVALID_HANDLE_VALUE) return FALSE;
+
+    do
+    {
+        if (!AppendDaemonEntry(snapshot, &capacity, &fd))
+        {
+            FindClose(hFind);
+            return FALSE;
+        }
+    } while (FindNextFileA(hFind, &fd));
+
+    FindClose(hFind);
+    return TRUE;
+}
+
+/**
+ * @brief Release a snapshot of the daemon cache.
+ *
+ * @param snapshot      snapshot to release
+ */
+local_function void ClearDaemonSnapshot(daemon_cache_entry_t *snapshot)
+{
+    if (snapshot->change != NULL && snapshot->change != INVALID_HANDLE_VALUE)
+    {
+        FindCloseChangeNotification(snapshot->change);
+    }
+
+    CHECK_DELETE(snapshot->data);
+    memset(snapshot, 0, sizeof(daemon_cache_entry_t));
+}
+
+/**
+ * @brief Get the snapshot of a directory, the cached one if it is still
+ * valid or a new one replacing the oldest snapshot.
+ *
+ * @param directory                 full path of the directory
+ * @return daemon_cache_entry_t*    the snapshot or NULL if the directory can not be enumerated
+ */
+local_function daemon_cache_entry_t *GetDaemonSnapshot(const char *directory)
+{
+    daemon_cache_entry_t *snapshot = &g_DaemonCache[0];
+    ++g_DaemonRequests;
+
+    for (size_t i = 0; i < DAEMON_CACHE_SIZE; ++i)
+    {
+        daemon_cache_entry_t *entry = &g_DaemonCache[i];
+
+        if (entry->directory[0] != '\0' && _stricmp(entry->directory, directory) == 0)
+        {
+            snapshot = entry;
+            break;
+        }
+
+        if (entry->lastUse < snapshot->lastUse) snapshot = entry;
+    }
+
+    // NOTE(Andrei): Without a change notification the snapshot can not be
+    //               validated, it is built again on each request.
+    BOOL valid = snapshot->directory[0] != '\0' && snapshot->change != NULL && snapshot->change != INVALID_HANDLE_VALUE &&
+                 WaitForSingleObject(snapshot->change, 0) == WAIT_TIMEOUT;
+
+    if (!valid)
+    {
+        ClearDaemonSnapshot(snapshot);
+        strcpy_s(snapshot->directory, MAX_PATH, directory);
+
+        if (!BuildDaemonSnapshot(snapshot))
+        {
+            ClearDaemonSnapshot(snapshot);
+            return NULL;
+        }
+    }
+
+    snapshot->lastUse = g_DaemonRequests;
+    return snapshot;
+}
+
+/**
+ * @brief Answer the request of a connected client.
+ *
+ * @param pipe      handle of the connected pipe
+ */
+local_function void ServeDaemonRequest(HANDLE pipe)
+{
+    daemon_request_t request = { 0 };
+    daemon_response_t response = { DAEMON_PROTOCOL, FALSE, 0 };
+
+    if (!ReadPipe(pipe, &request, sizeof(request)) || request.protocol != DAEMON_PROTOCOL)
+    {
+        return;
+    }
+
+    request.directory[MAX_PATH - 1] = '\0';
+    daemon_cache_entry_t *snapshot = GetDaemonSnapshot(request.directory);
+
+    if (snapshot == NULL)
+    {
+        WritePipe(pipe, &response, sizeof(response));
+        return;
+    }
+
+    response.found = TRUE;
+    response.size = snapshot->size;
+
+    if (WritePipe(pipe, &response, sizeof(response)))
+    {
+        WritePipe(pipe, snapshot->data, snapshot->size);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int RunDaemon()
+{
+    const char *name = GetDaemonPipeName();
+    SECURITY_ATTRIBUTES security = { 0 };
+
+    if (!GetDaemonPipeSecurity(&security))
+    {
+        printf_s("Can not create the security descriptor of the pipe \"%s\"\n", name);
+        return EXIT_FAILURE;
+    }
+
+    HANDLE pipe = CreateNamedPipeA
+    (
+        name, PIPE_ACCESS_DUPLEX | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        1, DAEMON_PIPE_BUFFER, DAEMON_PIPE_BUFFER, 0, &security
+    );
+
+    LocalFree(security.lpSecurityDescriptor);
+
+    if (pipe == INVALID_HANDLE_VALUE)
+    {
+        printf_s("Can not create the pipe \"%s\", the daemon may be already running\n", name);
+        return EXIT_FAILURE;
+    }
+
+    printf_s("Listening on %s\n", name);
+
+    // NOTE(Andrei): The requests are served one by one, a busy daemon
+    //               makes the clients list the directories themselves.
+    for (;;)
+    {
+        if (ConnectNamedPipe(pipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED)
+        {
+            ServeDaemonRequest(pipe);
+            FlushFileBuffers(pipe);
+        }
+
+        DisconnectNamedPipe(pipe);
+    }
+}
+
+BOOL RequestDaemonSnapshot(const char *directory, daemon_snapshot_t *snapshot)
+{
+    daemon_request_t request = { DAEMON_PROTOCOL };
+    daemon_response_t response = { 0 };
+
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    BOOL result = FALSE;
+
+    memset(snapshot, 0, sizeof(daemon_snapshot_t));
+    if (InterlockedCompareExchange(&g_DaemonUnavailable, FALSE, FALSE)) return FALSE;
+
+    DWORD length = GetFullPathNameA(directory, MAX_PATH, request.directory, NULL);
+    if (length == 0 || length >= MAX_PATH) return FALSE;
+
+    const char *name = GetDaemonPipeName();
+    pipe = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+
+    if (pipe == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY && WaitNamedPipeA(name, DAEMON_CONNECT_WAIT))
+    {
+        pipe = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+    }
+
+    // NOTE(Andrei): Not running or busy with another client, the directories
+    //               are listed by the process for the rest of the run
+    //               instead of waiting for the daemon on each of them.
+    if (pipe == INVALID_HANDLE_VALUE)
+    {
+        InterlockedExchange(&g_DaemonUnavailable, TRUE);
+        return FALSE;
+    }
+
+    // NOTE(Andrei): The paths are not sent to a pipe created by another
+    //               user, and its listings are not trusted.
+    if (!IsDaemonOfCurrentUser(pipe))
+    {
+        InterlockedExchange(&g_DaemonUnavailable, TRUE);
+        goto clean_up;
+    }
+
+    if (!WritePipe(pipe, &request, sizeof(request))) goto clean_up;
+    if (!ReadPipe(pipe, &response, sizeof(response))) goto clean_up;
+
+    if (response.protocol != DAEMON_PROTOCOL || !response.found) goto clean_up;
+    if (response.size > DAEMON_MAX_SNAPSHOT) goto clean_up;
+
+    snapshot->data = malloc((size_t)response.size + 1);
+    snapshot->size = (size_t)response.size;
+
+    if (snapshot->data == NULL || !ReadPipe(pipe, snapshot->data, snapshot->size))
+    {
+        DeleteDaemonSnapshot(snapshot);
+        goto clean_up;
+    }
+
+    result = TRUE;
+
+    clean_up:
+    CloseHandle(pipe);
+    return result;
+}
+
+const daemon_entry_t *NextDaemonEntry(daemon_snapshot_t *snapshot, WIN32_FIND_DATAA *fd)
+{
+    if (snapshot->data == NULL || snapshot->offset + sizeof(daemon_entry_t) > snapshot->size)
+    {
+        return NULL;
+    }
+
+    const daemon_entry_t *entry = (const daemon_entry_t *)(snapshot->data + snapshot->offset);
+    size_t recordSize = ALIGN_RECORD(sizeof(daemon_entry_t) + entry->nameLength + entry->linkLength);
+
+    if (entry->nameLength == 0 || entry->nameLength > MAX_PATH || entry->linkLength > MAX_PATH || snapshot->offset + recordSize > snapshot->size)
+    {
+        return NULL;
+    }
+
+    snapshot->offset += recordSize;
+    memset(fd, 0, sizeof(WIN32_FIND_DATAA));
+
+    fd->dwFileAttributes = entry->attributes;
+    fd->dwReserved0 = entry->reparseTag;
+    fd->ftCreationTime = entry->creation;
+    fd->ftLastAccessTime = entry->access;
+    fd->ftLastWriteTime = entry->modification;
+    fd->nFileSizeHigh = entry->sizeHigh;
+    fd->nFileSizeLow = entry->sizeLow;
+
+    memcpy(fd->cFileName, entry + 1, entry->nameLength);
+    fd->cFileName[MAX_PATH - 1] = '\0';
+
+    return entry;
+}
+
+const char *GetDaemonEntryLink(const daemon_entry_t *entry)
+{
+    if (entry->linkLength == 0) return NULL;
+    return (const char *)(entry + 1) + entry->nameLength;
+}
+
+void DeleteDaemonSnapshot(daemon_snapshot_t *snapshot)
+{
+    CHECK_DELETE(snapshot->data);
+    snapshot->size = snapshot->offset = 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Entry of a directory snapshot served by the daemon. It has the find
+ * data and the information that is expensive to probe (permissions, owner
+ * and link target). The name and the link follow the record.
+ *
+ * 'attributes'     : attributes of the find data
+ * 'reparseTag'     : reparse tag of the find data (dwReserved0)
+ * 'creation'       : creation time
+ * 'access'         : last access time
+ * 'modification'   : last write time
+ * 'sizeHigh'       : high part of the size
+ * 'sizeLow'        : low part of the size
+ *
+ * 'accessRights'   : access rights of the user running the daemon
+ * 'owner'          : owner of the asset
+ * 'domain'         : domain of the asset owner
+ *
+ * 'nameLength'     : characters of the name, '\0' included
+ * 'linkLength'     : characters of the link target, '\0' included (0 if there is none)
+ */
+typedef struct daemon_entry_t
+{
+    DWORD attributes, reparseTag;
+    FILETIME creation, access, modification;
+    DWORD sizeHigh, sizeLow;
+
+    access_rights_t accessRights;
+    char owner[OWNER_SIZE];
+    char domain[DOMAIN_SIZE];
+
+    DWORD nameLength, linkLength;
+} daemon_entry_t;
+
+/**
+ * @brief Snapshot of a directory received from the daemon, see
+ * 'RequestDaemonSnapshot'.
+ *
+ * 'data'       : records of the entries
+ * 'size'       : number of bytes of the records
+ * 'offset'     : offset of the next record
+ */
+typedef struct daemon_snapshot_t
+{
+    unsigned char *data;
+    size_t size, offset;
+} daemon_snapshot_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Serve the snapshots of the directories on a named pipe of the current
+ * user until the process is stopped. A snapshot is kept until a change
+ * notification of its directory is signaled, the owner cache stays warm
+ * between requests. Only one daemon per user can run, the pipe can only
+ * be opened by the user that runs it.
+ *
+ * @return int      EXIT_FAILURE if the pipe can not be created
+ */
+int RunDaemon();
+
+/**
+ * @brief Ask the daemon for the entries of a directory (the same as the
+ * 'directory\*' enumeration, '.' and '..' included). If the daemon is not
+ * running, is busy, or the pipe belongs to another user, it is not asked
+ * again for the rest of the process.
+ *
+ * @param directory     path of the directory
+ * @param snapshot      pointer where the snapshot is stored
+ * @return BOOL         TRUE if the daemon returned the snapshot, FALSE otherwise
+ */
+BOOL RequestDaemonSnapshot(const char *directory, daemon_snapshot_t *snapshot);
+
+/**
+ * @brief Get the next entry of a snapshot, the find data is filled as
+ * FindNextFile does.
+ *
+ * @param snapshot              pointer to the snapshot
+ * @param fd                    pointer where the find data is stored
+ * @return const daemon_entry_t* the entry or NULL at the end of the snapshot
+ */
+const daemon_entry_t *NextDaemonEntry(daemon_snapshot_t *snapshot, WIN32_FIND_DATAA *fd);
+
+/**
+ * @brief Target of a link entry.
+ *
+ * @param entry         pointer to the entry
+ * @return const char*  the target or NULL if it is not a link
+ */
+const char *GetDaemonEntryLink(const daemon_entry_t *entry);
+
+/**
+ * @brief Release the memory of a snapshot.
+ *
+ * @param snapshot      pointer to the snapshot
+ */
+void DeleteDaemonSnapshot(daemon_snapshot_t *snapshot);
@@ -0,0 +1,222 @@
+#include "datetime.h"
+#include "format.h"
+#include "types.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define TICKS_PER_SECOND    10000000LL  // FILETIME ticks (100 ns) in a second
+#define SECONDS_PER_DAY     86400LL     // seconds in a day
+#define DAYS_1601_TO_1970   134774LL    // days between FILETIME and Unix epochs
+
+/**
+ * @brief Calendar fields of a timestamp.
+ */
+typedef struct date_parts_t
+{
+    long long year;
+    unsigned int month, day;
+    unsigned int hour, minute, second;
+    unsigned long nanoseconds;
+} date_parts_t;
+
+// Context of the dates printed by the command line
+global_variable date_context_t g_DateContext = { "%d %b %H:%M", "%d %b  %Y", 0, "+0000", 0 };
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Split a local timestamp in calendar fields. The days are converted
+ * with the proleptic Gregorian algorithm of Howard Hinnant (civil_from_days),
+ * only integer operations are used.
+ *
+ * @param ticks     100 nanosecond ticks since 01 Jan 1601 (local time)
+ * @param parts     pointer where the fields are stored
+ */
+local_function void SplitTimestamp(long long ticks, date_parts_t *parts)
+{
+    if (ticks < 0) ticks = 0;
+
+    long long seconds = ticks / TICKS_PER_SECOND;
+    long long secondOfDay = seconds % SECONDS_PER_DAY;
+
+    parts->nanoseconds = (unsigned long)(ticks % TICKS_PER_SECOND) * 100;
+    parts->hour = (unsigned int)(secondOfDay / 3600);
+    parts->minute = (unsigned int)(secondOfDay / 60 % 60);
+    parts->second = (unsigned int)(secondOfDay % 60);
+
+    long long z = seconds / SECONDS_PER_DAY - DAYS_1601_TO_1970 + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+
+    unsigned long long doe = (unsigned long long)(z - era * 146097);
+    unsigned long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned long long mp = (5 * doy + 2) / 153;
+
+    parts->day = (unsigned int)(doy - (153 * mp + 2) / 5 + 1);
+    parts->month = (unsigned int)(mp < 10 ? mp + 3 : mp - 9);
+    parts->year = (long long)yoe + era * 400 + (parts->month <= 2);
+}
+
+/**
+ * @brief Copy a text to the output, it stops at the end of the buffer.
+ *
+ * @param at        where the text is written
+ * @param end       end of the buffer
+ * @param text      text to copy
+ * @return char*    position after the text
+ */
+local_function char *PutText(char *at, const char *end, const char *text)
+{
+    while (*text != '\0' && at < end) *at++ = *text++;
+    return at;
+}
+
+/**
+ * @brief Write the calendar fields following a strftime like format, the
+ * unknown conversions are written as they are.
+ *
+ * @param at        where the date is written
+ * @param end       end of the buffer
+ * @param format    format of the date
+ * @param parts     calendar fields
+ * @param context   calendar context (time zone)
+ * @return char*    position after the date
+ */
+local_function char *PutDate(char *at, const char *end, const char *format, const date_parts_t *parts, const date_context_t *context)
+{
+    // NOTE(Andrei): The month starts with 1 so add padding value for 0.
+    local_variable const char *m[13] =
+    {
+        "", "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+            "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    unsigned long long year = parts->year < 0 ? 0 : (unsigned long long)parts->year;
+
+    for (; *format != '\0' && at < end; ++format)
+    {
+        if (*format != '%' || format[1] == '\0')
+        {
+            *at++ = *format;
+            continue;
+        }
+
+        switch (*++format)
+        {
+            case 'Y': at = PutNumber(at, end, year, 4, '0'); break;
+            case 'y': at = PutNumber(at, end, year % 100, 2, '0'); break;
+            case 'm': at = PutNumber(at, end, parts->month, 2, '0'); break;
+            case 'd': at = PutNumber(at, end, parts->day, 2, '0'); break;
+            case 'e': at = PutNumber(at, end, parts->day, 2, ' '); break;
+            case 'b': at = PutText(at, end, m[parts->month]); break;
+            case 'H': at = PutNumber(at, end, parts->hour, 2, '0'); break;
+            case 'M': at = PutNumber(at, end, parts->minute, 2, '0'); break;
+            case 'S': at = PutNumber(at, end, parts->second, 2, '0'); break;
+            case 'N': at = PutNumber(at, end, parts->nanoseconds, 9, '0'); break;
+            case 'z': at = PutText(at, end, context->timeZoneText); break;
+            case 'F': at = PutDate(at, end, "%Y-%m-%d", parts, context); break;
+            case 'T': at = PutDate(at, end, "%H:%M:%S", parts, context); break;
+            case 'R': at = PutDate(at, end, "%H:%M", parts, context); break;
+            case '%': *at++ = '%'; break;
+
+            default:
+                at = PutText(at, end, "%");
+                if (at < end) *at++ = *format;
+            break;
+        }
+    }
+
+    return at;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BOOL CreateDateContext(date_context_t *context, const char *style)
+{
+    context->recentFormat = "%d %b %H:%M";
+    context->oldFormat = "%d %b  %Y";
+
+    if (style == NULL)
+    {
+        // Default style, already set
+    }
+    else if (strcmp(style, "iso") == 0)
+    {
+        context->recentFormat = "%m-%d %H:%M";
+        context->oldFormat = "%Y-%m-%d ";
+    }
+    else if (strcmp(style, "long-iso") == 0)
+    {
+        context->recentFormat = context->oldFormat = "%Y-%m-%d %H:%M";
+    }
+    else if (strcmp(style, "full") == 0)
+    {
+        context->recentFormat = context->oldFormat = "%Y-%m-%d %H:%M:%S.%N %z";
+    }
+    else if (style[0] == '+')
+    {
+        context->recentFormat = context->oldFormat = style + 1;
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    // NOTE(Andrei): UTC = local time + bias, the bias is in minutes and it
+    //               includes the daylight saving time if it is in effect now.
+    TIME_ZONE_INFORMATION tzi = { 0 };
+    DWORD zone = GetTimeZoneInformation(&tzi);
+    long bias = zone == TIME_ZONE_ID_INVALID ? 0 : tzi.Bias;
+
+    if (zone == TIME_ZONE_ID_DAYLIGHT) bias += tzi.DaylightBias;
+    else if (zone == TIME_ZONE_ID_STANDARD) bias += tzi.StandardBias;
+
+    context->timeZoneTicks = -(long long)bias * 60 * TICKS_PER_SECOND;
+
+    unsigned long offset = bias > 0 ? (unsigned long)bias : (unsigned long)-bias;
+    char *end = PutText(context->timeZoneText, context->timeZoneText + 1, bias > 0 ? "-" : "+");
+    end = PutNumber(end, context->timeZoneText + 5, offset / 60 * 100 + offset % 60, 4, '0');
+    *end = '\0';
+
+    FILETIME now = { 0 };
+    ULARGE_INTEGER ul = { 0 };
+    date_parts_t parts = { 0 };
+
+    GetSystemTimeAsFileTime(&now);
+    ul.LowPart = now.dwLowDateTime;
+    ul.HighPart = now.dwHighDateTime;
+
+    SplitTimestamp((long long)ul.QuadPart + context->timeZoneTicks, &parts);
+    context->currentYear = parts.year;
+
+    return TRUE;
+}
+
+size_t FormatDateTimeContext(const date_context_t *context, unsigned long long timestamp, char *buffer, size_t size)
+{
+    if (size == 0) return 0;
+
+    date_parts_t parts = { 0 };
+    SplitTimestamp((long long)timestamp + context->timeZoneTicks, &parts);
+
+    const char *format = parts.year == context->currentYear ? context->recentFormat : context->oldFormat;
+    char *end = PutDate(buffer, buffer + size - 1, format, &parts, context);
+
+    *end = '\0';
+    return (size_t)(end - buffer);
+}
+
+BOOL InitializeDateTime(const char *style)
+{
+    return CreateDateContext(&g_DateContext, style);
+}
+
+size_t FormatDateTime(unsigned long long timestamp, char *buffer, size_t size)
+{
+    return FormatDateTimeContext(&g_DateContext, timestamp, buffer, size);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Calendar context of the dates, see 'CreateDateContext'.
+ *
+ * 'recentFormat'   : format of the dates of the current year
+ * 'oldFormat'      : format of the dates of the other years
+ * 'timeZoneTicks'  : offset of the time zone in FILETIME ticks
+ * 'timeZoneText'   : offset of the time zone as text (+hhmm)
+ * 'currentYear'    : year of the current local date
+ */
+typedef struct date_context_t
+{
+    const char *recentFormat, *oldFormat;
+
+    long long timeZoneTicks;
+    char timeZoneText[8];
+
+    long long currentYear;
+} date_context_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Read the calendar context (current year and time zone offset) and
+ * select the format of the dates. The styles are:
+ *
+ * 'NULL'       : 01 Jan 10:00 this year, 01 Jan  2022 otherwise
+ * 'iso'        : 01-15 10:00 this year, 2022-01-15 otherwise
+ * 'long-iso'   : 2022-01-15 10:00
+ * 'full'       : 2022-01-15 10:00:00.123456700 +0100
+ * '+FORMAT'    : %Y %y %m %d %e %b %H %M %S %N %z %F %T %R and %%
+ *
+ * The offset of the time zone is the current one (as 'FileTimeToLocalFileTime'),
+ * it is not looked up for each date.
+ *
+ * @param context   pointer where the context is stored
+ * @param style     name of the style or NULL for the default one
+ * @return BOOL     TRUE if the style is valid, FALSE otherwise
+ */
+BOOL CreateDateContext(date_context_t *context, const char *style);
+
+/**
+ * @brief Format a FILETIME timestamp with a calendar context. The text is
+ * truncated if it does not fit.
+ *
+ * @param context       calendar context, see 'CreateDateContext'
+ * @param timestamp     100 nanosecond ticks since 01 Jan 1601 UTC
+ * @param buffer        buffer where the text is written
+ * @param size          size of the buffer (see 'DATE_SIZE')
+ * @return size_t       number of characters written
+ */
+size_t FormatDateTimeContext(const date_context_t *context, unsigned long long timestamp, char *buffer, size_t size);
+
+/**
+ * @brief Create the calendar context of the command line, see 'CreateDateContext'.
+ *
+ * @param style     name of the style or NULL for the default one
+ * @return BOOL     TRUE if the style is valid, FALSE otherwise
+ */
+BOOL InitializeDateTime(const char *style);
+
+/**
+ * @brief Format a FILETIME timestamp with the context of the command line
+ * (see 'InitializeDateTime'). The text is truncated if it does not fit.
+ *
+ * @param timestamp     100 nanosecond ticks since 01 Jan 1601 UTC
+ * @param buffer        buffer where the text is written
+ * @param size          size of the buffer (see 'DATE_SIZE')
+ * @return size_t       number of characters written
+ */
+size_t FormatDateTime(unsigned long long timestamp, char *buffer, size_t size);
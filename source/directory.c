@@ -2,6 +2,11 @@
 #include "types.h"
 #include "win32.h"
 #include "utils.h"
+#include "glob.h"
+#include "filter.h"
+#include "stats.h"
+#include "arena.h"
+#include "daemon.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
@@ -14,6 +19,10 @@
 // Check if the file/directory attribute is marked as hidden
 #define IS_HIDDEN(x)        ((x) & FILE_ATTRIBUTE_HIDDEN)
 
+// Check if the find data belongs to a symbolic link or a junction
+#define IS_LINK(fd)         (((fd)->dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && \
+                            ((fd)->dwReserved0 == IO_REPARSE_TAG_SYMLINK || (fd)->dwReserved0 == IO_REPARSE_TAG_MOUNT_POINT))
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -59,102 +68,46 @@ local_function BOOL StringEndsWith(const char *str, const char *suffix)
     return strncmp(str + lenstr - lensuffix, suffix, lensuffix) == 0;
 }
 
-/**
- * @brief Convert a FILETIME timestap to a human representation.  By default
- * the creation time it will be used, is case of sorting it will be used to
- * sort timestap required.
- *
- * ex: 01 Jan 10:00 or 01 Jan 2022
- *
- * If the current year and the year of the FILETIME is not the same it will
- * print the FILETIME year, otherwise the hour and minutes of the FILETIME.
- *
- * @param fd        pointer to Win32 data structure to access the timestapms
- * @param arguments arguments data structure to know which timestamp to use
- * @param asset     pointer to the asset of date is stored
- * @return BOOL     TRUE if can be converted, FALSE otherwise
- */
-local_function BOOL GetTimestaps(const WIN32_FIND_DATAA *fd, const arguments_t *arguments, asset_t *asset)
+void GetTimestaps(const WIN32_FIND_DATAA *fd, asset_t *asset)
 {
-    memset(asset->date, 0, DATE_SIZE);
     ULARGE_INTEGER ul = { 0 };
 
-    SYSTEMTIME systemTime = { 0 };
-    SYSTEMTIME currentSystemTime = { 0 };
-
-    FileTimeToSystemTime(&fd->ftCreationTime, &systemTime);
-    GetSystemTime(&currentSystemTime);
-
     ul.HighPart = fd->ftCreationTime.dwHighDateTime;
-    ul.LowPart = fd->ftCreationTime.dwHighDateTime;
+    ul.LowPart = fd->ftCreationTime.dwLowDateTime;
     asset->timestamp.creation = ul.QuadPart;
 
     ul.HighPart = fd->ftLastAccessTime.dwHighDateTime;
-    ul.LowPart = fd->ftLastAccessTime.dwHighDateTime;
+    ul.LowPart = fd->ftLastAccessTime.dwLowDateTime;
     asset->timestamp.access = ul.QuadPart;
 
     ul.HighPart = fd->ftLastWriteTime.dwHighDateTime;
-    ul.LowPart = fd->ftLastWriteTime.dwHighDateTime;
+    ul.LowPart = fd->ftLastWriteTime.dwLowDateTime;
     asset->timestamp.modification = ul.QuadPart;
-
-    switch (arguments->sortField)
-    {
-        case SORT_BY_LAST_ACCESSED: FileTimeToSystemTime(&fd->ftLastAccessTime, &systemTime); break;
-        case SORT_BY_LAST_MODIFIED: FileTimeToSystemTime(&fd->ftLastWriteTime, &systemTime); break;
-        default: break; // Don't change sort
-    }
-
-    // NOTE(Andrei): SystemTime month starts with 1
-    //               so add padding value for 0.
-    local_variable const char *m[13] =
-    {
-        "", "Jan", "Feb", "Mar", "Apr", "May", "Jun",
-            "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
-    };
-
-    if (currentSystemTime.wYear != systemTime.wYear)
-    {
-        return sprintf_s
-        (
-            asset->date, DATE_SIZE,
-            "%02d %s  %d",
-
-            systemTime.wDay, m[systemTime.wMonth],
-            systemTime.wYear
-        ) == S_OK;
-    }
-
-    return sprintf_s
-    (
-        asset->date, DATE_SIZE,
-        "%02d %s %02d:%02d",
-
-        systemTime.wDay, m[systemTime.wMonth],
-        systemTime.wHour, systemTime.wMinute
-    ) == S_OK;
 }
 
 /**
  * @brief Helper function to resize the asset array.  The capacity it is
- * increased by half of the previous one.
+ * increased by half of the previous one. The array is allocated on the
+ * arena, the previous one is released when the arena is reset.
  *
  * @param container pointer to the directory container
+ * @param arena     arena where the container is allocated
  * @return *directory_t pointer to the directory
  */
-local_function directory_t *ResizeAssetArray(directory_t **container)
+local_function directory_t *ResizeAssetArray(directory_t **container, arena_t *arena)
 {
     if (container == NULL || (*container) == NULL)
     {
         size_t containerSize = sizeof(directory_t) + sizeof(asset_t) * STARTUP_CONTAINER_SIZE;
-        directory_t *retData = malloc(containerSize);
+        directory_t *retData = PushArena(arena, containerSize);
 
         if (retData == NULL) { return FALSE; }
         if (container != NULL) (*container) = retData;
 
         retData->capacity = STARTUP_CONTAINER_SIZE;
+        retData->arena = arena;
         retData->size = 0;
 
-        memset(retData, 0, sizeof(containerSize));
         return retData;
     }
 
@@ -166,26 +119,17 @@ local_function directory_t *ResizeAssetArray(directory_t **container)
     size_t newCapacity = (size_t)((*container)->capacity + (*container)->capacity * 0.5f + 0.5f);
     size_t containerSize = sizeof(directory_t) + sizeof(asset_t) * newCapacity;
 
-    directory_t *newRetData = realloc(*container, containerSize);
+    directory_t *newRetData = PushArena(arena, containerSize);
     if (newRetData == NULL) { return FALSE; }
 
-    size_t memSetSize = (newCapacity - newRetData->size) * sizeof(asset_t);
-    memset(&newRetData->data[newRetData->size], 0, memSetSize);
-
+    memcpy(newRetData, *container, sizeof(directory_t) + sizeof(asset_t) * (*container)->size);
     newRetData->capacity = newCapacity;
     (*container) = newRetData;
 
     return (*container);
 }
 
-/**
- * @brief Get the metadata based on the asset extension. If the extension is not
- * found a predefined metadata based on the type it will be returned.
- *
- * @param asset                     valid pointer to the asset
- * @return const asset_metadata_t*  pointer to the metadata structure
- */
-local_function const asset_metadata_t *GetAssetMetadata(const asset_t *asset)
+const asset_metadata_t *GetAssetMetadata(const asset_t *asset)
 {
     char name[MAX_PATH] = { 0 };
     strcpy_s(name, MAX_PATH, asset->name);
@@ -237,80 +181,604 @@ local_function const asset_metadata_t *GetAssetMetadata(const asset_t *asset)
     return &oth;
 }
 
+/**
+ * @brief Decide if a sub-directory has to be listed on a recursive listing.
+ * The decision is taken from the attributes returned by the enumeration,
+ * only reparse points (links, mount points) are opened to check the volume
+ * when '--one-file-system' is used. Links are only followed with '-L'.
+ *
+ * @param dir           directory being listed
+ * @param fd            pointer to Win32 data structure of the asset
+ * @param assetPath     full path of the asset
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if it has to be listed, FALSE otherwise
+ */
+local_function BOOL ShouldRecurse(const directory_list_t *dir, const WIN32_FIND_DATAA *fd, const char *assetPath, const arguments_t *arguments)
+{
+    if (!(fd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || IsDotPath(fd->cFileName))
+    {
+        return FALSE;
+    }
+
+    if (dir->depth >= arguments->maxDepth)
+    {
+        return FALSE;
+    }
+
+    if (IS_LINK(fd) && !arguments->followLinks)
+    {
+        return FALSE;
+    }
+
+    for (size_t i = 0; i < arguments->numPrune; ++i)
+    {
+        if (MatchPattern(arguments->prune[i], fd->cFileName)) return FALSE;
+    }
+
+    // NOTE(Andrei): Only a reparse point can lead to another volume.
+    if (arguments->oneFileSystem && (fd->dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+    {
+        file_identity_t identity = { 0 };
+        return GetFileIdentity(assetPath, &identity) && identity.volume == dir->volume;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Match an asset against the glob pattern of the directory that is
+ * being listed. The sub-directories that can still match the remaining
+ * pattern are added to the list of directories to list, the others are
+ * never visited.
+ *
+ * @param dir           directory being listed
+ * @param assetPath     full path of the asset
+ * @param fd            pointer to Win32 data structure of the asset
+ * @param recurse       the asset is a directory that can be listed
+ * @param pattern       pattern relative to the directory being listed
+ * @param arguments     pointer to the arguments where directories are added
+ * @param globstar      set to TRUE when the asset itself is added with a
+ *                      pattern that starts with a globstar
+ * @return BOOL         TRUE if the asset has to be listed, FALSE otherwise
+ */
+local_function BOOL MatchGlobAsset(const directory_list_t *dir, const char *assetPath, const WIN32_FIND_DATAA *fd, BOOL recurse, const char *pattern, arguments_t *arguments, BOOL *globstar)
+{
+    char segment[MAX_PATH] = { 0 };
+    const char *rest = SplitPatternSegment(pattern, segment, sizeof(segment));
+
+    // NOTE(Andrei): The globstar matches this directory and
+    //               any of the sub-directories.
+    if (strcmp(segment, "**") == 0)
+    {
+        BOOL subsumed = FALSE;
+        BOOL match = rest == NULL || MatchGlobAsset(dir, assetPath, fd, recurse, rest, arguments, &subsumed);
+
+        // NOTE(Andrei): A globstar added by the rest of the pattern for the
+        //               same directory is a suffix of this pattern and already
+        //               matches all it does, adding both would list the
+        //               directory twice and grow with every globstar.
+        if (recurse && !subsumed) AddPatternToList(arguments, dir, assetPath, pattern);
+        if (recurse) *globstar = TRUE;
+
+        return match;
+    }
+
+    if (rest == NULL)
+    {
+        return MatchPattern(segment, fd->cFileName);
+    }
+
+    if (recurse && MatchPattern(segment, fd->cFileName))
+    {
+        char childPath[MAX_PATH] = { 0 };
+        strcpy_s(childPath, MAX_PATH, assetPath);
+
+        if (ResolveLiteralSegments(childPath, MAX_PATH, &rest))
+        {
+            AddPatternToList(arguments, dir, childPath, rest);
+            SplitPatternSegment(rest, segment, sizeof(segment));
+
+            if (strcmp(childPath, assetPath) == 0 && strcmp(segment, "**") == 0)
+            {
+                *globstar = TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Copy the directory prefix of the assets ('currentPath' and a
+ * delimiter) to the path buffer of the iterator, the names of the assets
+ * are copied after it (see 'SetAssetPath').
+ *
+ * @param it    iterator of the directory
+ */
+local_function void SetAssetPathPrefix(directory_iterator_t *it)
+{
+    size_t length = strlen(it->currentPath);
+    memcpy(it->path, it->currentPath, length);
+
+    if (length + 1 < MAX_PATH) it->path[length++] = '\\';
+
+    it->path[length] = '\0';
+    it->pathLength = length;
+}
+
+/**
+ * @brief Build the full path of an asset appending its name to the prefix
+ * already on the buffer, the name is truncated if it does not fit.
+ *
+ * @param it        iterator of the directory
+ * @param name      name of the asset
+ */
+local_function void SetAssetPath(directory_iterator_t *it, const char *name)
+{
+    size_t length = strlen(name);
+    size_t space = MAX_PATH - it->pathLength - 1;
+
+    length = length < space ? length : space;
+    memcpy(it->path + it->pathLength, name, length);
+    it->path[it->pathLength + length] = '\0';
+}
+
+/**
+ * @brief Copy a directory record to the Win32 find data, the same fields
+ * 'FindNextFileA' fills. The names are converted to the ANSI code page.
+ *
+ * @param record    record returned by 'GetFileInformationByHandleEx'
+ * @param fd        pointer where the find data is stored
+ * @return BOOL     TRUE if the name can be converted, FALSE otherwise
+ */
+local_function BOOL TranslateDirectoryRecord(const FILE_ID_BOTH_DIR_INFO *record, WIN32_FIND_DATAA *fd)
+{
+    memset(fd, 0, sizeof(WIN32_FIND_DATAA));
+    fd->dwFileAttributes = record->FileAttributes;
+
+    fd->ftCreationTime.dwLowDateTime = record->CreationTime.LowPart;
+    fd->ftCreationTime.dwHighDateTime = (DWORD)record->CreationTime.HighPart;
+    fd->ftLastAccessTime.dwLowDateTime = record->LastAccessTime.LowPart;
+    fd->ftLastAccessTime.dwHighDateTime = (DWORD)record->LastAccessTime.HighPart;
+    fd->ftLastWriteTime.dwLowDateTime = record->LastWriteTime.LowPart;
+    fd->ftLastWriteTime.dwHighDateTime = (DWORD)record->LastWriteTime.HighPart;
+
+    fd->nFileSizeLow = record->EndOfFile.LowPart;
+    fd->nFileSizeHigh = (DWORD)record->EndOfFile.HighPart;
+
+    // NOTE(Andrei): As on the find data, the reparse tag of a reparse
+    //               point is given on the place of the EA size.
+    if (record->FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+    {
+        fd->dwReserved0 = record->EaSize;
+    }
+
+    int length = WideCharToMultiByte(CP_ACP, 0, record->FileName, (int)(record->FileNameLength / sizeof(WCHAR)), fd->cFileName, MAX_PATH - 1, NULL, NULL);
+    if (length <= 0) return FALSE;
+
+    fd->cFileName[length] = '\0';
+
+    length = WideCharToMultiByte(CP_ACP, 0, record->ShortName, (int)(record->ShortNameLength / sizeof(WCHAR)), fd->cAlternateFileName, ARRAY_SIZE(fd->cAlternateFileName) - 1, NULL, NULL);
+    fd->cAlternateFileName[length > 0 ? length : 0] = '\0';
+
+    return TRUE;
+}
+
+/**
+ * @brief Read the next record of a directory opened by handle, the buffer is
+ * filled again once all its records are consumed.
+ *
+ * @param it        iterator of the directory
+ * @return BOOL     TRUE if a record is read, FALSE at the end
+ */
+local_function BOOL NextDirectoryRecord(directory_iterator_t *it)
+{
+    for (;;)
+    {
+        if (it->record == NULL)
+        {
+            ++it->calls;
+
+            if (!GetFileInformationByHandleEx(it->hDirectory, FileIdBothDirectoryInfo, it->records, DIRECTORY_RECORDS_SIZE))
+            {
+                return FALSE;
+            }
+
+            it->record = (const FILE_ID_BOTH_DIR_INFO *)it->records;
+        }
+
+        const FILE_ID_BOTH_DIR_INFO *record = it->record;
+        it->record = record->NextEntryOffset ? (const FILE_ID_BOTH_DIR_INFO *)((const BYTE *)record + record->NextEntryOffset) : NULL;
+        it->fileId = record->FileId;
+
+        if (TranslateDirectoryRecord(record, &it->fd))
+        {
+            return TRUE;
+        }
+    }
+}
+
+/**
+ * @brief Open a whole directory to read its records by handle, a single
+ * call returns many records and the file ids of the assets. The file
+ * systems that do not support it are enumerated with 'FindFirstFileExA'.
+ *
+ * @param it        iterator of the directory
+ * @param search    search path of the directory, ending with '*'
+ * @return BOOL     TRUE if the directory can be read by handle, FALSE otherwise
+ */
+local_function BOOL OpenDirectoryHandle(directory_iterator_t *it, const char *search)
+{
+    char path[MAX_PATH] = { 0 };
+    strcpy_s(path, MAX_PATH, search);
+
+    // NOTE(Andrei): Open the directory the search is done on, "C:\*" is
+    //               the root of the drive and "C:" is not.
+    size_t length = strlen(path);
+    if (length > 0 && path[length - 1] == '*') path[length - 1] = '\0';
+
+    it->hDirectory = CreateFileA(path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (it->hDirectory == INVALID_HANDLE_VALUE) return FALSE;
+
+    it->records = malloc(DIRECTORY_RECORDS_SIZE);
+    it->found = it->records != NULL && NextDirectoryRecord(it);
+
+    // NOTE(Andrei): The root of a drive has no '.' and '..', it can be
+    //               empty, any other error falls back to 'FindFirstFileExA'.
+    if (it->found || (it->records != NULL && GetLastError() == ERROR_NO_MORE_FILES))
+    {
+        return TRUE;
+    }
+
+    CloseHandle(it->hDirectory);
+    CHECK_DELETE(it->records);
+
+    it->hDirectory = INVALID_HANDLE_VALUE;
+    it->calls = 0;
+
+    return FALSE;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
-directory_t *GetDirectoryContent(const char *path, arguments_t *arguments)
+BOOL OpenDirectoryIterator(directory_iterator_t *it, directory_list_t *dir, const arguments_t *arguments)
 {
     char buffer[MAX_PATH] = { 0 };
-    WIN32_FIND_DATAA fd = { 0 };
 
-    if (strstr(path, "*") || IsValidDocument(path))
+    const char *path = dir->path;
+    const char *pattern = dir->pattern;
+    stats_timer_t timer = StartStatsTimer();
+
+    // NOTE(Andrei): Only the enumerations of a whole directory can be
+    //               served by the daemon.
+    BOOL wholeDirectory = FALSE;
+
+    memset(it, 0, sizeof(directory_iterator_t));
+    it->hFind = INVALID_HANDLE_VALUE;
+    it->hDirectory = INVALID_HANDLE_VALUE;
+    it->dir = dir;
+
+    const char *inner = NULL;
+
+    if (SplitArchivePath(path, buffer, sizeof(buffer), &inner))
+    {
+        BOOL opened = OpenArchiveDirectory(&it->archive, buffer, inner);
+        StopStatsProbe(STATS_PROBE_ATTRIBUTES, timer);
+
+        if (!opened) return FALSE;
+
+        // NOTE(Andrei): The members have no security descriptor of their
+        //               own, they show the permissions and the owner of
+        //               the archive.
+        it->archiveAsset.name = "";
+        GetPermissions(buffer, &it->archiveAsset);
+        GetOwnerAndDomain(buffer, &it->archiveAsset);
+
+        it->found = NextArchiveEntry(&it->archive, &it->fd);
+        GetDirectoryFromPath(path, it->currentPath, MAX_PATH);
+
+        if (it->archive.document)
+        {
+            char *c = (char *)FindLastDelimiter(it->currentPath, "\\/");
+            if (c != NULL) *c = '\0';
+        }
+
+        SetAssetPathPrefix(it);
+        return TRUE;
+    }
+
+    if (pattern[0] != '\0' && IsValidDirectory(path))
+    {
+        // NOTE(Andrei): Use the first segment as search filter, a
+        //               globstar needs all the sub-directories.
+        char segment[MAX_PATH] = { 0 };
+        SplitPatternSegment(pattern, segment, sizeof(segment));
+
+        wholeDirectory = strcmp(segment, "**") == 0;
+        snprintf(buffer, sizeof(buffer), "%s\\%s", path, wholeDirectory ? "*" : segment);
+    }
+    else if (strstr(path, "*") || IsValidDocument(path))
     {
         snprintf(buffer, sizeof(buffer), "%s", path);
     }
     else if (IsValidDirectory(path))
     {
+        wholeDirectory = TRUE;
         snprintf(buffer, sizeof(buffer), "%s%s", path, "\\*");
     }
     else
     {
-        return NULL;
+        StopStatsProbe(STATS_PROBE_ATTRIBUTES, timer);
+        return FALSE;
     }
 
-    HANDLE hFind = FindFirstFileExA(buffer, FindExInfoStandard, &fd, FindExSearchNameMatch, NULL, 0);
-    if (hFind == INVALID_HANDLE_VALUE) return NULL;
+    StopStatsProbe(STATS_PROBE_ATTRIBUTES, timer);
+    timer = StartStatsTimer();
 
-    directory_t *retData = NULL;
-    char currentPath[MAX_PATH] = { 0 };
-    GetDirectoryFromPath(path, currentPath, MAX_PATH);
+    if (wholeDirectory && !arguments->noDaemon && RequestDaemonSnapshot(path, &it->snapshot))
+    {
+        it->entry = NextDaemonEntry(&it->snapshot, &it->fd);
+        it->found = it->entry != NULL;
+    }
+    else if (wholeDirectory && OpenDirectoryHandle(it, buffer))
+    {
+        // NOTE(Andrei): The first record is already read.
+    }
+    else
+    {
+        it->hFind = FindFirstFileExA(buffer, FindExInfoStandard, &it->fd, FindExSearchNameMatch, NULL, 0);
+        it->found = it->hFind != INVALID_HANDLE_VALUE;
+    }
+
+    CountStatsCalls(STATS_PROBE_FIND, 1, 1);
+    StopStatsProbe(STATS_PROBE_FIND, timer);
+
+    if (it->hFind == INVALID_HANDLE_VALUE && it->hDirectory == INVALID_HANDLE_VALUE && it->snapshot.data == NULL) return FALSE;
+
+    GetDirectoryFromPath(path, it->currentPath, MAX_PATH);
+    SetAssetPathPrefix(it);
+
+    if (arguments->oneFileSystem && dir->depth == 0)
+    {
+        file_identity_t identity = { 0 };
+        timer = StartStatsTimer();
+
+        GetFileIdentity(it->currentPath, &identity);
+        dir->volume = identity.volume;
+
+        StopStatsProbe(STATS_PROBE_IDENTITY, timer);
+    }
+
+    return TRUE;
+}
+
+BOOL NextDirectoryAsset(directory_iterator_t *it, arguments_t *arguments, asset_t *asset)
+{
+    const WIN32_FIND_DATAA *fd = &it->fd;
+    const char *pattern = it->dir->pattern;
 
-    do
+    for (;; it->consumed = TRUE)
     {
-        if (ResizeAssetArray(&retData) == NULL)
+        // NOTE(Andrei): The asset returned by the previous call points to
+        //               the find data, the next entry is read on this call.
+        if (it->consumed && it->archive.open)
         {
-            FindClose(hFind);
-            return retData;
+            it->found = NextArchiveEntry(&it->archive, &it->fd);
+            it->consumed = FALSE;
+        }
+        else if (it->consumed && it->snapshot.data != NULL)
+        {
+            it->entry = NextDaemonEntry(&it->snapshot, &it->fd);
+            it->found = it->entry != NULL;
+            it->consumed = FALSE;
+        }
+        else if (it->consumed && it->hDirectory != INVALID_HANDLE_VALUE)
+        {
+            it->found = NextDirectoryRecord(it);
+            it->consumed = FALSE;
+        }
+        else if (it->consumed)
+        {
+            it->found = FindNextFileA(it->hFind, &it->fd);
+            it->consumed = FALSE;
+            ++it->calls;
+        }
+
+        if (!it->found)
+        {
+            return FALSE;
         }
 
-        if (arguments->showAlmostAll && IsDotPath(fd.cFileName))
+        if (arguments->showAlmostAll && IsDotPath(fd->cFileName))
         {
             continue;
         }
 
-        if (!arguments->showAll && IsHiddenOrDot(fd.dwFileAttributes, fd.cFileName))
+        if (!arguments->showAll && IsHiddenOrDot(fd->dwFileAttributes, fd->cFileName))
         {
             continue;
         }
 
-        size_t index = retData->size++;
-        asset_t *asset = &retData->data[index];
+        SetAssetPath(it, fd->cFileName);
+        BOOL recurse = (arguments->recursiveList || pattern[0] != '\0') && ShouldRecurse(it->dir, fd, it->path, arguments);
+        BOOL globstar = FALSE;
+
+        if (pattern[0] != '\0' && !MatchGlobAsset(it->dir, it->path, fd, recurse, pattern, arguments, &globstar))
+        {
+            continue;
+        }
 
         memset(asset, 0, sizeof(asset_t));
-        snprintf(buffer, sizeof(buffer), "%s\\%s", currentPath, fd.cFileName);
 
-        strcpy_s(asset->name, PATH_SIZE, fd.cFileName);
-        strcpy_s(asset->path, PATH_SIZE, buffer);
+        asset->name = fd->cFileName;
+        asset->path = it->path;
+        TranslateAttributes(fd->dwFileAttributes, asset);
 
-        GetPermissions(buffer, asset);
-        GetOwnerAndDomain(buffer, asset);
+        // NOTE(Andrei): Recurse before filtering, a directory rejected
+        //               by the filter can still have matching assets.
+        if (recurse && pattern[0] == '\0')
+        {
+            AddPatternToList(arguments, it->dir, it->path, "");
+        }
+
+        if (!EvaluateFilter(arguments->filter, FILTER_STAGE_NAME, asset))
+        {
+            continue;
+        }
 
-        GetTimestaps(&fd, arguments, asset);
-        TranslateAttributes(fd.dwFileAttributes, asset);
+        stats_timer_t timer = StartStatsTimer();
+        GetTimestaps(fd, asset);
+        asset->size = TranslateFileSize(&it->fd);
+        StopStatsProbe(STATS_PROBE_TIMESTAMPS, timer);
 
-        asset->size = TranslateFileSize(&fd);
+        if (!EvaluateFilter(arguments->filter, FILTER_STAGE_STAT, asset))
+        {
+            continue;
+        }
+
+        if (it->entry != NULL)
+        {
+            // NOTE(Andrei): Already probed by the daemon.
+            asset->accessRights = it->entry->accessRights;
+            strcpy_s(asset->owner, OWNER_SIZE, it->entry->owner);
+            strcpy_s(asset->domain, DOMAIN_SIZE, it->entry->domain);
+        }
+        else if (it->archive.open)
+        {
+            asset->accessRights = it->archiveAsset.accessRights;
+            strcpy_s(asset->owner, OWNER_SIZE, it->archiveAsset.owner);
+            strcpy_s(asset->domain, DOMAIN_SIZE, it->archiveAsset.domain);
+        }
+        else
+        {
+            // NOTE(Andrei): Open the asset once by its id relative to the
+            //               directory, the probes use the handle and the
+            //               path is not walked again. The links keep the
+            //               path probes, they follow the link.
+            HANDLE hAsset = INVALID_HANDLE_VALUE;
+            timer = StartStatsTimer();
+
+            if (it->hDirectory != INVALID_HANDLE_VALUE && !asset->type.symlink)
+            {
+                hAsset = OpenAssetById(it->hDirectory, it->fileId);
+            }
+
+            if (hAsset != INVALID_HANDLE_VALUE) GetPermissionsByHandle(hAsset, asset);
+            else GetPermissions(it->path, asset);
+
+            StopStatsProbe(STATS_PROBE_PERMISSIONS, timer);
+            timer = StartStatsTimer();
+
+            if (hAsset != INVALID_HANDLE_VALUE) GetOwnerAndDomainByHandle(hAsset, asset);
+            else GetOwnerAndDomain(it->path, asset);
+
+            StopStatsProbe(STATS_PROBE_OWNER, timer);
+
+            if (hAsset != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(hAsset);
+                CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 0);
+            }
+        }
+
+        if (!EvaluateFilter(arguments->filter, FILTER_STAGE_OWNER, asset))
+        {
+            continue;
+        }
+
+        timer = StartStatsTimer();
         asset->metadata = GetAssetMetadata(asset);
+        StopStatsProbe(STATS_PROBE_METADATA, timer);
+
+        if (asset->type.symlink && it->entry != NULL)
+        {
+            asset->link = GetDaemonEntryLink(it->entry);
+        }
+        else if (asset->type.symlink)
+        {
+            timer = StartStatsTimer();
+
+            if (GetLinkTarget(it->path, it->link, MAX_PATH))
+            {
+                asset->link = it->link;
+            }
+
+            StopStatsProbe(STATS_PROBE_LINK, timer);
+        }
+
+        it->consumed = TRUE;
+        return TRUE;
+    }
+}
+
+void CloseDirectoryIterator(directory_iterator_t *it)
+{
+    DeleteDaemonSnapshot(&it->snapshot);
+    CloseArchiveDirectory(&it->archive);
+    CHECK_DELETE(it->records);
+
+    it->entry = NULL;
+    it->record = NULL;
+
+    if (it->hDirectory != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(it->hDirectory);
+        CountStatsCalls(STATS_PROBE_FIND, it->calls + 1, 0);
+
+        it->hDirectory = INVALID_HANDLE_VALUE;
+    }
 
-        if (asset->type.symlink)
+    if (it->hFind == INVALID_HANDLE_VALUE) return;
+
+    // NOTE(Andrei): One FindNextFile call per entry, the last one is the
+    //               call that ends the enumeration, and the FindClose.
+    FindClose(it->hFind);
+    CountStatsCalls(STATS_PROBE_FIND, it->calls + 1, 0);
+
+    it->hFind = INVALID_HANDLE_VALUE;
+}
+
+BOOL CopyAssetToArena(asset_t *asset, arena_t *arena)
+{
+    asset->name = PushArenaString(arena, asset->name);
+    asset->path = PushArenaString(arena, asset->path);
+
+    if (asset->link != NULL)
+    {
+        asset->link = PushArenaString(arena, asset->link);
+        if (asset->link == NULL) return FALSE;
+    }
+
+    return asset->name != NULL && asset->path != NULL;
+}
+
+directory_t *GetDirectoryContent(directory_list_t *dir, arguments_t *arguments, arena_t *arena)
+{
+    directory_iterator_t it;
+    directory_t *retData = NULL;
+
+    if (!OpenDirectoryIterator(&it, dir, arguments))
+    {
+        return NULL;
+    }
+
+    while (ResizeAssetArray(&retData, arena) != NULL)
+    {
+        asset_t *asset = &retData->data[retData->size];
+
+        if (!NextDirectoryAsset(&it, arguments, asset))
         {
-            GetLinkTarget(buffer, asset);
+            break;
         }
 
-        if (arguments->recursiveList && asset->type.directory && !IsDotPath(fd.cFileName))
+        // NOTE(Andrei): The asset points to the buffers of the iterator
+        //               until it is copied to the arena.
+        if (CopyAssetToArena(asset, arena))
         {
-            AddDirectoryToList(arguments, buffer);
+            ++retData->size;
         }
-    } while (FindNextFileA(hFind, &fd));
+    }
 
-    FindClose(hFind);
+    CloseDirectoryIterator(&it);
     return retData;
 }
@@ -1,14 +1,151 @@
 #pragma once
 
 #include "types.h"
+#include "daemon.h"
+#include "archive.h"
+
+/**
+ * @brief State of the enumeration of a directory, it returns the assets one
+ * by one as they are found (see 'NextDirectoryAsset').
+ *
+ * 'dir'            : directory being listed
+ * 'hFind'          : enumeration handle
+ * 'fd'             : Win32 find data of the current entry
+ *
+ * 'currentPath'    : directory of the assets
+ * 'path'           : full path of the current asset
+ * 'link'           : target of the current asset if it is a symbolic link
+ *
+ * 'snapshot'       : entries received from the daemon, see 'daemon.h'
+ * 'entry'          : current entry of the snapshot, NULL if enumerating without the daemon
+ *
+ * 'archive'        : members of the directory inside an archive, see 'archive.h'
+ * 'archiveAsset'   : permissions and owner of the archive, shared by its members
+ *
+ * 'hDirectory'     : handle of the directory when its records are read by handle,
+ *                    the assets are opened relative to it by their file id
+ * 'records'        : buffer of the directory records ('DIRECTORY_RECORDS_SIZE' bytes)
+ * 'record'         : next record of the buffer, NULL when it has to be read again
+ * 'fileId'         : file id of the current entry
+ *
+ * 'pathLength'     : length of the directory prefix of 'path', the names are copied after it
+ * 'calls'          : number of FindNextFile (or directory records) calls
+ * 'found'          : the find data holds an entry
+ * 'consumed'       : the entry of the find data was already processed
+ */
+typedef struct directory_iterator_t
+{
+    directory_list_t *dir;
+    HANDLE hFind;
+    WIN32_FIND_DATAA fd;
+
+    char currentPath[MAX_PATH];
+    char path[MAX_PATH];
+    char link[MAX_PATH];
+
+    daemon_snapshot_t snapshot;
+    const daemon_entry_t *entry;
+
+    archive_directory_t archive;
+    asset_t archiveAsset;
+
+    HANDLE hDirectory;
+    BYTE *records;
+    const FILE_ID_BOTH_DIR_INFO *record;
+    LARGE_INTEGER fileId;
+
+    size_t pathLength;
+    size_t calls;
+    BOOL found, consumed;
+} directory_iterator_t;
+
+/**
+ * @brief Start the enumeration of a directory, see 'GetDirectoryContent' for
+ * the paths and patterns that are accepted. The whole directories are asked
+ * to the daemon first (unless '--no-daemon' is used), if it is not running
+ * they are enumerated by the process. The paths that go through a .zip or
+ * .tar archive list the members of the archive (see 'SplitArchivePath').
+ *
+ * The whole directories are read by handle when the file system supports
+ * it, their assets are then opened by file id relative to the directory
+ * instead of walking their full path again for each probe.
+ *
+ * @param it            iterator to initialize
+ * @param dir           directory to list, its path and its glob pattern
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if the directory can be listed, FALSE otherwise
+ */
+BOOL OpenDirectoryIterator(directory_iterator_t *it, directory_list_t *dir, const arguments_t *arguments);
+
+/**
+ * @brief Get the next asset of the enumeration that passes the hidden, glob
+ * and filter checks, the sub-directories are added to the list of directories
+ * to list as they are found. The strings of the asset point to the buffers
+ * of the iterator, they are valid until the next call (see 'CopyAssetToArena').
+ *
+ * @param it            iterator of the directory
+ * @param arguments     pointer to the arguments where directories are added
+ * @param asset         pointer where the asset is stored
+ * @return BOOL         TRUE if an asset is returned, FALSE at the end
+ */
+BOOL NextDirectoryAsset(directory_iterator_t *it, arguments_t *arguments, asset_t *asset);
+
+/**
+ * @brief End the enumeration of a directory.
+ *
+ * @param it            iterator of the directory
+ */
+void CloseDirectoryIterator(directory_iterator_t *it);
+
+/**
+ * @brief Copy the strings of an asset to the arena, they are valid until the
+ * arena is reset.
+ *
+ * @param asset         pointer to the asset
+ * @param arena         arena where the strings are allocated
+ * @return BOOL         TRUE if there is enough memory, FALSE otherwise
+ */
+BOOL CopyAssetToArena(asset_t *asset, arena_t *arena);
 
 /**
  * @brief Get the assets inside a given path. Wild cards can be used
  * for the asset name, the wild card is represented by '*'.
  * ex: C:\Windows\System32\*.dll
  *
- * @param directory         char pointer to the directory path
+ * A path can continue inside a .zip or .tar archive, its members are listed
+ * as assets without extracting them.
+ * ex: D:\builds\bundle.zip\bin\x64
+ *
+ * If a glob pattern is given only the assets matching it are returned and
+ * the sub-directories that can still match it are added to the list of
+ * directories to list. On recursive listings the sub-directories are added
+ * based on the depth, prune and volume arguments.
+ * ex: "C:\src" and "**\test_*.cpp"
+ *
+ * The container and the strings of the assets are allocated on the arena,
+ * they are valid until the arena is reset.
+ *
+ * @param dir               directory to list, its path and its glob pattern
  * @param arguments         pointer to the parsed arguments structure
+ * @param arena             arena where the assets are allocated
  * @return directory_t*     container with the assets information or NULL otherwise
  */
-directory_t *GetDirectoryContent(const char *path, arguments_t *arguments);
+directory_t *GetDirectoryContent(directory_list_t *dir, arguments_t *arguments, arena_t *arena);
+
+/**
+ * @brief Copy the FILETIME timestamps (creation, access and modification) to
+ * the asset. The dates are formatted when they are printed, see 'datetime.h'.
+ *
+ * @param fd        pointer to Win32 data structure to access the timestapms
+ * @param asset     pointer to the asset where the timestamps are stored
+ */
+void GetTimestaps(const WIN32_FIND_DATAA *fd, asset_t *asset);
+
+/**
+ * @brief Get the metadata based on the asset extension. If the extension is not
+ * found a predefined metadata based on the type it will be returned.
+ *
+ * @param asset                     valid pointer to the asset
+ * @return const asset_metadata_t*  pointer to the metadata structure
+ */
+const asset_metadata_t *GetAssetMetadata(const asset_t *asset);
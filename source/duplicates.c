@@ -0,0 +1,276 @@
+#include "duplicates.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "content.h"
+#include "format.h"
+#include "stats.h"
+
+#define DUPLICATE_PREFIX_SIZE 4096 // leading bytes hashed before the whole content
+
+/**
+ * @brief Check if two documents belong to the same group.
+ */
+typedef BOOL (*duplicate_match_t)(const duplicate_file_t *a, const duplicate_file_t *b);
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Compare two documents by size, the biggest first.
+ *
+ * @param a     pointer to the first document pointer
+ * @param b     pointer to the second document pointer
+ * @return int  negative if 'a' goes first, positive if 'b' goes first, 0 otherwise
+ */
+local_function int CompareDuplicateSize(const void *a, const void *b)
+{
+    const duplicate_file_t *fa = *(const duplicate_file_t **)a;
+    const duplicate_file_t *fb = *(const duplicate_file_t **)b;
+
+    return (fb->size > fa->size) - (fb->size < fa->size);
+}
+
+/**
+ * @brief Compare two documents by size and by the hash of the leading bytes.
+ *
+ * @param a     pointer to the first document pointer
+ * @param b     pointer to the second document pointer
+ * @return int  negative if 'a' goes first, positive if 'b' goes first, 0 otherwise
+ */
+local_function int CompareDuplicatePrefix(const void *a, const void *b)
+{
+    const duplicate_file_t *fa = *(const duplicate_file_t **)a;
+    const duplicate_file_t *fb = *(const duplicate_file_t **)b;
+
+    int retValue = CompareDuplicateSize(a, b);
+    return retValue != 0 ? retValue : (fa->prefix > fb->prefix) - (fa->prefix < fb->prefix);
+}
+
+/**
+ * @brief Compare two documents by size, by the hash of the content and by
+ * path, so each group is printed in order.
+ *
+ * @param a     pointer to the first document pointer
+ * @param b     pointer to the second document pointer
+ * @return int  negative if 'a' goes first, positive if 'b' goes first, 0 otherwise
+ */
+local_function int CompareDuplicateHash(const void *a, const void *b)
+{
+    const duplicate_file_t *fa = *(const duplicate_file_t **)a;
+    const duplicate_file_t *fb = *(const duplicate_file_t **)b;
+
+    int retValue = CompareDuplicateSize(a, b);
+    if (retValue != 0) return retValue;
+
+    retValue = (fa->hash > fb->hash) - (fa->hash < fb->hash);
+    return retValue != 0 ? retValue : _strcmpi(fa->path, fb->path);
+}
+
+/**
+ * @brief Check if two documents have the same size.
+ *
+ * @param a         first document
+ * @param b         second document
+ * @return BOOL     TRUE if they belong to the same group, FALSE otherwise
+ */
+local_function BOOL SameDuplicateSize(const duplicate_file_t *a, const duplicate_file_t *b)
+{
+    return a->size == b->size;
+}
+
+/**
+ * @brief Check if two documents have the same size and leading bytes.
+ *
+ * @param a         first document
+ * @param b         second document
+ * @return BOOL     TRUE if they belong to the same group, FALSE otherwise
+ */
+local_function BOOL SameDuplicatePrefix(const duplicate_file_t *a, const duplicate_file_t *b)
+{
+    return a->size == b->size && a->prefix == b->prefix;
+}
+
+/**
+ * @brief Check if two documents have the same size and content.
+ *
+ * @param a         first document
+ * @param b         second document
+ * @return BOOL     TRUE if they belong to the same group, FALSE otherwise
+ */
+local_function BOOL SameDuplicateHash(const duplicate_file_t *a, const duplicate_file_t *b)
+{
+    return a->size == b->size && a->hash == b->hash;
+}
+
+/**
+ * @brief Remove the documents that can not be read and the ones that are
+ * alone on their group, the documents have to be sorted by the group.
+ *
+ * @param files     documents sorted by the group
+ * @param count     number of documents
+ * @param same      function to check if two documents belong to the same group
+ * @return size_t   number of documents kept at the beginning of the array
+ */
+local_function size_t KeepDuplicateGroups(duplicate_file_t **files, size_t count, duplicate_match_t same)
+{
+    size_t readable = 0, kept = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (files[i]->readable) files[readable++] = files[i];
+    }
+
+    for (size_t i = 0; i < readable;)
+    {
+        size_t end = i + 1;
+        while (end < readable && same(files[i], files[end])) ++end;
+
+        if (end - i > 1)
+        {
+            memmove(&files[kept], &files[i], sizeof(duplicate_file_t *) * (end - i));
+            kept += end - i;
+        }
+
+        i = end;
+    }
+
+    return kept;
+}
+
+/**
+ * @brief Task of the pool, it hashes the leading bytes of a document. The
+ * small documents are hashed whole so they skip the last stage.
+ *
+ * @param context   array of documents
+ * @param index     index of the document
+ */
+local_function void HashDuplicatePrefix(void *context, size_t index)
+{
+    duplicate_file_t *file = ((duplicate_file_t **)context)[index];
+    file->readable = HashDocumentContent(file->path, DUPLICATE_PREFIX_SIZE, &file->prefix);
+
+    if (file->size <= DUPLICATE_PREFIX_SIZE) file->hash = file->prefix;
+}
+
+/**
+ * @brief Task of the pool, it hashes the whole content of a document.
+ *
+ * @param context   array of documents
+ * @param index     index of the document
+ */
+local_function void HashDuplicateContent(void *context, size_t index)
+{
+    duplicate_file_t *file = ((duplicate_file_t **)context)[index];
+    file->readable = HashDocumentContent(file->path, 0, &file->hash);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AddDuplicateCandidate(duplicate_finder_t *finder, const asset_t *asset)
+{
+    if (asset->type.directory || asset->type.symlink || asset->size == 0) return;
+
+    if (finder->count == finder->capacity)
+    {
+        size_t newCapacity = finder->capacity ? finder->capacity * 2 : STARTUP_CONTAINER_SIZE;
+        duplicate_file_t *files = realloc(finder->files, sizeof(duplicate_file_t) * newCapacity);
+        if (files == NULL) return;
+
+        finder->files = files;
+        finder->capacity = newCapacity;
+    }
+
+    const char *path = PushArenaString(&finder->arena, asset->path);
+    if (path == NULL) return;
+
+    duplicate_file_t *file = &finder->files[finder->count++];
+    memset(file, 0, sizeof(duplicate_file_t));
+
+    file->path = path;
+    file->size = asset->size;
+    file->readable = TRUE;
+}
+
+void PrintDuplicates(duplicate_finder_t *finder, const arguments_t *arguments)
+{
+    duplicate_file_t **files = malloc(sizeof(duplicate_file_t *) * (finder->count + 1));
+    if (files == NULL) return;
+
+    stats_timer_t timer = StartStatsTimer();
+
+    for (size_t i = 0; i < finder->count; ++i)
+    {
+        files[i] = &finder->files[i];
+    }
+
+    // NOTE(Andrei): Stage 1, only the documents with the same size can have
+    //               the same content, no document is opened.
+    qsort(files, finder->count, sizeof(duplicate_file_t *), CompareDuplicateSize);
+    size_t count = KeepDuplicateGroups(files, finder->count, SameDuplicateSize);
+
+    StopStatsPhase(STATS_PHASE_SORT, timer);
+    timer = StartStatsTimer();
+
+    // NOTE(Andrei): Stage 2, the leading bytes discard most of the documents
+    //               with the same size (headers, different lengths of text).
+    RunContentTasks(count, HashDuplicatePrefix, files);
+    qsort(files, count, sizeof(duplicate_file_t *), CompareDuplicatePrefix);
+    count = KeepDuplicateGroups(files, count, SameDuplicatePrefix);
+
+    // NOTE(Andrei): Stage 3, the documents are still sorted by size so the
+    //               ones bigger than the prefix are at the beginning.
+    size_t numBig = 0;
+    while (numBig < count && files[numBig]->size > DUPLICATE_PREFIX_SIZE) ++numBig;
+
+    RunContentTasks(numBig, HashDuplicateContent, files);
+    qsort(files, count, sizeof(duplicate_file_t *), CompareDuplicateHash);
+    count = KeepDuplicateGroups(files, count, SameDuplicateHash);
+
+    StopStatsPhase(STATS_PHASE_CONTENT, timer);
+    timer = StartStatsTimer();
+
+    size_t numGroups = 0, numDuplicates = 0, wasted = 0;
+    char size[SIZE_TEXT_SIZE];
+
+    for (size_t i = 0; i < count;)
+    {
+        size_t end = i + 1;
+        while (end < count && SameDuplicateHash(files[i], files[end])) ++end;
+
+        FormatSize(files[i]->size, arguments->sizeFormat, size, SIZE_TEXT_SIZE);
+        printf_s("%s  %zu documents  %016llx\n", size, end - i, files[i]->hash);
+
+        for (size_t j = i; j < end; ++j)
+        {
+            printf_s("%s\n", files[j]->path);
+        }
+
+        printf_s("\n");
+
+        ++numGroups;
+        numDuplicates += end - i - 1;
+        wasted += files[i]->size * (end - i - 1);
+
+        i = end;
+    }
+
+    FormatSize(wasted, arguments->sizeFormat, size, SIZE_TEXT_SIZE);
+    const char *wastedText = size;
+    while (*wastedText == ' ') ++wastedText;
+
+    printf_s("%zu groups, %zu duplicates, %s wasted", numGroups, numDuplicates, wastedText);
+
+    StopStatsPhase(STATS_PHASE_RENDER, timer);
+    CHECK_DELETE(files);
+}
+
+void DeleteDuplicateFinder(duplicate_finder_t *finder)
+{
+    CHECK_DELETE(finder->files);
+    DeleteArena(&finder->arena);
+
+    finder->count = finder->capacity = 0;
+}
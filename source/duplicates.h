@@ -0,0 +1,72 @@
+#pragma once
+
+#include "types.h"
+#include "arena.h"
+
+/**
+ * @brief Document that can have duplicates.
+ *
+ * 'path'       : full path of the document
+ * 'size'       : size in bytes
+ * 'prefix'     : hash of the leading bytes (see 'DUPLICATE_PREFIX_SIZE')
+ * 'hash'       : hash of the whole content
+ * 'readable'   : the document could be read on all the stages
+ */
+typedef struct duplicate_file_t
+{
+    const char *path;
+    size_t size;
+
+    unsigned long long prefix, hash;
+    BOOL readable;
+} duplicate_file_t;
+
+/**
+ * @brief Documents collected while walking the tree, see 'AddDuplicateCandidate'.
+ *
+ * 'files'      : collected documents
+ * 'count'      : number of documents
+ * 'capacity'   : space available on the 'files' array
+ * 'arena'      : arena where the paths are stored, it lives until the end
+ */
+typedef struct duplicate_finder_t
+{
+    duplicate_file_t *files;
+    size_t count, capacity;
+
+    arena_t arena;
+} duplicate_finder_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Collect a document of the listing, the directories, the links and
+ * the empty documents are ignored.
+ *
+ * @param finder    pointer to the finder
+ * @param asset     asset of the listing
+ */
+void AddDuplicateCandidate(duplicate_finder_t *finder, const asset_t *asset);
+
+/**
+ * @brief Find and print the groups of documents with the same content. The
+ * stages discard the documents as soon as they are unique:
+ *
+ *  1. documents with the same size
+ *  2. same hash of the leading 4 KB (read in parallel)
+ *  3. same hash of the whole content (read in parallel, the biggest first)
+ *
+ * Each group is printed with its size followed by its paths, the biggest
+ * groups first, and a summary of the wasted space at the end.
+ *
+ * @param finder        pointer to the finder
+ * @param arguments     pointer to the parsed arguments structure
+ */
+void PrintDuplicates(duplicate_finder_t *finder, const arguments_t *arguments);
+
+/**
+ * @brief Release the memory of the finder.
+ *
+ * @param finder    pointer to the finder
+ */
+void DeleteDuplicateFinder(duplicate_finder_t *finder);
@@ -0,0 +1,927 @@
+#include "filter.h"
+#include "types.h"
+#include "glob.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILTER_MAX_NODES    256     // maximum number of nodes of the parsed expression
+#define FILTER_MAX_CODE     512     // maximum number of instructions per stage program
+#define FILTER_MAX_STRINGS  4096    // bytes used to store the string constants
+#define FILTER_MAX_NESTING  64      // maximum nesting of '!' and parenthesis
+
+// Ticks of 100 nanoseconds (FILETIME unit) in a second
+#define TICKS_PER_SECOND 10000000LL
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Asset fields that can be used in the expression.
+ */
+typedef enum filter_field_e
+{
+    FIELD_NAME, FIELD_EXT, FIELD_TYPE, FIELD_OWNER, FIELD_GROUP, FIELD_PERMS,
+    FIELD_SIZE, FIELD_HIDDEN, FIELD_CTIME, FIELD_ATIME, FIELD_MTIME
+} filter_field_e;
+
+/**
+ * @brief Comparison done by a predicate.
+ */
+typedef enum filter_compare_e
+{
+    CMP_EQ, CMP_NE, CMP_LT, CMP_LE, CMP_GT, CMP_GE, CMP_MATCH
+} filter_compare_e;
+
+/**
+ * @brief Instructions of the filter program. The program works with a single
+ * boolean accumulator, 'TEST' sets it and the jumps short-circuit '&&', '||'.
+ */
+typedef enum filter_opcode_e
+{
+    OP_TEST, OP_NOT, OP_JUMP_IF_FALSE, OP_JUMP_IF_TRUE
+} filter_opcode_e;
+
+/**
+ * @brief Kind of the parsed expression node.
+ */
+typedef enum filter_node_e
+{
+    NODE_PREDICATE, NODE_AND, NODE_OR, NODE_NOT
+} filter_node_e;
+
+/**
+ * @brief Token kinds of the expression.
+ */
+typedef enum filter_token_e
+{
+    TOKEN_END, TOKEN_FIELD, TOKEN_NUMBER, TOKEN_STRING, TOKEN_COMPARE,
+    TOKEN_AND, TOKEN_OR, TOKEN_NOT, TOKEN_IN, TOKEN_OPEN, TOKEN_CLOSE, TOKEN_COMMA
+} filter_token_e;
+
+/**
+ * @brief Unit given by the suffix of a number, it has to match the field.
+ */
+typedef enum filter_unit_e
+{
+    UNIT_NONE, UNIT_SIZE, UNIT_TIME
+} filter_unit_e;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Field name, which stage provides it, if it is a string and the
+ * unit of the number suffixes it accepts.
+ */
+typedef struct filter_field_t
+{
+    const char *name;
+    filter_field_e field;
+    filter_stage_e stage;
+    BOOL isString;
+    filter_unit_e unit;
+} filter_field_t;
+
+/**
+ * @brief Single instruction of the program.
+ *
+ * 'opcode'     : what the instruction does
+ * 'field'      : asset field to test ('OP_TEST')
+ * 'compare'    : comparison to apply ('OP_TEST')
+ * 'number'     : constant to compare with for numeric fields
+ * 'text'       : constant to compare with for string fields
+ * 'target'     : instruction index to jump to ('OP_JUMP_IF_*')
+ */
+typedef struct filter_instruction_t
+{
+    filter_opcode_e opcode;
+    filter_field_e field;
+    filter_compare_e compare;
+
+    long long number;
+    const char *text;
+    size_t target;
+} filter_instruction_t;
+
+/**
+ * @brief Program evaluated on a given stage.
+ */
+typedef struct filter_program_t
+{
+    size_t size;
+    filter_instruction_t code[FILTER_MAX_CODE];
+} filter_program_t;
+
+/**
+ * @brief Compiled filter, one program per stage. The top level '&&' terms
+ * are distributed to the earliest stage that has all the fields they use.
+ */
+struct filter_t
+{
+    filter_program_t programs[FILTER_STAGE_COUNT];
+
+    size_t stringsSize;
+    char strings[FILTER_MAX_STRINGS];
+};
+
+/**
+ * @brief Node of the parsed expression, children are indexes of the pool.
+ */
+typedef struct filter_node_t
+{
+    filter_node_e kind;
+    filter_stage_e stage;
+
+    size_t left, right;
+    filter_instruction_t predicate;
+} filter_node_t;
+
+/**
+ * @brief Parser state.
+ *
+ * 'text'       : expression being parsed
+ * 'current'    : position of the next token
+ * 'token*'     : last token read
+ * 'now'        : current time, relative times are based on it
+ * 'nesting'    : '!' and parenthesis being parsed, bounds the recursion
+ */
+typedef struct filter_parser_t
+{
+    filter_t *filter;
+    const char *text, *current;
+
+    filter_token_e token;
+    const char *tokenStart;
+    size_t tokenLength;
+
+    long long tokenNumber;
+    filter_unit_e tokenUnit;
+    filter_compare_e tokenCompare;
+
+    long long now;
+    char *error; size_t errorSize;
+
+    size_t nesting;
+
+    size_t numNodes;
+    filter_node_t nodes[FILTER_MAX_NODES];
+} filter_parser_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+global_variable const filter_field_t g_FilterFields[] =
+{
+    { "name",   FIELD_NAME,     FILTER_STAGE_NAME,  TRUE,   UNIT_NONE },
+    { "ext",    FIELD_EXT,      FILTER_STAGE_NAME,  TRUE,   UNIT_NONE },
+    { "type",   FIELD_TYPE,     FILTER_STAGE_NAME,  TRUE,   UNIT_NONE },
+    { "hidden", FIELD_HIDDEN,   FILTER_STAGE_NAME,  FALSE,  UNIT_NONE },
+    { "size",   FIELD_SIZE,     FILTER_STAGE_STAT,  FALSE,  UNIT_SIZE },
+    { "ctime",  FIELD_CTIME,    FILTER_STAGE_STAT,  FALSE,  UNIT_TIME },
+    { "atime",  FIELD_ATIME,    FILTER_STAGE_STAT,  FALSE,  UNIT_TIME },
+    { "mtime",  FIELD_MTIME,    FILTER_STAGE_STAT,  FALSE,  UNIT_TIME },
+    { "owner",  FIELD_OWNER,    FILTER_STAGE_OWNER, TRUE,   UNIT_NONE },
+    { "group",  FIELD_GROUP,    FILTER_STAGE_OWNER, TRUE,   UNIT_NONE },
+    { "perms",  FIELD_PERMS,    FILTER_STAGE_OWNER, TRUE,   UNIT_NONE },
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Store the error message, only the first error is kept.
+ *
+ * @param parser    pointer to the parser
+ * @param message   description of the error
+ * @return BOOL     always FALSE
+ */
+local_function BOOL SetFilterError(filter_parser_t *parser, const char *message)
+{
+    if (parser->error[0] == '\0')
+    {
+        size_t position = (size_t)(parser->tokenStart - parser->text);
+        sprintf_s(parser->error, parser->errorSize, "%s at position %zu", message, position);
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Multiplier of a number suffix. Upper case are sizes in base 1024,
+ * lower case are durations in FILETIME ticks.
+ *
+ * @param suffix        suffix character
+ * @param unit          set to the unit of the suffix
+ * @return long long    the multiplier or 0 if the suffix is not valid
+ */
+local_function long long GetSuffixMultiplier(char suffix, filter_unit_e *unit)
+{
+    *unit = UNIT_SIZE;
+
+    switch (suffix)
+    {
+        case 'K': return 1LL << 10;
+        case 'M': return 1LL << 20;
+        case 'G': return 1LL << 30;
+        case 'T': return 1LL << 40;
+        case 'P': return 1LL << 50;
+    }
+
+    *unit = UNIT_TIME;
+
+    switch (suffix)
+    {
+        case 's': return TICKS_PER_SECOND;
+        case 'm': return TICKS_PER_SECOND * 60;
+        case 'h': return TICKS_PER_SECOND * 60 * 60;
+        case 'd': return TICKS_PER_SECOND * 60 * 60 * 24;
+        case 'w': return TICKS_PER_SECOND * 60 * 60 * 24 * 7;
+        case 'y': return TICKS_PER_SECOND * 60 * 60 * 24 * 365;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read the next token of the expression.
+ *
+ * @param parser    pointer to the parser
+ * @return BOOL     TRUE if a valid token was read, FALSE otherwise
+ */
+local_function BOOL NextToken(filter_parser_t *parser)
+{
+    const char *c = parser->current;
+    while (isspace((unsigned char)*c)) ++c;
+
+    parser->tokenStart = c;
+    parser->tokenLength = 1;
+
+    if (*c == '\0')
+    {
+        parser->token = TOKEN_END;
+        parser->tokenLength = 0;
+    }
+    else if (c[0] == '&' && c[1] == '&') { parser->token = TOKEN_AND; parser->tokenLength = 2; }
+    else if (c[0] == '|' && c[1] == '|') { parser->token = TOKEN_OR; parser->tokenLength = 2; }
+    else if (c[0] == '=' && c[1] == '=') { parser->token = TOKEN_COMPARE; parser->tokenCompare = CMP_EQ; parser->tokenLength = 2; }
+    else if (c[0] == '!' && c[1] == '=') { parser->token = TOKEN_COMPARE; parser->tokenCompare = CMP_NE; parser->tokenLength = 2; }
+    else if (c[0] == '<' && c[1] == '=') { parser->token = TOKEN_COMPARE; parser->tokenCompare = CMP_LE; parser->tokenLength = 2; }
+    else if (c[0] == '>' && c[1] == '=') { parser->token = TOKEN_COMPARE; parser->tokenCompare = CMP_GE; parser->tokenLength = 2; }
+    else if (c[0] == '<') { parser->token = TOKEN_COMPARE; parser->tokenCompare = CMP_LT; }
+    else if (c[0] == '>') { parser->token = TOKEN_COMPARE; parser->tokenCompare = CMP_GT; }
+    else if (c[0] == '~') { parser->token = TOKEN_COMPARE; parser->tokenCompare = CMP_MATCH; }
+    else if (c[0] == '!') { parser->token = TOKEN_NOT; }
+    else if (c[0] == '(') { parser->token = TOKEN_OPEN; }
+    else if (c[0] == ')') { parser->token = TOKEN_CLOSE; }
+    else if (c[0] == ',') { parser->token = TOKEN_COMMA; }
+    else if (c[0] == '"' || c[0] == '\'')
+    {
+        const char *end = strchr(c + 1, c[0]);
+        if (end == NULL) return SetFilterError(parser, "Unterminated string");
+
+        parser->token = TOKEN_STRING;
+        parser->tokenLength = (size_t)(end - c) + 1;
+    }
+    else if (isdigit((unsigned char)c[0]) || (c[0] == '-' && isdigit((unsigned char)c[1])))
+    {
+        char *end = NULL;
+        double value = strtod(c, &end);
+        filter_unit_e unit = UNIT_NONE;
+
+        if (isalpha((unsigned char)*end))
+        {
+            long long multiplier = GetSuffixMultiplier(*end, &unit);
+            if (multiplier == 0) return SetFilterError(parser, "Invalid number suffix");
+
+            value *= (double)multiplier;
+            ++end;
+        }
+
+        // NOTE(Andrei): Durations are relative to now, -30d is 30 days ago.
+        parser->token = TOKEN_NUMBER;
+        parser->tokenNumber = (long long)value + (unit == UNIT_TIME ? parser->now : 0);
+        parser->tokenUnit = unit;
+        parser->tokenLength = (size_t)(end - c);
+    }
+    else if (isalpha((unsigned char)c[0]))
+    {
+        const char *end = c;
+        while (isalnum((unsigned char)*end) || *end == '_') ++end;
+
+        parser->tokenLength = (size_t)(end - c);
+        parser->token = TOKEN_FIELD;
+
+        if (parser->tokenLength == 2 && strncmp(c, "in", 2) == 0)
+        {
+            parser->token = TOKEN_IN;
+        }
+    }
+    else
+    {
+        return SetFilterError(parser, "Unexpected character");
+    }
+
+    parser->current = parser->tokenStart + parser->tokenLength;
+    return TRUE;
+}
+
+/**
+ * @brief Copy the current string token (without quotes) to the filter strings.
+ *
+ * @param parser        pointer to the parser
+ * @return const char*  pointer to the stored string or NULL if there is no space
+ */
+local_function const char *StoreStringToken(filter_parser_t *parser)
+{
+    filter_t *filter = parser->filter;
+    size_t length = parser->tokenLength - 2;
+
+    if (filter->stringsSize + length + 1 > FILTER_MAX_STRINGS)
+    {
+        SetFilterError(parser, "Too many strings");
+        return NULL;
+    }
+
+    char *str = &filter->strings[filter->stringsSize];
+    memcpy(str, parser->tokenStart + 1, length);
+    str[length] = '\0';
+
+    filter->stringsSize += length + 1;
+    return str;
+}
+
+/**
+ * @brief Get a new node from the parser pool.
+ *
+ * @param parser    pointer to the parser
+ * @param kind      kind of the node
+ * @return size_t   index of the node or FILTER_MAX_NODES if the pool is full
+ */
+local_function size_t NewNode(filter_parser_t *parser, filter_node_e kind)
+{
+    if (parser->numNodes >= FILTER_MAX_NODES)
+    {
+        SetFilterError(parser, "Expression too long");
+        return FILTER_MAX_NODES;
+    }
+
+    size_t index = parser->numNodes++;
+    memset(&parser->nodes[index], 0, sizeof(filter_node_t));
+
+    parser->nodes[index].kind = kind;
+    return index;
+}
+
+/**
+ * @brief Create a node joining two nodes, the stage of the new node is the
+ * latest of both.
+ *
+ * @param parser    pointer to the parser
+ * @param kind      NODE_AND or NODE_OR
+ * @param left      index of the left node
+ * @param right     index of the right node
+ * @return size_t   index of the node or FILTER_MAX_NODES on error
+ */
+local_function size_t NewBinaryNode(filter_parser_t *parser, filter_node_e kind, size_t left, size_t right)
+{
+    if (left >= FILTER_MAX_NODES || right >= FILTER_MAX_NODES) return FILTER_MAX_NODES;
+
+    size_t index = NewNode(parser, kind);
+    if (index >= FILTER_MAX_NODES) return index;
+
+    filter_node_t *node = &parser->nodes[index];
+    filter_stage_e leftStage = parser->nodes[left].stage, rightStage = parser->nodes[right].stage;
+
+    node->left = left;
+    node->right = right;
+    node->stage = leftStage > rightStage ? leftStage : rightStage;
+
+    return index;
+}
+
+/**
+ * @brief Parse a value and create the predicate node 'field compare value'.
+ *
+ * @param parser    pointer to the parser
+ * @param field     field of the predicate
+ * @param compare   comparison of the predicate
+ * @return size_t   index of the node or FILTER_MAX_NODES on error
+ */
+local_function size_t ParseValue(filter_parser_t *parser, const filter_field_t *field, filter_compare_e compare)
+{
+    if (field->isString && parser->token != TOKEN_STRING)
+    {
+        SetFilterError(parser, "Expected a string");
+        return FILTER_MAX_NODES;
+    }
+
+    if (!field->isString && parser->token != TOKEN_NUMBER)
+    {
+        SetFilterError(parser, "Expected a number");
+        return FILTER_MAX_NODES;
+    }
+
+    if (!field->isString && compare == CMP_MATCH)
+    {
+        SetFilterError(parser, "Pattern match on a numeric field");
+        return FILTER_MAX_NODES;
+    }
+
+    // NOTE(Andrei): 'size > 100m' or 'mtime < -30K' would compare bytes
+    //               with ticks, a plain number is taken as it is.
+    if (!field->isString && parser->tokenUnit != UNIT_NONE && parser->tokenUnit != field->unit)
+    {
+        SetFilterError(parser, parser->tokenUnit == UNIT_TIME ? "Time suffix on a non time field" : "Size suffix on a non size field");
+        return FILTER_MAX_NODES;
+    }
+
+    size_t index = NewNode(parser, NODE_PREDICATE);
+    if (index >= FILTER_MAX_NODES) return index;
+
+    filter_node_t *node = &parser->nodes[index];
+    node->stage = field->stage;
+
+    node->predicate.opcode = OP_TEST;
+    node->predicate.field = field->field;
+    node->predicate.compare = compare;
+
+    if (field->isString)
+    {
+        node->predicate.text = StoreStringToken(parser);
+        if (node->predicate.text == NULL) return FILTER_MAX_NODES;
+    }
+    else
+    {
+        node->predicate.number = parser->tokenNumber;
+    }
+
+    return NextToken(parser) ? index : FILTER_MAX_NODES;
+}
+
+local_function size_t ParseOr(filter_parser_t *parser);
+
+/**
+ * @brief Parse a predicate, a negation or an expression between parenthesis.
+ *
+ *  unary := '!' unary | '(' or ')' | field compare value | field 'in' '(' value, ... ')' | field
+ *
+ * @param parser    pointer to the parser
+ * @return size_t   index of the node or FILTER_MAX_NODES on error
+ */
+local_function size_t ParseUnary(filter_parser_t *parser)
+{
+    // NOTE(Andrei): The nodes are only created at the innermost term,
+    //               the recursion has to be bounded on its own.
+    if ((parser->token == TOKEN_NOT || parser->token == TOKEN_OPEN) && parser->nesting >= FILTER_MAX_NESTING)
+    {
+        SetFilterError(parser, "Expression nested too deeply");
+        return FILTER_MAX_NODES;
+    }
+
+    if (parser->token == TOKEN_NOT)
+    {
+        if (!NextToken(parser)) return FILTER_MAX_NODES;
+
+        ++parser->nesting;
+        size_t child = ParseUnary(parser);
+        --parser->nesting;
+
+        if (child >= FILTER_MAX_NODES) return child;
+
+        size_t index = NewNode(parser, NODE_NOT);
+        if (index >= FILTER_MAX_NODES) return index;
+
+        parser->nodes[index].left = child;
+        parser->nodes[index].stage = parser->nodes[child].stage;
+        return index;
+    }
+
+    if (parser->token == TOKEN_OPEN)
+    {
+        if (!NextToken(parser)) return FILTER_MAX_NODES;
+
+        ++parser->nesting;
+        size_t index = ParseOr(parser);
+        --parser->nesting;
+
+        if (index >= FILTER_MAX_NODES) return index;
+
+        if (parser->token != TOKEN_CLOSE)
+        {
+            SetFilterError(parser, "Expected ')'");
+            return FILTER_MAX_NODES;
+        }
+
+        return NextToken(parser) ? index : FILTER_MAX_NODES;
+    }
+
+    if (parser->token != TOKEN_FIELD)
+    {
+        SetFilterError(parser, "Expected a field name");
+        return FILTER_MAX_NODES;
+    }
+
+    const filter_field_t *field = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(g_FilterFields); ++i)
+    {
+        const char *name = g_FilterFields[i].name;
+
+        if (strlen(name) == parser->tokenLength && strncmp(name, parser->tokenStart, parser->tokenLength) == 0)
+        {
+            field = &g_FilterFields[i];
+        }
+    }
+
+    if (field == NULL)
+    {
+        SetFilterError(parser, "Unknown field");
+        return FILTER_MAX_NODES;
+    }
+
+    if (!NextToken(parser)) return FILTER_MAX_NODES;
+
+    if (parser->token == TOKEN_COMPARE)
+    {
+        filter_compare_e compare = parser->tokenCompare;
+        if (!NextToken(parser)) return FILTER_MAX_NODES;
+
+        return ParseValue(parser, field, compare);
+    }
+
+    if (parser->token == TOKEN_IN)
+    {
+        if (!NextToken(parser)) return FILTER_MAX_NODES;
+
+        if (parser->token != TOKEN_OPEN)
+        {
+            SetFilterError(parser, "Expected '('");
+            return FILTER_MAX_NODES;
+        }
+
+        size_t index = FILTER_MAX_NODES;
+
+        // NOTE(Andrei): 'x in (a, b)' is compiled as 'x == a || x == b'
+        do
+        {
+            if (!NextToken(parser)) return FILTER_MAX_NODES;
+
+            size_t value = ParseValue(parser, field, CMP_EQ);
+            if (value >= FILTER_MAX_NODES) return value;
+
+            index = index >= FILTER_MAX_NODES ? value : NewBinaryNode(parser, NODE_OR, index, value);
+            if (index >= FILTER_MAX_NODES) return index;
+        } while (parser->token == TOKEN_COMMA);
+
+        if (parser->token != TOKEN_CLOSE)
+        {
+            SetFilterError(parser, "Expected ')'");
+            return FILTER_MAX_NODES;
+        }
+
+        return NextToken(parser) ? index : FILTER_MAX_NODES;
+    }
+
+    if (field->isString)
+    {
+        SetFilterError(parser, "Expected a comparison");
+        return FILTER_MAX_NODES;
+    }
+
+    // NOTE(Andrei): A numeric field alone is true if not zero, ex: 'hidden'.
+    size_t index = NewNode(parser, NODE_PREDICATE);
+    if (index >= FILTER_MAX_NODES) return index;
+
+    filter_node_t *node = &parser->nodes[index];
+    node->stage = field->stage;
+
+    node->predicate.opcode = OP_TEST;
+    node->predicate.field = field->field;
+    node->predicate.compare = CMP_NE;
+    node->predicate.number = 0;
+
+    return index;
+}
+
+/**
+ * @brief Parse a sequence of unary expressions joined by '&&'.
+ *
+ * @param parser    pointer to the parser
+ * @return size_t   index of the node or FILTER_MAX_NODES on error
+ */
+local_function size_t ParseAnd(filter_parser_t *parser)
+{
+    size_t index = ParseUnary(parser);
+
+    while (index < FILTER_MAX_NODES && parser->token == TOKEN_AND)
+    {
+        if (!NextToken(parser)) return FILTER_MAX_NODES;
+        index = NewBinaryNode(parser, NODE_AND, index, ParseUnary(parser));
+    }
+
+    return index;
+}
+
+/**
+ * @brief Parse a sequence of '&&' expressions joined by '||'.
+ *
+ * @param parser    pointer to the parser
+ * @return size_t   index of the node or FILTER_MAX_NODES on error
+ */
+local_function size_t ParseOr(filter_parser_t *parser)
+{
+    size_t index = ParseAnd(parser);
+
+    while (index < FILTER_MAX_NODES && parser->token == TOKEN_OR)
+    {
+        if (!NextToken(parser)) return FILTER_MAX_NODES;
+        index = NewBinaryNode(parser, NODE_OR, index, ParseAnd(parser));
+    }
+
+    return index;
+}
+
+/**
+ * @brief Append an instruction to the program.
+ *
+ * @param parser        pointer to the parser, used to report errors
+ * @param program       pointer to the program
+ * @param instruction   instruction to append
+ * @return size_t       index of the instruction or FILTER_MAX_CODE if full
+ */
+local_function size_t EmitInstruction(filter_parser_t *parser, filter_program_t *program, filter_instruction_t instruction)
+{
+    if (program->size >= FILTER_MAX_CODE)
+    {
+        SetFilterError(parser, "Expression too long");
+        return FILTER_MAX_CODE;
+    }
+
+    program->code[program->size] = instruction;
+    return program->size++;
+}
+
+/**
+ * @brief Generate the instructions of a node, the result is left on the
+ * accumulator.
+ *
+ * @param parser    pointer to the parser
+ * @param program   pointer to the program
+ * @param index     index of the node to compile
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+local_function BOOL CompileNode(filter_parser_t *parser, filter_program_t *program, size_t index)
+{
+    const filter_node_t *node = &parser->nodes[index];
+    filter_instruction_t instruction = { 0 };
+
+    switch (node->kind)
+    {
+        case NODE_PREDICATE:
+        {
+            return EmitInstruction(parser, program, node->predicate) < FILTER_MAX_CODE;
+        }
+
+        case NODE_NOT:
+        {
+            instruction.opcode = OP_NOT;
+            return CompileNode(parser, program, node->left) && EmitInstruction(parser, program, instruction) < FILTER_MAX_CODE;
+        }
+
+        case NODE_AND:
+        case NODE_OR:
+        {
+            if (!CompileNode(parser, program, node->left)) return FALSE;
+
+            // NOTE(Andrei): Short-circuit, the accumulator keeps the left
+            //               value when the right side is skipped.
+            instruction.opcode = node->kind == NODE_AND ? OP_JUMP_IF_FALSE : OP_JUMP_IF_TRUE;
+
+            size_t jump = EmitInstruction(parser, program, instruction);
+            if (jump >= FILTER_MAX_CODE || !CompileNode(parser, program, node->right)) return FALSE;
+
+            program->code[jump].target = program->size;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Split the top level '&&' terms and compile each one into the
+ * program of its stage.
+ *
+ * @param parser    pointer to the parser
+ * @param index     index of the node to compile
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+local_function BOOL CompileConjunction(filter_parser_t *parser, size_t index)
+{
+    const filter_node_t *node = &parser->nodes[index];
+
+    if (node->kind == NODE_AND)
+    {
+        return CompileConjunction(parser, node->left) && CompileConjunction(parser, node->right);
+    }
+
+    filter_program_t *program = &parser->filter->programs[node->stage];
+    filter_instruction_t instruction = { 0 };
+
+    if (!CompileNode(parser, program, index)) return FALSE;
+
+    // NOTE(Andrei): A false term rejects the asset, jump past the end.
+    instruction.opcode = OP_JUMP_IF_FALSE;
+    instruction.target = FILTER_MAX_CODE;
+
+    return EmitInstruction(parser, program, instruction) < FILTER_MAX_CODE;
+}
+
+/**
+ * @brief Get the value of a string field, the extension includes the dot.
+ *
+ * @param field         field to get
+ * @param asset         pointer to the asset
+ * @param buffer        buffer for the values that are not stored in the asset
+ * @return const char*  value of the field
+ */
+local_function const char *GetStringField(filter_field_e field, const asset_t *asset, char buffer[4])
+{
+    switch (field)
+    {
+        case FIELD_NAME:  return asset->name;
+        case FIELD_OWNER: return asset->owner;
+        case FIELD_GROUP: return asset->domain;
+
+        case FIELD_EXT:
+        {
+            const char *ext = strrchr(asset->name, '.');
+            return ext != NULL && ext != asset->name ? ext : "";
+        }
+
+        case FIELD_TYPE:
+        {
+            buffer[0] = asset->type.symlink ? 'l' : asset->type.directory ? 'd' : 'f';
+            buffer[1] = '\0';
+            return buffer;
+        }
+
+        case FIELD_PERMS:
+        {
+            buffer[0] = asset->accessRights.read ? 'r' : '-';
+            buffer[1] = asset->accessRights.write ? 'w' : '-';
+            buffer[2] = asset->accessRights.execution ? 'x' : '-';
+            buffer[3] = '\0';
+            return buffer;
+        }
+
+        default: return "";
+    }
+}
+
+/**
+ * @brief Get the value of a numeric field.
+ *
+ * @param field         field to get
+ * @param asset         pointer to the asset
+ * @return long long    value of the field
+ */
+local_function long long GetNumberField(filter_field_e field, const asset_t *asset)
+{
+    switch (field)
+    {
+        case FIELD_SIZE:   return (long long)asset->size;
+        case FIELD_HIDDEN: return asset->type.hidden;
+        case FIELD_CTIME:  return (long long)asset->timestamp.creation;
+        case FIELD_ATIME:  return (long long)asset->timestamp.access;
+        case FIELD_MTIME:  return (long long)asset->timestamp.modification;
+        default:           return 0;
+    }
+}
+
+/**
+ * @brief Evaluate a single predicate against the asset.
+ *
+ * @param instruction   'OP_TEST' instruction
+ * @param asset         pointer to the asset
+ * @return BOOL         TRUE if the predicate holds, FALSE otherwise
+ */
+local_function BOOL TestPredicate(const filter_instruction_t *instruction, const asset_t *asset)
+{
+    int order = 0;
+
+    if (instruction->text != NULL)
+    {
+        char buffer[4] = { 0 };
+        const char *value = GetStringField(instruction->field, asset, buffer);
+
+        if (instruction->compare == CMP_MATCH)
+        {
+            return MatchPattern(instruction->text, value);
+        }
+
+        order = _strcmpi(value, instruction->text);
+    }
+    else
+    {
+        long long value = GetNumberField(instruction->field, asset);
+        order = (value > instruction->number) - (value < instruction->number);
+    }
+
+    switch (instruction->compare)
+    {
+        case CMP_EQ: return order == 0;
+        case CMP_NE: return order != 0;
+        case CMP_LT: return order < 0;
+        case CMP_LE: return order <= 0;
+        case CMP_GT: return order > 0;
+        case CMP_GE: return order >= 0;
+        default:     return FALSE;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+filter_t *CompileFilter(const char *expression, char *error, size_t errorSize)
+{
+    filter_parser_t *parser = calloc(1, sizeof(filter_parser_t));
+    filter_t *filter = calloc(1, sizeof(filter_t));
+
+    if (parser == NULL || filter == NULL)
+    {
+        sprintf_s(error, errorSize, "Not enough memory");
+        goto clean_up;
+    }
+
+    FILETIME now = { 0 };
+    ULARGE_INTEGER ul = { 0 };
+
+    GetSystemTimeAsFileTime(&now);
+    ul.LowPart = now.dwLowDateTime;
+    ul.HighPart = now.dwHighDateTime;
+
+    error[0] = '\0';
+    parser->error = error;
+    parser->errorSize = errorSize;
+
+    parser->filter = filter;
+    parser->now = (long long)ul.QuadPart;
+    parser->text = parser->current = parser->tokenStart = expression;
+
+    if (!NextToken(parser)) goto clean_up;
+    size_t root = ParseOr(parser);
+
+    if (root < FILTER_MAX_NODES && parser->token != TOKEN_END)
+    {
+        SetFilterError(parser, "Unexpected token");
+        goto clean_up;
+    }
+
+    if (root >= FILTER_MAX_NODES || !CompileConjunction(parser, root))
+    {
+        goto clean_up;
+    }
+
+    CHECK_DELETE(parser);
+    return filter;
+
+clean_up:
+    CHECK_DELETE(parser);
+    CHECK_DELETE(filter);
+    return NULL;
+}
+
+BOOL EvaluateFilter(const filter_t *filter, filter_stage_e stage, const asset_t *asset)
+{
+    if (filter == NULL)
+    {
+        return TRUE;
+    }
+
+    BOOL accumulator = TRUE;
+    const filter_program_t *program = &filter->programs[stage];
+
+    for (size_t pc = 0; pc < program->size;)
+    {
+        const filter_instruction_t *instruction = &program->code[pc++];
+
+        switch (instruction->opcode)
+        {
+            case OP_TEST:           accumulator = TestPredicate(instruction, asset); break;
+            case OP_NOT:            accumulator = !accumulator; break;
+            case OP_JUMP_IF_FALSE:  if (!accumulator) pc = instruction->target; break;
+            case OP_JUMP_IF_TRUE:   if (accumulator) pc = instruction->target; break;
+        }
+    }
+
+    return accumulator;
+}
+
+BOOL FilterHasStage(const filter_t *filter, filter_stage_e stage)
+{
+    return filter != NULL && filter->programs[stage].size > 0;
+}
+
+void DeleteFilter(filter_t *filter)
+{
+    CHECK_DELETE(filter);
+}
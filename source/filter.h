@@ -0,0 +1,63 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Stages of the asset information retrieval. The filter predicates
+ * are evaluated as soon as the information they need is available, an asset
+ * rejected on an early stage never pays the cost of the next ones.
+ */
+typedef enum filter_stage_e
+{
+    /** @brief Name and attributes, free from the directory enumeration. */
+    FILTER_STAGE_NAME,
+
+    /** @brief Size and timestamps. */
+    FILTER_STAGE_STAT,
+
+    /** @brief Owner, group and permissions, they need extra system calls. */
+    FILTER_STAGE_OWNER,
+
+    /** @brief Number of stages. */
+    FILTER_STAGE_COUNT
+} filter_stage_e;
+
+/**
+ * @brief Compile a filter expression into a program that can be evaluated
+ * for each asset. The expression is only parsed once.
+ *
+ * ex: size > 100M && mtime < -30d && ext in (".log", ".tmp")
+ *
+ * @param expression    text of the expression
+ * @param error         buffer where the error message is stored
+ * @param errorSize     size in bytes of the error buffer
+ * @return filter_t*    the compiled filter or NULL if the expression is not valid
+ */
+filter_t *CompileFilter(const char *expression, char *error, size_t errorSize);
+
+/**
+ * @brief Evaluate the predicates of a given stage against the asset. Only
+ * the asset information of the stage and the previous ones is used.
+ *
+ * @param filter    compiled filter, NULL accepts all the assets
+ * @param stage     stage of the asset information retrieval
+ * @param asset     pointer to the asset to check
+ * @return BOOL     TRUE if the asset is accepted, FALSE otherwise
+ */
+BOOL EvaluateFilter(const filter_t *filter, filter_stage_e stage, const asset_t *asset);
+
+/**
+ * @brief Check if the filter has predicates evaluated on a given stage.
+ *
+ * @param filter    compiled filter, NULL has no predicates
+ * @param stage     stage of the asset information retrieval
+ * @return BOOL     TRUE if the stage has predicates, FALSE otherwise
+ */
+BOOL FilterHasStage(const filter_t *filter, filter_stage_e stage);
+
+/**
+ * @brief Release the memory of the compiled filter.
+ *
+ * @param filter    compiled filter
+ */
+void DeleteFilter(filter_t *filter);
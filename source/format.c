@@ -0,0 +1,127 @@
+#include "format.h"
+#include "types.h"
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define SIZE_TEXT_WIDTH 9           // width of the size column, unit included
+
+///////////////////////////////////////////////////////////////////////////////
+
+char *PutNumber(char *at, const char *end, unsigned long long value, int width, char pad)
+{
+    char reversed[24];
+    int count = 0;
+
+    do
+    {
+        reversed[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (; width > count && at < end; --width) *at++ = pad;
+    while (count > 0 && at < end) *at++ = reversed[--count];
+
+    return at;
+}
+
+size_t FormatSize(size_t bytes, size_format_e format, char *buffer, size_t size)
+{
+    // NOTE(Andrei): Binary units in upper case and decimal ones as the SI
+    //               prefixes, a 64-bit size does not reach the zetta unit.
+    local_variable const char binaryUnits[] = "BKMGTPE";
+    local_variable const char decimalUnits[] = "BkMGTPE";
+
+    if (size == 0) return 0;
+
+    char *at = buffer;
+    const char *end = buffer + size - 1;
+
+    if (bytes == 0)
+    {
+        for (int i = 1; i < SIZE_TEXT_WIDTH && at < end; ++i) *at++ = ' ';
+        if (at < end) *at++ = '-';
+    }
+    else if (format == SIZE_FORMAT_BYTES)
+    {
+        at = PutNumber(at, end, bytes, SIZE_TEXT_WIDTH - 1, ' ');
+        if (at < end) *at++ = 'B';
+    }
+    else
+    {
+        unsigned long long base = format == SIZE_FORMAT_SI ? 1000 : 1024;
+        unsigned long long unitSize = 1;
+        size_t unit = 0;
+
+        while (unit < 6 && bytes > unitSize * base)
+        {
+            unitSize *= base;
+            ++unit;
+        }
+
+        // NOTE(Andrei): The size is scaled to the previous unit first so the
+        //               remainder times 100 does not overflow.
+        unsigned long long whole = bytes, hundredths = 0;
+
+        if (unit > 0)
+        {
+            unsigned long long scaled = bytes / (unitSize / base);
+            whole = scaled / base;
+            hundredths = ((scaled % base) * 100 + base / 2) / base;
+
+            if (hundredths == 100)
+            {
+                hundredths = 0;
+                ++whole;
+            }
+        }
+
+        at = PutNumber(at, end, whole, SIZE_TEXT_WIDTH - 4, ' ');
+        if (at < end) *at++ = '.';
+
+        at = PutNumber(at, end, hundredths, 2, '0');
+        if (at < end) *at++ = format == SIZE_FORMAT_SI ? decimalUnits[unit] : binaryUnits[unit];
+    }
+
+    *at = '\0';
+    return (size_t)(at - buffer);
+}
+
+size_t FormatPermissions(const access_rights_t *rights, char *buffer, size_t size)
+{
+    if (size == 0) return 0;
+
+    char text[4] =
+    {
+        rights->read ? 'r' : '-',
+        rights->write ? 'w' : '-',
+        rights->execution ? 'x' : '-',
+        '\0'
+    };
+
+    size_t length = 0;
+    for (; length < 3 && length < size - 1; ++length) buffer[length] = text[length];
+
+    buffer[length] = '\0';
+    return length;
+}
+
+unsigned long long GetDisplayTimestamp(const asset_t *asset, sort_by_e sortField)
+{
+    switch (sortField)
+    {
+        case SORT_BY_LAST_ACCESSED: return asset->timestamp.access;
+        case SORT_BY_LAST_MODIFIED: return asset->timestamp.modification;
+        default: return asset->timestamp.creation;
+    }
+}
+
+char FormatAssetType(const asset_t *asset)
+{
+    // NOTE(Andrei): Order dependency, a symlink can also have
+    //               the directory attribute marked.
+
+    if (asset->type.symlink)   return 'l';
+    if (asset->type.directory) return 'd';
+
+    return '-';
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * Formatters of the fields of a row of the long format. All of them write
+ * into the buffer of the caller with integer arithmetic, they do not allocate
+ * nor keep state so they can be called from several threads at once. The
+ * dates are formatted with 'FormatDateTime' (see 'datetime.h').
+ */
+
+/**
+ * @brief Write a number right aligned to a width, the digits are kept if the
+ * number is wider. It stops at the end of the buffer, no terminator is added.
+ *
+ * @param at        where the number is written
+ * @param end       end of the buffer
+ * @param value     number to write
+ * @param width     minimum number of characters
+ * @param pad       character used to fill until the width
+ * @return char*    position after the number
+ */
+char *PutNumber(char *at, const char *end, unsigned long long value, int width, char pad);
+
+/**
+ * @brief Write the size of an asset, right aligned to 9 characters. A size
+ * of zero is shown as a hyphen.
+ *
+ * ex: '    1.50K', '    1.54k', '    1536B' or '        -'
+ *
+ * @param bytes     size of the asset in bytes
+ * @param format    see 'size_format_e'
+ * @param buffer    buffer where the text is written
+ * @param size      size of the buffer (see 'SIZE_TEXT_SIZE')
+ * @return size_t   number of characters written
+ */
+size_t FormatSize(size_t bytes, size_format_e format, char *buffer, size_t size);
+
+/**
+ * @brief Write the access rights of the current user ('rwx', '-' if the
+ * right is not granted).
+ *
+ * @param rights    access rights of the asset
+ * @param buffer    buffer where the text is written
+ * @param size      size of the buffer, at least 4 characters for the full text
+ * @return size_t   number of characters written
+ */
+size_t FormatPermissions(const access_rights_t *rights, char *buffer, size_t size);
+
+/**
+ * @brief Timestamp shown in the long format. By default the creation time
+ * it will be used, in case of sorting by time the sorted one.
+ *
+ * @param asset                 pointer to the asset
+ * @param sortField             field used to sort the assets
+ * @return unsigned long long   FILETIME timestamp
+ */
+unsigned long long GetDisplayTimestamp(const asset_t *asset, sort_by_e sortField);
+
+/**
+ * @brief Type of the asset as a character, 'l' for symbolic links, 'd' for
+ * directories and '-' for the rest.
+ *
+ * @param asset     pointer to the asset
+ * @return char     character of the type
+ */
+char FormatAssetType(const asset_t *asset);
@@ -0,0 +1,1983 @@
+#include "git.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "glob.h"
+#include "utils.h"
+
+#define GIT_HASH_SIZE       20      // bytes of a SHA-1 object name
+#define GIT_MAX_DELTA_DEPTH 64      // maximum chain of deltas of a packed object
+#define GIT_MAX_IGNORE_LEVELS 128   // maximum depth of the directories with .gitignore files
+
+#define GIT_OBJECT_COMMIT   1
+#define GIT_OBJECT_TREE     2
+#define GIT_OBJECT_BLOB     3
+#define GIT_OBJECT_TAG      4
+#define GIT_OBJECT_OFS_DELTA 6
+#define GIT_OBJECT_REF_DELTA 7
+
+#define GIT_INDEX_STAGE(flags)      (((flags) >> 12) & 3)
+#define GIT_INDEX_ASSUME_VALID      0x8000
+#define GIT_INDEX_EXTENDED          0x4000
+#define GIT_INDEX_SKIP_WORKTREE     0x4000
+#define GIT_INDEX_INTENT_TO_ADD     0x2000
+
+#define GIT_MODE_GITLINK    0160000
+
+// FILETIME ticks between 01 Jan 1601 and 01 Jan 1970
+#define UNIX_EPOCH_TICKS    116444736000000000ULL
+
+/**
+ * @brief Read only mapping of a whole file.
+ *
+ * 'hFile'      : handle of the file
+ * 'hMapping'   : handle of the mapping, NULL for empty files
+ * 'data'       : first byte of the file
+ * 'size'       : number of bytes of the file
+ */
+typedef struct git_file_t
+{
+    HANDLE hFile, hMapping;
+
+    const unsigned char *data;
+    size_t size;
+} git_file_t;
+
+/**
+ * @brief Entry of the index, the times are the cached stat data.
+ *
+ * 'path'       : path relative to the worktree with '/' delimiters
+ * 'mtime'      : modification time (seconds since 1970)
+ * 'mtimeNsec'  : nanoseconds of the modification time
+ * 'size'       : size of the document (lower 32 bits)
+ * 'mode'       : type and permissions of the entry
+ * 'hash'       : name of the blob
+ * 'flags'      : flags of the entry (stage, assume valid)
+ * 'extended'   : extended flags (skip worktree, intent to add)
+ */
+typedef struct git_index_entry_t
+{
+    const char *path;
+
+    unsigned int mtime, mtimeNsec;
+    unsigned int size, mode;
+
+    unsigned char hash[GIT_HASH_SIZE];
+    unsigned short flags, extended;
+} git_index_entry_t;
+
+/**
+ * @brief Pattern of a .gitignore file.
+ *
+ * 'pattern'    : pattern without the '!', the leading '/' and the trailing '/'
+ * 'negate'     : the pattern starts with '!'
+ * 'directory'  : the pattern ends with '/', it only matches directories
+ * 'anchored'   : the pattern has a '/', it is relative to its .gitignore
+ */
+typedef struct git_ignore_t
+{
+    const char *pattern;
+    BOOL negate, directory, anchored;
+} git_ignore_t;
+
+/**
+ * @brief Patterns of the .gitignore file of a directory.
+ *
+ * 'base'       : directory relative to the worktree ('' for the root)
+ * 'text'       : content of the file, the patterns point to it
+ * 'patterns'   : patterns of the file in order
+ * 'count'      : number of patterns
+ */
+typedef struct git_ignore_level_t
+{
+    char base[MAX_PATH];
+    char *text;
+
+    git_ignore_t *patterns;
+    size_t count;
+} git_ignore_level_t;
+
+/**
+ * @brief Pack of objects and its index.
+ */
+typedef struct git_pack_t
+{
+    git_file_t idx, pack;
+} git_pack_t;
+
+/**
+ * @brief Entry of a tree object, the strings point to the object.
+ */
+typedef struct git_tree_entry_t
+{
+    const char *name;
+    unsigned int mode;
+    const unsigned char *hash;
+} git_tree_entry_t;
+
+/**
+ * @brief State of the inflate decoder (RFC 1951).
+ *
+ * 'in', 'inEnd'    : compressed bytes
+ * 'bits', 'count'  : bits read and not used yet
+ * 'out'            : decompressed bytes
+ * 'size'           : number of decompressed bytes
+ * 'capacity'       : space available on 'out'
+ * 'limit'          : maximum number of decompressed bytes, 0 for no limit
+ * 'error'          : the stream is not valid, it is bigger than the limit or
+ *                    there is not enough memory
+ */
+typedef struct inflate_t
+{
+    const unsigned char *in, *inEnd;
+    unsigned int bits, count;
+
+    unsigned char *out;
+    size_t size, capacity, limit;
+
+    BOOL error;
+} inflate_t;
+
+/**
+ * @brief Canonical Huffman code, number of codes of each length and the
+ * symbols sorted by code.
+ */
+typedef struct inflate_tree_t
+{
+    unsigned short counts[16];
+    unsigned short symbols[288];
+} inflate_tree_t;
+
+/**
+ * @brief State of a SHA-1 hash computed by parts.
+ */
+typedef struct sha1_state_t
+{
+    unsigned int h[5];
+    unsigned long long total;
+
+    unsigned char buffer[64];
+    size_t buffered;
+} sha1_state_t;
+
+struct git_repository_t
+{
+    /** @brief Root of the worktree and its length. */
+    char worktree[MAX_PATH];
+    size_t worktreeLength;
+
+    /** @brief Directory with the index and HEAD, and the one with the objects and the refs. */
+    char gitDir[MAX_PATH];
+    char commonDir[MAX_PATH];
+
+    /** @brief Mapping of the index, its entries and the time it was written (seconds since 1970). */
+    git_file_t index;
+    git_index_entry_t *entries;
+    size_t numEntries;
+    unsigned long long indexTime;
+
+    /** @brief Paths of the index version 4 (prefix compressed). */
+    char *paths;
+
+    /** @brief Patterns of info\exclude and of the .gitignore files from the root to the current directory. */
+    git_ignore_level_t exclude;
+    git_ignore_level_t *levels;
+    size_t numLevels;
+
+    /** @brief Packs of the object database. */
+    git_pack_t *packs;
+    size_t numPacks;
+
+    /** @brief Tree of the HEAD commit, FALSE if there is no commit yet. */
+    BOOL hasHead;
+    unsigned char headTree[GIT_HASH_SIZE];
+
+    /** @brief Entries of the HEAD tree of the current directory. */
+    unsigned char *treeData;
+    git_tree_entry_t *tree;
+    size_t treeSize;
+    BOOL hasTree;
+
+    /** @brief Directory of the loaded ignore levels and tree, relative to the worktree. */
+    char directory[MAX_PATH];
+    BOOL loaded;
+};
+
+global_variable const unsigned short g_LengthBase[29] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+global_variable const unsigned char g_LengthExtra[29] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+global_variable const unsigned short g_DistanceBase[30] =
+{
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+global_variable const unsigned char g_DistanceExtra[30] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Map a whole file for reading, the empty files have no mapping.
+ *
+ * @param path      path of the file
+ * @param file      pointer where the mapping is stored
+ * @return BOOL     TRUE if the file is mapped, FALSE otherwise
+ */
+local_function BOOL MapGitFile(const char *path, git_file_t *file)
+{
+    memset(file, 0, sizeof(git_file_t));
+
+    file->hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file->hFile == INVALID_HANDLE_VALUE) goto clean_up;
+
+    LARGE_INTEGER size = { 0 };
+    if (!GetFileSizeEx(file->hFile, &size)) goto clean_up;
+
+    file->size = (size_t)size.QuadPart;
+    if (file->size == 0) return TRUE;
+
+    file->hMapping = CreateFileMappingA(file->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file->hMapping == NULL) goto clean_up;
+
+    file->data = MapViewOfFile(file->hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (file->data == NULL) goto clean_up;
+
+    return TRUE;
+
+clean_up:
+    if (file->hMapping != NULL) CloseHandle(file->hMapping);
+    if (file->hFile != INVALID_HANDLE_VALUE && file->hFile != NULL) CloseHandle(file->hFile);
+
+    memset(file, 0, sizeof(git_file_t));
+    return FALSE;
+}
+
+/**
+ * @brief Release the mapping of a file, see 'MapGitFile'.
+ *
+ * @param file      pointer to the mapping
+ */
+local_function void UnmapGitFile(git_file_t *file)
+{
+    if (file->data != NULL) UnmapViewOfFile(file->data);
+    if (file->hMapping != NULL) CloseHandle(file->hMapping);
+    if (file->hFile != NULL && file->hFile != INVALID_HANDLE_VALUE) CloseHandle(file->hFile);
+
+    memset(file, 0, sizeof(git_file_t));
+}
+
+/**
+ * @brief Read a small text file (HEAD, refs, commondir) without the trailing
+ * end of lines.
+ *
+ * @param path          path of the file
+ * @param buffer        buffer where the text is stored
+ * @param bufferSize    size of the buffer
+ * @return BOOL         TRUE if the file is read, FALSE otherwise
+ */
+local_function BOOL ReadGitText(const char *path, char *buffer, size_t bufferSize)
+{
+    git_file_t file;
+    if (!MapGitFile(path, &file)) return FALSE;
+
+    size_t length = file.size < bufferSize - 1 ? file.size : bufferSize - 1;
+    if (length > 0) memcpy(buffer, file.data, length);
+
+    while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r' || buffer[length - 1] == ' ')) --length;
+    buffer[length] = '\0';
+
+    UnmapGitFile(&file);
+    return TRUE;
+}
+
+/**
+ * @brief Read a big endian 32 bit value.
+ *
+ * @param p                 pointer to the bytes
+ * @return unsigned int     the value
+ */
+local_function unsigned int ReadBigEndian32(const unsigned char *p)
+{
+    return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+/**
+ * @brief Convert 40 hexadecimal characters to an object name.
+ *
+ * @param text      hexadecimal text
+ * @param hash      buffer where the name is stored
+ * @return BOOL     TRUE if the text is valid, FALSE otherwise
+ */
+local_function BOOL ParseGitHash(const char *text, unsigned char *hash)
+{
+    for (size_t i = 0; i < GIT_HASH_SIZE * 2; ++i)
+    {
+        char c = text[i];
+        int value = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+
+        if (value < 0) return FALSE;
+        hash[i / 2] = (unsigned char)((i % 2) ? (hash[i / 2] << 4) | value : value);
+    }
+
+    return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Rotate the bits of a 32 bit value to the left.
+ *
+ * @param x                 value to rotate
+ * @param r                 number of bits (1 to 31)
+ * @return unsigned int     rotated value
+ */
+local_function unsigned int RotateLeft32(unsigned int x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+/**
+ * @brief Process a block of 64 bytes of a SHA-1 hash.
+ *
+ * @param state     pointer to the state
+ * @param block     bytes of the block
+ */
+local_function void ProcessSha1Block(sha1_state_t *state, const unsigned char *block)
+{
+    unsigned int w[80];
+
+    for (size_t i = 0; i < 16; ++i) w[i] = ReadBigEndian32(block + i * 4);
+    for (size_t i = 16; i < 80; ++i) w[i] = RotateLeft32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    unsigned int a = state->h[0], b = state->h[1], c = state->h[2], d = state->h[3], e = state->h[4];
+
+    for (size_t i = 0; i < 80; ++i)
+    {
+        unsigned int f, k;
+
+        if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+        unsigned int t = RotateLeft32(a, 5) + f + e + k + w[i];
+        e = d; d = c; c = RotateLeft32(b, 30); b = a; a = t;
+    }
+
+    state->h[0] += a; state->h[1] += b; state->h[2] += c; state->h[3] += d; state->h[4] += e;
+}
+
+/**
+ * @brief Start a SHA-1 hash.
+ *
+ * @param state     pointer to the state
+ */
+local_function void ResetSha1(sha1_state_t *state)
+{
+    memset(state, 0, sizeof(sha1_state_t));
+
+    state->h[0] = 0x67452301; state->h[1] = 0xEFCDAB89; state->h[2] = 0x98BADCFE;
+    state->h[3] = 0x10325476; state->h[4] = 0xC3D2E1F0;
+}
+
+/**
+ * @brief Hash the next bytes of the input.
+ *
+ * @param state     pointer to the state
+ * @param data      bytes to hash
+ * @param size      number of bytes
+ */
+local_function void UpdateSha1(sha1_state_t *state, const unsigned char *data, size_t size)
+{
+    state->total += size;
+
+    while (size > 0)
+    {
+        if (state->buffered == 0 && size >= 64)
+        {
+            ProcessSha1Block(state, data);
+            data += 64; size -= 64;
+            continue;
+        }
+
+        size_t fill = 64 - state->buffered < size ? 64 - state->buffered : size;
+        memcpy(state->buffer + state->buffered, data, fill);
+
+        state->buffered += fill;
+        data += fill; size -= fill;
+
+        if (state->buffered == 64)
+        {
+            ProcessSha1Block(state, state->buffer);
+            state->buffered = 0;
+        }
+    }
+}
+
+/**
+ * @brief Finish the hash of the input.
+ *
+ * @param state     pointer to the state
+ * @param hash      buffer where the 20 bytes of the hash are stored
+ */
+local_function void DigestSha1(sha1_state_t *state, unsigned char *hash)
+{
+    unsigned long long bits = state->total * 8;
+    unsigned char padding[72] = { 0x80 };
+    unsigned char length[8];
+
+    for (size_t i = 0; i < 8; ++i) length[i] = (unsigned char)(bits >> (56 - i * 8));
+
+    size_t padSize = state->buffered < 56 ? 56 - state->buffered : 120 - state->buffered;
+    UpdateSha1(state, padding, padSize);
+    UpdateSha1(state, length, 8);
+
+    for (size_t i = 0; i < 5; ++i)
+    {
+        hash[i * 4 + 0] = (unsigned char)(state->h[i] >> 24);
+        hash[i * 4 + 1] = (unsigned char)(state->h[i] >> 16);
+        hash[i * 4 + 2] = (unsigned char)(state->h[i] >> 8);
+        hash[i * 4 + 3] = (unsigned char)(state->h[i]);
+    }
+}
+
+/**
+ * @brief Compute the name of the blob of a document ("blob <size>\0" and
+ * its content), the document is mapped.
+ *
+ * @param path      path of the document
+ * @param hash      buffer where the name is stored
+ * @return BOOL     TRUE if the document can be read, FALSE otherwise
+ */
+local_function BOOL HashGitBlob(const char *path, unsigned char *hash)
+{
+    git_file_t file;
+    if (!MapGitFile(path, &file)) return FALSE;
+
+    char header[32];
+    int length = snprintf(header, sizeof(header), "blob %zu", file.size);
+
+    sha1_state_t state;
+    ResetSha1(&state);
+    UpdateSha1(&state, (const unsigned char *)header, (size_t)length + 1);
+    UpdateSha1(&state, file.data, file.size);
+    DigestSha1(&state, hash);
+
+    UnmapGitFile(&file);
+    return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Read bits of the compressed stream, the first bit is the lowest one.
+ *
+ * @param s                 pointer to the decoder
+ * @param n                 number of bits (0 to 16)
+ * @return unsigned int     the bits, 0 at the end of the stream
+ */
+local_function unsigned int GetInflateBits(inflate_t *s, unsigned int n)
+{
+    while (s->count < n)
+    {
+        if (s->in >= s->inEnd)
+        {
+            s->error = TRUE;
+            return 0;
+        }
+
+        s->bits |= (unsigned int)*s->in++ << s->count;
+        s->count += 8;
+    }
+
+    unsigned int value = s->bits & ((1u << n) - 1);
+    s->bits >>= n;
+    s->count -= n;
+
+    return value;
+}
+
+/**
+ * @brief Append a byte to the decompressed bytes, past the limit the stream
+ * is an error.
+ *
+ * @param s         pointer to the decoder
+ * @param value     byte to append
+ */
+local_function void PutInflateByte(inflate_t *s, unsigned char value)
+{
+    if (s->limit != 0 && s->size == s->limit)
+    {
+        s->error = TRUE;
+        return;
+    }
+
+    if (s->size == s->capacity)
+    {
+        size_t newCapacity = s->capacity ? s->capacity * 2 : 4096;
+        unsigned char *out = realloc(s->out, newCapacity);
+
+        if (out == NULL)
+        {
+            s->error = TRUE;
+            return;
+        }
+
+        s->out = out;
+        s->capacity = newCapacity;
+    }
+
+    s->out[s->size++] = value;
+}
+
+/**
+ * @brief Build a canonical Huffman code from the lengths of its codes.
+ *
+ * @param tree      pointer where the code is stored
+ * @param lengths   length of the code of each symbol
+ * @param n         number of symbols
+ */
+local_function void BuildInflateTree(inflate_tree_t *tree, const unsigned char *lengths, size_t n)
+{
+    unsigned short offsets[16];
+    memset(tree->counts, 0, sizeof(tree->counts));
+
+    for (size_t i = 0; i < n; ++i) tree->counts[lengths[i]]++;
+    tree->counts[0] = 0;
+
+    for (size_t i = 0, sum = 0; i < 16; ++i)
+    {
+        offsets[i] = (unsigned short)sum;
+        sum += tree->counts[i];
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (lengths[i] != 0) tree->symbols[offsets[lengths[i]]++] = (unsigned short)i;
+    }
+}
+
+/**
+ * @brief Decode a symbol reading the code bit by bit.
+ *
+ * @param s         pointer to the decoder
+ * @param tree      code of the symbols
+ * @return int      the symbol or -1 if the code is not valid
+ */
+local_function int DecodeInflateSymbol(inflate_t *s, const inflate_tree_t *tree)
+{
+    int code = 0, first = 0, index = 0;
+
+    for (size_t length = 1; length < 16; ++length)
+    {
+        code |= (int)GetInflateBits(s, 1);
+        int count = tree->counts[length];
+
+        if (code - count < first) return tree->symbols[index + (code - first)];
+
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    s->error = TRUE;
+    return -1;
+}
+
+/**
+ * @brief Decode a block compressed with Huffman codes.
+ *
+ * @param s         pointer to the decoder
+ * @param lengths   code of the literals and the lengths
+ * @param distances code of the distances
+ */
+local_function void InflateBlock(inflate_t *s, const inflate_tree_t *lengths, const inflate_tree_t *distances)
+{
+    while (!s->error)
+    {
+        int symbol = DecodeInflateSymbol(s, lengths);
+
+        if (symbol < 256)
+        {
+            if (symbol >= 0) PutInflateByte(s, (unsigned char)symbol);
+            continue;
+        }
+
+        if (symbol == 256) return;
+
+        symbol -= 257;
+        if (symbol >= 29) { s->error = TRUE; return; }
+
+        size_t length = g_LengthBase[symbol] + GetInflateBits(s, g_LengthExtra[symbol]);
+        int distanceSymbol = DecodeInflateSymbol(s, distances);
+        if (distanceSymbol < 0 || distanceSymbol >= 30) { s->error = TRUE; return; }
+
+        size_t distance = g_DistanceBase[distanceSymbol] + GetInflateBits(s, g_DistanceExtra[distanceSymbol]);
+        if (distance > s->size) { s->error = TRUE; return; }
+
+        // NOTE(Andrei): The copy can overlap its own output (runs), it is
+        //               done byte by byte on purpose.
+        for (size_t i = 0; i < length && !s->error; ++i)
+        {
+            PutInflateByte(s, s->out[s->size - distance]);
+        }
+    }
+}
+
+/**
+ * @brief Read the codes of a dynamic block.
+ *
+ * @param s         pointer to the decoder
+ * @param lengths   pointer where the code of the literals and lengths is stored
+ * @param distances pointer where the code of the distances is stored
+ */
+local_function void ReadInflateTrees(inflate_t *s, inflate_tree_t *lengths, inflate_tree_t *distances)
+{
+    local_variable const unsigned char order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    unsigned char codeLengths[320] = { 0 };
+    inflate_tree_t codes;
+
+    unsigned int numLengths = GetInflateBits(s, 5) + 257;
+    unsigned int numDistances = GetInflateBits(s, 5) + 1;
+    unsigned int numCodes = GetInflateBits(s, 4) + 4;
+
+    for (unsigned int i = 0; i < numCodes; ++i)
+    {
+        codeLengths[order[i]] = (unsigned char)GetInflateBits(s, 3);
+    }
+
+    BuildInflateTree(&codes, codeLengths, 19);
+    memset(codeLengths, 0, sizeof(codeLengths));
+
+    for (unsigned int i = 0; i < numLengths + numDistances && !s->error;)
+    {
+        int symbol = DecodeInflateSymbol(s, &codes);
+        unsigned int repeat = 0;
+        unsigned char value = 0;
+
+        if (symbol < 0) return;
+
+        if (symbol < 16)
+        {
+            codeLengths[i++] = (unsigned char)symbol;
+            continue;
+        }
+
+        if (symbol == 16)
+        {
+            if (i == 0) { s->error = TRUE; return; }
+            value = codeLengths[i - 1];
+            repeat = 3 + GetInflateBits(s, 2);
+        }
+        else if (symbol == 17)
+        {
+            repeat = 3 + GetInflateBits(s, 3);
+        }
+        else
+        {
+            repeat = 11 + GetInflateBits(s, 7);
+        }
+
+        if (i + repeat > numLengths + numDistances) { s->error = TRUE; return; }
+        while (repeat-- > 0) codeLengths[i++] = value;
+    }
+
+    BuildInflateTree(lengths, codeLengths, numLengths);
+    BuildInflateTree(distances, codeLengths + numLengths, numDistances);
+}
+
+/**
+ * @brief Decompress a zlib stream (RFC 1950), the checksum is not verified.
+ *
+ * @param data              compressed bytes
+ * @param size              number of compressed bytes
+ * @param expected          expected number of decompressed bytes, 0 if unknown,
+ *                          a bigger stream is an error
+ * @param outSize           pointer where the number of decompressed bytes is stored
+ * @return unsigned char*   the decompressed bytes (release with free) or NULL on error
+ */
+local_function unsigned char *InflateZlib(const unsigned char *data, size_t size, size_t expected, size_t *outSize)
+{
+    inflate_t s = { 0 };
+
+    if (size < 2 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0) return NULL;
+
+    s.in = data + 2;
+    s.inEnd = data + size;
+    s.capacity = expected + 1;
+    s.limit = expected;
+    s.out = malloc(s.capacity);
+    if (s.out == NULL) return NULL;
+
+    BOOL last = FALSE;
+
+    while (!last && !s.error)
+    {
+        last = GetInflateBits(&s, 1);
+        unsigned int type = GetInflateBits(&s, 2);
+
+        if (type == 0)
+        {
+            s.bits = s.count = 0;
+
+            if (s.inEnd - s.in < 4) { s.error = TRUE; break; }
+            size_t length = s.in[0] | (s.in[1] << 8);
+            s.in += 4;
+
+            if ((size_t)(s.inEnd - s.in) < length) { s.error = TRUE; break; }
+            for (size_t i = 0; i < length && !s.error; ++i) PutInflateByte(&s, *s.in++);
+        }
+        else if (type == 1)
+        {
+            inflate_tree_t lengths, distances;
+            unsigned char codeLengths[288 + 30];
+
+            memset(codeLengths, 8, 144);
+            memset(codeLengths + 144, 9, 112);
+            memset(codeLengths + 256, 7, 24);
+            memset(codeLengths + 280, 8, 8);
+            memset(codeLengths + 288, 5, 30);
+
+            BuildInflateTree(&lengths, codeLengths, 288);
+            BuildInflateTree(&distances, codeLengths + 288, 30);
+            InflateBlock(&s, &lengths, &distances);
+        }
+        else if (type == 2)
+        {
+            inflate_tree_t lengths, distances;
+            ReadInflateTrees(&s, &lengths, &distances);
+            if (!s.error) InflateBlock(&s, &lengths, &distances);
+        }
+        else
+        {
+            s.error = TRUE;
+        }
+    }
+
+    if (s.error)
+    {
+        CHECK_DELETE(s.out);
+        return NULL;
+    }
+
+    *outSize = s.size;
+    return s.out;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+local_function unsigned char *ReadGitObject(git_repository_t *repository, const unsigned char *hash, int *type, size_t *size, int depth);
+
+/**
+ * @brief Find the offset of an object in a pack (index version 2).
+ *
+ * @param pack      pointer to the pack
+ * @param hash      name of the object
+ * @param offset    pointer where the offset is stored
+ * @return BOOL     TRUE if the object is in the pack, FALSE otherwise
+ */
+local_function BOOL FindPackOffset(const git_pack_t *pack, const unsigned char *hash, unsigned long long *offset)
+{
+    const unsigned char *idx = pack->idx.data;
+    if (pack->idx.size < 8 + 256 * 4 || ReadBigEndian32(idx) != 0xFF744F63 || ReadBigEndian32(idx + 4) != 2) return FALSE;
+
+    const unsigned char *fanout = idx + 8;
+    size_t count = ReadBigEndian32(fanout + 255 * 4);
+    size_t low = hash[0] ? ReadBigEndian32(fanout + (hash[0] - 1) * 4) : 0;
+    size_t high = ReadBigEndian32(fanout + hash[0] * 4);
+
+    const unsigned char *names = fanout + 256 * 4;
+    const unsigned char *offsets = names + count * (GIT_HASH_SIZE + 4);
+
+    if ((size_t)(offsets - idx) + count * 4 > pack->idx.size) return FALSE;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        int cmp = memcmp(names + middle * GIT_HASH_SIZE, hash, GIT_HASH_SIZE);
+
+        if (cmp == 0)
+        {
+            unsigned int value = ReadBigEndian32(offsets + middle * 4);
+
+            // NOTE(Andrei): Packs bigger than 2 GB keep the big offsets on
+            //               a second table, the high bit is its index.
+            if (value & 0x80000000)
+            {
+                const unsigned char *big = offsets + count * 4 + (size_t)(value & 0x7FFFFFFF) * 8;
+                if ((size_t)(big - idx) + 8 > pack->idx.size) return FALSE;
+
+                *offset = ((unsigned long long)ReadBigEndian32(big) << 32) | ReadBigEndian32(big + 4);
+            }
+            else
+            {
+                *offset = value;
+            }
+
+            return TRUE;
+        }
+
+        if (cmp < 0) low = middle + 1;
+        else high = middle;
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Apply a delta to its base object.
+ *
+ * @param base              bytes of the base object
+ * @param baseSize          number of bytes of the base object
+ * @param delta             instructions of the delta
+ * @param deltaSize         number of bytes of the delta
+ * @param outSize           pointer where the size of the result is stored
+ * @return unsigned char*   the object (release with free) or NULL if the delta is not valid
+ */
+local_function unsigned char *ApplyGitDelta(const unsigned char *base, size_t baseSize, const unsigned char *delta, size_t deltaSize, size_t *outSize)
+{
+    const unsigned char *p = delta, *end = delta + deltaSize;
+    size_t sizes[2] = { 0 };
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        unsigned int shift = 0;
+        unsigned char c;
+
+        do
+        {
+            if (p >= end) return NULL;
+            c = *p++;
+            sizes[i] |= (size_t)(c & 0x7F) << shift;
+            shift += 7;
+        } while (c & 0x80);
+    }
+
+    if (sizes[0] != baseSize) return NULL;
+
+    unsigned char *out = malloc(sizes[1] + 1);
+    size_t size = 0;
+    if (out == NULL) return NULL;
+
+    while (p < end)
+    {
+        unsigned char op = *p++;
+
+        if (op & 0x80)
+        {
+            size_t offset = 0, length = 0;
+
+            for (size_t i = 0; i < 4; ++i) if (op & (1 << i)) { if (p >= end) goto error; offset |= (size_t)*p++ << (i * 8); }
+            for (size_t i = 0; i < 3; ++i) if (op & (0x10 << i)) { if (p >= end) goto error; length |= (size_t)*p++ << (i * 8); }
+
+            if (length == 0) length = 0x10000;
+            if (offset + length > baseSize || size + length > sizes[1]) goto error;
+
+            memcpy(out + size, base + offset, length);
+            size += length;
+        }
+        else if (op != 0)
+        {
+            if ((size_t)(end - p) < op || size + op > sizes[1]) goto error;
+
+            memcpy(out + size, p, op);
+            size += op;
+            p += op;
+        }
+        else
+        {
+            goto error;
+        }
+    }
+
+    if (size != sizes[1]) goto error;
+
+    *outSize = size;
+    return out;
+
+error:
+    CHECK_DELETE(out);
+    return NULL;
+}
+
+/**
+ * @brief Read an object of a pack, the deltas are applied to their base.
+ *
+ * @param repository        pointer to the repository
+ * @param pack              pointer to the pack
+ * @param offset            offset of the object in the pack
+ * @param type              pointer where the type of the object is stored
+ * @param size              pointer where the size of the object is stored
+ * @param depth             number of deltas already applied
+ * @return unsigned char*   the object (release with free) or NULL on error
+ */
+local_function unsigned char *ReadPackObject(git_repository_t *repository, const git_pack_t *pack, unsigned long long offset, int *type, size_t *size, int depth)
+{
+    const unsigned char *p = pack->pack.data + offset;
+    const unsigned char *end = pack->pack.data + pack->pack.size;
+
+    if (depth > GIT_MAX_DELTA_DEPTH || offset >= pack->pack.size) return NULL;
+
+    unsigned char c = *p++;
+    int objectType = (c >> 4) & 7;
+    size_t objectSize = c & 15;
+    unsigned int shift = 4;
+
+    while (c & 0x80)
+    {
+        if (p >= end) return NULL;
+        c = *p++;
+        objectSize |= (size_t)(c & 0x7F) << shift;
+        shift += 7;
+    }
+
+    unsigned char *base = NULL;
+    size_t baseSize = 0;
+
+    if (objectType == GIT_OBJECT_OFS_DELTA)
+    {
+        if (p >= end) return NULL;
+        c = *p++;
+        unsigned long long distance = c & 0x7F;
+
+        while (c & 0x80)
+        {
+            if (p >= end) return NULL;
+            c = *p++;
+            distance = ((distance + 1) << 7) | (c & 0x7F);
+        }
+
+        if (distance > offset) return NULL;
+        base = ReadPackObject(repository, pack, offset - distance, type, &baseSize, depth + 1);
+    }
+    else if (objectType == GIT_OBJECT_REF_DELTA)
+    {
+        if (end - p < GIT_HASH_SIZE) return NULL;
+        base = ReadGitObject(repository, p, type, &baseSize, depth + 1);
+        p += GIT_HASH_SIZE;
+    }
+    else
+    {
+        *type = objectType;
+    }
+
+    size_t dataSize = 0;
+    unsigned char *data = InflateZlib(p, (size_t)(end - p), objectSize, &dataSize);
+
+    if (objectType != GIT_OBJECT_OFS_DELTA && objectType != GIT_OBJECT_REF_DELTA)
+    {
+        *size = dataSize;
+        return data;
+    }
+
+    unsigned char *object = NULL;
+
+    if (base != NULL && data != NULL)
+    {
+        object = ApplyGitDelta(base, baseSize, data, dataSize, size);
+    }
+
+    CHECK_DELETE(base);
+    CHECK_DELETE(data);
+
+    return object;
+}
+
+/**
+ * @brief Read an object, loose or packed.
+ *
+ * @param repository        pointer to the repository
+ * @param hash              name of the object
+ * @param type              pointer where the type of the object is stored
+ * @param size              pointer where the size of the object is stored
+ * @param depth             number of deltas already applied
+ * @return unsigned char*   the object without header (release with free) or NULL if it is not found
+ */
+local_function unsigned char *ReadGitObject(git_repository_t *repository, const unsigned char *hash, int *type, size_t *size, int depth)
+{
+    local_variable const char hex[] = "0123456789abcdef";
+
+    char path[MAX_PATH];
+    int length = snprintf(path, sizeof(path), "%s\\objects\\%c%c\\", repository->commonDir, hex[hash[0] >> 4], hex[hash[0] & 15]);
+
+    for (size_t i = 1; i < GIT_HASH_SIZE && length + 2 < (int)sizeof(path); ++i)
+    {
+        path[length++] = hex[hash[i] >> 4];
+        path[length++] = hex[hash[i] & 15];
+    }
+
+    path[length] = '\0';
+
+    git_file_t file;
+
+    if (MapGitFile(path, &file))
+    {
+        size_t dataSize = 0;
+        unsigned char *data = InflateZlib(file.data, file.size, 0, &dataSize);
+        UnmapGitFile(&file);
+
+        if (data == NULL) return NULL;
+
+        // NOTE(Andrei): Loose objects start with "<type> <size>\0".
+        unsigned char *header = memchr(data, '\0', dataSize);
+        if (header == NULL) { CHECK_DELETE(data); return NULL; }
+
+        *type = strncmp((char *)data, "tree ", 5) == 0 ? GIT_OBJECT_TREE :
+                strncmp((char *)data, "commit ", 7) == 0 ? GIT_OBJECT_COMMIT :
+                strncmp((char *)data, "blob ", 5) == 0 ? GIT_OBJECT_BLOB : GIT_OBJECT_TAG;
+
+        *size = dataSize - (size_t)(header + 1 - data);
+        memmove(data, header + 1, *size);
+
+        return data;
+    }
+
+    for (size_t i = 0; i < repository->numPacks; ++i)
+    {
+        unsigned long long offset = 0;
+
+        if (FindPackOffset(&repository->packs[i], hash, &offset))
+        {
+            return ReadPackObject(repository, &repository->packs[i], offset, type, size, depth);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Map the packs of the object database (objects\pack\*.idx).
+ *
+ * @param repository    pointer to the repository
+ */
+local_function void OpenGitPacks(git_repository_t *repository)
+{
+    char search[MAX_PATH];
+    snprintf(search, sizeof(search), "%s\\objects\\pack\\*.idx", repository->commonDir);
+
+    WIN32_FIND_DATAA fd;
+    HANDLE hFind = FindFirstFileA(search, &fd);
+    if (hFind == INVALID_HANDLE_VALUE) return;
+
+    do
+    {
+        git_pack_t pack = { 0 };
+        char path[MAX_PATH];
+
+        snprintf(path, sizeof(path), "%s\\objects\\pack\\%s", repository->commonDir, fd.cFileName);
+        if (!MapGitFile(path, &pack.idx)) continue;
+
+        size_t length = strlen(path);
+        strcpy_s(path + length - 4, sizeof(path) - length + 4, ".pack");
+
+        git_pack_t *packs = realloc(repository->packs, sizeof(git_pack_t) * (repository->numPacks + 1));
+
+        if (packs == NULL || !MapGitFile(path, &pack.pack))
+        {
+            if (packs != NULL) repository->packs = packs;
+            UnmapGitFile(&pack.idx);
+            continue;
+        }
+
+        repository->packs = packs;
+        repository->packs[repository->numPacks++] = pack;
+    } while (FindNextFileA(hFind, &fd));
+
+    FindClose(hFind);
+}
+
+/**
+ * @brief Resolve HEAD to its commit and read the tree of the commit. The
+ * branches are looked up as files and on packed-refs.
+ *
+ * @param repository    pointer to the repository
+ */
+local_function void ReadGitHead(git_repository_t *repository)
+{
+    char path[MAX_PATH], text[MAX_PATH];
+    unsigned char commit[GIT_HASH_SIZE];
+
+    snprintf(path, sizeof(path), "%s\\HEAD", repository->gitDir);
+    if (!ReadGitText(path, text, sizeof(text))) return;
+
+    if (strncmp(text, "ref: ", 5) == 0)
+    {
+        char ref[MAX_PATH];
+        strcpy_s(ref, sizeof(ref), text + 5);
+
+        snprintf(path, sizeof(path), "%s\\%s", repository->gitDir, ref);
+        BOOL found = ReadGitText(path, text, sizeof(text));
+
+        if (!found)
+        {
+            snprintf(path, sizeof(path), "%s\\%s", repository->commonDir, ref);
+            found = ReadGitText(path, text, sizeof(text));
+        }
+
+        if (!found)
+        {
+            git_file_t packed;
+            snprintf(path, sizeof(path), "%s\\packed-refs", repository->commonDir);
+            if (!MapGitFile(path, &packed)) return;
+
+            // NOTE(Andrei): Each line is "<hash> <ref>", the comments and
+            //               the peeled tags start with '#' and '^'.
+            size_t refLength = strlen(ref);
+            const char *line = (const char *)packed.data, *end = line + packed.size;
+
+            while (line < end && !found)
+            {
+                const char *eol = memchr(line, '\n', (size_t)(end - line));
+                if (eol == NULL) eol = end;
+
+                size_t lineLength = (size_t)(eol - line);
+                while (lineLength > 0 && line[lineLength - 1] == '\r') --lineLength;
+
+                if (lineLength == GIT_HASH_SIZE * 2 + 1 + refLength && memcmp(line + GIT_HASH_SIZE * 2 + 1, ref, refLength) == 0)
+                {
+                    memcpy(text, line, GIT_HASH_SIZE * 2);
+                    text[GIT_HASH_SIZE * 2] = '\0';
+                    found = TRUE;
+                }
+
+                line = eol + 1;
+            }
+
+            UnmapGitFile(&packed);
+            if (!found) return;
+        }
+    }
+
+    if (strlen(text) < GIT_HASH_SIZE * 2 || !ParseGitHash(text, commit)) return;
+
+    int type = 0;
+    size_t size = 0;
+    unsigned char *data = ReadGitObject(repository, commit, &type, &size, 0);
+
+    if (data != NULL && type == GIT_OBJECT_COMMIT && size > 5 + GIT_HASH_SIZE * 2 && memcmp(data, "tree ", 5) == 0)
+    {
+        repository->hasHead = ParseGitHash((const char *)data + 5, repository->headTree);
+    }
+
+    CHECK_DELETE(data);
+}
+
+/**
+ * @brief Read the entries of a tree object, they point to the object data.
+ *
+ * @param data      bytes of the tree object
+ * @param size      number of bytes
+ * @param entries   pointer where the entries are stored (release with free)
+ * @return size_t   number of entries
+ */
+local_function size_t ParseGitTree(const unsigned char *data, size_t size, git_tree_entry_t **entries)
+{
+    size_t count = 0, capacity = 0;
+    const unsigned char *p = data, *end = data + size;
+
+    *entries = NULL;
+
+    // NOTE(Andrei): Each entry is "<octal mode> <name>\0<20 bytes hash>".
+    while (p < end)
+    {
+        const unsigned char *space = memchr(p, ' ', (size_t)(end - p));
+        const unsigned char *name = space ? space + 1 : NULL;
+        const unsigned char *nul = name ? memchr(name, '\0', (size_t)(end - name)) : NULL;
+
+        if (nul == NULL || end - nul - 1 < GIT_HASH_SIZE) break;
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            git_tree_entry_t *newEntries = realloc(*entries, sizeof(git_tree_entry_t) * capacity);
+            if (newEntries == NULL) break;
+
+            *entries = newEntries;
+        }
+
+        unsigned int mode = 0;
+        for (const unsigned char *m = p; m < space; ++m) mode = mode * 8 + (unsigned int)(*m - '0');
+
+        (*entries)[count].name = (const char *)name;
+        (*entries)[count].mode = mode;
+        (*entries)[count].hash = nul + 1;
+        ++count;
+
+        p = nul + 1 + GIT_HASH_SIZE;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Compare two tree entries by name.
+ *
+ * @param a     pointer to the first entry
+ * @param b     pointer to the second entry
+ * @return int  negative if 'a' goes first, positive if 'b' goes first, 0 otherwise
+ */
+local_function int CompareGitTreeEntry(const void *a, const void *b)
+{
+    return strcmp(((const git_tree_entry_t *)a)->name, ((const git_tree_entry_t *)b)->name);
+}
+
+/**
+ * @brief Load the HEAD tree of a directory, the trees are walked from the
+ * root following the segments of the directory. The entries of the
+ * directory are sorted by name, see 'GetGitStagedStatus'.
+ *
+ * @param repository    pointer to the repository
+ * @param directory     directory relative to the worktree ('' for the root)
+ */
+local_function void LoadGitTree(git_repository_t *repository, const char *directory)
+{
+    CHECK_DELETE(repository->treeData);
+    CHECK_DELETE(repository->tree);
+    repository->treeSize = 0;
+    repository->hasTree = FALSE;
+
+    if (!repository->hasHead) return;
+
+    unsigned char hash[GIT_HASH_SIZE];
+    memcpy(hash, repository->headTree, GIT_HASH_SIZE);
+
+    for (const char *segment = directory;;)
+    {
+        int type = 0;
+        size_t size = 0;
+
+        repository->treeData = ReadGitObject(repository, hash, &type, &size, 0);
+        if (repository->treeData == NULL || type != GIT_OBJECT_TREE) return;
+
+        repository->treeSize = ParseGitTree(repository->treeData, size, &repository->tree);
+        if (*segment == '\0') break;
+
+        const char *next = strchr(segment, '/');
+        size_t length = next ? (size_t)(next - segment) : strlen(segment);
+        BOOL found = FALSE;
+
+        for (size_t i = 0; i < repository->treeSize; ++i)
+        {
+            const git_tree_entry_t *entry = &repository->tree[i];
+
+            if ((entry->mode & 0170000) == 0040000 && strncmp(entry->name, segment, length) == 0 && entry->name[length] == '\0')
+            {
+                memcpy(hash, entry->hash, GIT_HASH_SIZE);
+                found = TRUE;
+                break;
+            }
+        }
+
+        CHECK_DELETE(repository->treeData);
+        CHECK_DELETE(repository->tree);
+        repository->treeSize = 0;
+
+        // NOTE(Andrei): A directory that is not on HEAD has all its
+        //               entries added, the tree stays empty.
+        if (!found)
+        {
+            repository->hasTree = TRUE;
+            return;
+        }
+
+        segment = next ? next + 1 : segment + length;
+    }
+
+    // NOTE(Andrei): Git sorts the sub-trees as if their names ended
+    //               with '/', they are sorted again to be searched.
+    if (repository->treeSize > 1) qsort(repository->tree, repository->treeSize, sizeof(git_tree_entry_t), CompareGitTreeEntry);
+    repository->hasTree = TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Read a variable length integer of the index version 4.
+ *
+ * @param p         pointer to the bytes, it is advanced
+ * @param end       end of the bytes
+ * @return size_t   the value
+ */
+local_function size_t ReadIndexVarint(const unsigned char **p, const unsigned char *end)
+{
+    if (*p >= end) return 0;
+
+    unsigned char c = *(*p)++;
+    size_t value = c & 0x7F;
+
+    while ((c & 0x80) && *p < end)
+    {
+        c = *(*p)++;
+        value = ((value + 1) << 7) | (c & 0x7F);
+    }
+
+    return value;
+}
+
+/**
+ * @brief Map the index and read its entries (versions 2, 3 and 4). The
+ * extensions are not used.
+ *
+ * @param repository    pointer to the repository
+ * @return BOOL         TRUE if the index is valid, FALSE otherwise
+ */
+local_function BOOL ReadGitIndex(git_repository_t *repository)
+{
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\index", repository->gitDir);
+
+    // NOTE(Andrei): A repository without index (nothing added yet) has
+    //               all its assets untracked.
+    if (!MapGitFile(path, &repository->index)) return TRUE;
+
+    FILETIME written = { 0 };
+    GetFileTime(repository->index.hFile, NULL, NULL, &written);
+    repository->indexTime = ((((unsigned long long)written.dwHighDateTime << 32) | written.dwLowDateTime) - UNIX_EPOCH_TICKS) / 10000000ULL;
+
+    const unsigned char *data = repository->index.data;
+    const unsigned char *end = data + repository->index.size;
+
+    if (repository->index.size < 12 || memcmp(data, "DIRC", 4) != 0) return FALSE;
+
+    unsigned int version = ReadBigEndian32(data + 4);
+    size_t count = ReadBigEndian32(data + 8);
+
+    if (version < 2 || version > 4) return FALSE;
+
+    repository->entries = calloc(count + 1, sizeof(git_index_entry_t));
+    if (repository->entries == NULL) return FALSE;
+
+    // NOTE(Andrei): The paths of the version 4 only store what changes from
+    //               the previous path, they are rebuilt one after another on
+    //               a buffer that grows, the entries point to them at the end.
+    char previous[MAX_PATH] = { 0 };
+    size_t pathsSize = 0, pathsCapacity = 0;
+
+    const unsigned char *p = data + 12;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const unsigned char *entry = p;
+        if (end - p < 62) return FALSE;
+
+        git_index_entry_t *e = &repository->entries[i];
+        e->mtime = ReadBigEndian32(p + 8);
+        e->mtimeNsec = ReadBigEndian32(p + 12);
+        e->mode = ReadBigEndian32(p + 24);
+        e->size = ReadBigEndian32(p + 36);
+        memcpy(e->hash, p + 40, GIT_HASH_SIZE);
+        e->flags = (unsigned short)((p[60] << 8) | p[61]);
+        p += 62;
+
+        if (version >= 3 && (e->flags & GIT_INDEX_EXTENDED))
+        {
+            if (end - p < 2) return FALSE;
+            e->extended = (unsigned short)((p[0] << 8) | p[1]);
+            p += 2;
+        }
+
+        if (version == 4)
+        {
+            size_t strip = ReadIndexVarint(&p, end);
+            const unsigned char *nul = memchr(p, '\0', (size_t)(end - p));
+            size_t keep = strlen(previous);
+
+            if (nul == NULL || strip > keep) return FALSE;
+            keep -= strip;
+
+            size_t suffix = (size_t)(nul - p);
+            if (keep + suffix >= MAX_PATH) return FALSE;
+
+            if (pathsSize + keep + suffix + 1 > pathsCapacity)
+            {
+                size_t newCapacity = pathsCapacity ? pathsCapacity * 2 : repository->index.size + MAX_PATH;
+                char *paths = realloc(repository->paths, newCapacity);
+                if (paths == NULL) return FALSE;
+
+                repository->paths = paths;
+                pathsCapacity = newCapacity;
+            }
+
+            memcpy(previous + keep, p, suffix);
+            previous[keep + suffix] = '\0';
+
+            memcpy(repository->paths + pathsSize, previous, keep + suffix + 1);
+            pathsSize += keep + suffix + 1;
+
+            p = nul + 1;
+        }
+        else
+        {
+            const unsigned char *nul = memchr(p, '\0', (size_t)(end - p));
+            if (nul == NULL) return FALSE;
+
+            e->path = (const char *)p;
+
+            // NOTE(Andrei): The entries are padded with 1 to 8 '\0' to a
+            //               multiple of 8 bytes.
+            size_t length = ((size_t)(nul - entry) + 8) & ~(size_t)7;
+            p = entry + length;
+            if (p > end) return FALSE;
+        }
+    }
+
+    for (size_t i = 0, offset = 0; version == 4 && i < count; ++i)
+    {
+        repository->entries[i].path = repository->paths + offset;
+        offset += strlen(repository->entries[i].path) + 1;
+    }
+
+    repository->numEntries = count;
+    return TRUE;
+}
+
+/**
+ * @brief Find the first entry of the index not smaller than a path.
+ *
+ * @param repository    pointer to the repository
+ * @param path          path relative to the worktree
+ * @return size_t       index of the entry, 'numEntries' if all are smaller
+ */
+local_function size_t LowerBoundGitIndex(const git_repository_t *repository, const char *path)
+{
+    size_t low = 0, high = repository->numEntries;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (strcmp(repository->entries[middle].path, path) < 0) low = middle + 1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Read the patterns of an ignore file, the text is kept by the level.
+ *
+ * @param path      path of the ignore file
+ * @param base      directory of the patterns relative to the worktree
+ * @param level     pointer where the patterns are stored
+ */
+local_function void ReadIgnoreFile(const char *path, const char *base, git_ignore_level_t *level)
+{
+    memset(level, 0, sizeof(git_ignore_level_t));
+    strcpy_s(level->base, sizeof(level->base), base);
+
+    git_file_t file;
+    if (!MapGitFile(path, &file)) return;
+
+    level->text = malloc(file.size + 1);
+    size_t lines = 1;
+
+    if (level->text != NULL)
+    {
+        if (file.size > 0) memcpy(level->text, file.data, file.size);
+        level->text[file.size] = '\0';
+
+        for (size_t i = 0; i < file.size; ++i) lines += file.data[i] == '\n';
+        level->patterns = malloc(sizeof(git_ignore_t) * lines);
+    }
+
+    UnmapGitFile(&file);
+    if (level->patterns == NULL) return;
+
+    for (char *line = level->text; line != NULL && *line != '\0';)
+    {
+        char *eol = strchr(line, '\n');
+        char *next = eol ? eol + 1 : NULL;
+
+        if (eol == NULL) eol = line + strlen(line);
+        while (eol > line && (eol[-1] == '\r' || eol[-1] == ' ')) --eol;
+        *eol = '\0';
+
+        git_ignore_t pattern = { 0 };
+
+        if (*line == '#' || *line == '\0') goto next_line;
+        if (*line == '\\') ++line;
+
+        if (*line == '!')
+        {
+            pattern.negate = TRUE;
+            ++line;
+        }
+
+        if (eol > line && eol[-1] == '/')
+        {
+            pattern.directory = TRUE;
+            *--eol = '\0';
+        }
+
+        pattern.anchored = strchr(line, '/') != NULL;
+        if (*line == '/') ++line;
+
+        if (*line != '\0')
+        {
+            pattern.pattern = line;
+            level->patterns[level->count++] = pattern;
+        }
+
+    next_line:
+        line = next;
+    }
+}
+
+/**
+ * @brief Match a path against an anchored pattern, both with '/'
+ * delimiters. A '**' segment matches zero or more directories.
+ *
+ * @param pattern   pattern of the ignore file
+ * @param path      path relative to the ignore file
+ * @return BOOL     TRUE if the path matches, FALSE otherwise
+ */
+local_function BOOL MatchIgnorePath(const char *pattern, const char *path)
+{
+    if (pattern[0] == '*' && pattern[1] == '*' && (pattern[2] == '/' || pattern[2] == '\0'))
+    {
+        const char *rest = pattern[2] ? pattern + 3 : pattern + 2;
+        if (*rest == '\0') return TRUE;
+
+        for (const char *p = path; p != NULL; p = strchr(p, '/'), p = p ? p + 1 : NULL)
+        {
+            if (MatchIgnorePath(rest, p)) return TRUE;
+        }
+
+        return FALSE;
+    }
+
+    char segment[MAX_PATH];
+    const char *pathEnd = strchr(path, '/');
+    size_t length = pathEnd ? (size_t)(pathEnd - path) : strlen(path);
+
+    if (length >= sizeof(segment)) return FALSE;
+    memcpy(segment, path, length);
+    segment[length] = '\0';
+
+    if (!MatchPattern(pattern, segment)) return FALSE;
+
+    const char *patternEnd = strchr(pattern, '/');
+    if (patternEnd == NULL) return pathEnd == NULL;
+    if (pathEnd == NULL) return FALSE;
+
+    return MatchIgnorePath(patternEnd + 1, pathEnd + 1);
+}
+
+/**
+ * @brief Apply the patterns of a level to a path, the last matching pattern
+ * decides.
+ *
+ * @param level     patterns of an ignore file
+ * @param path      path relative to the worktree
+ * @param directory the path is a directory
+ * @param ignored   pointer with the current decision, it is updated
+ */
+local_function void MatchIgnoreLevel(const git_ignore_level_t *level, const char *path, BOOL directory, BOOL *ignored)
+{
+    size_t baseLength = strlen(level->base);
+
+    if (baseLength > 0)
+    {
+        if (strncmp(path, level->base, baseLength) != 0 || path[baseLength] != '/') return;
+        path += baseLength + 1;
+    }
+
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    for (size_t i = 0; i < level->count; ++i)
+    {
+        const git_ignore_t *pattern = &level->patterns[i];
+        if (pattern->directory && !directory) continue;
+
+        BOOL match = pattern->anchored ? MatchIgnorePath(pattern->pattern, path) : MatchPattern(pattern->pattern, name);
+        if (match) *ignored = !pattern->negate;
+    }
+}
+
+/**
+ * @brief Check if a path is ignored. A path inside an ignored directory is
+ * ignored too, the parent directories are checked first.
+ *
+ * @param repository    pointer to the repository
+ * @param path          path relative to the worktree
+ * @param directory     the path is a directory
+ * @return BOOL         TRUE if the path is ignored, FALSE otherwise
+ */
+local_function BOOL IsGitIgnored(const git_repository_t *repository, const char *path, BOOL directory)
+{
+    char prefix[MAX_PATH];
+    strcpy_s(prefix, sizeof(prefix), path);
+
+    for (char *slash = strchr(prefix, '/');; slash = strchr(slash + 1, '/'))
+    {
+        if (slash != NULL) *slash = '\0';
+
+        BOOL ignored = FALSE;
+        BOOL isDirectory = slash != NULL || directory;
+
+        MatchIgnoreLevel(&repository->exclude, prefix, isDirectory, &ignored);
+
+        for (size_t i = 0; i < repository->numLevels; ++i)
+        {
+            MatchIgnoreLevel(&repository->levels[i], prefix, isDirectory, &ignored);
+        }
+
+        if (ignored) return TRUE;
+        if (slash == NULL) return FALSE;
+
+        *slash = '/';
+    }
+}
+
+/**
+ * @brief Load the .gitignore files from the root to a directory, the ones of
+ * the previous directory that are still on the way are kept.
+ *
+ * @param repository    pointer to the repository
+ * @param directory     directory relative to the worktree ('' for the root)
+ */
+local_function void LoadIgnoreLevels(git_repository_t *repository, const char *directory)
+{
+    // NOTE(Andrei): Keep the levels whose base is the root or a parent of
+    //               the directory (or the directory itself).
+    size_t keep = 0;
+
+    while (keep < repository->numLevels)
+    {
+        const char *base = repository->levels[keep].base;
+        size_t length = strlen(base);
+
+        BOOL parent = length == 0 || (strncmp(directory, base, length) == 0 && (directory[length] == '/' || directory[length] == '\0'));
+        if (!parent) break;
+
+        ++keep;
+    }
+
+    for (size_t i = keep; i < repository->numLevels; ++i)
+    {
+        CHECK_DELETE(repository->levels[i].text);
+        CHECK_DELETE(repository->levels[i].patterns);
+    }
+
+    repository->numLevels = keep;
+
+    // NOTE(Andrei): Each segment of the directory after the kept levels
+    //               adds its own level, empty if it has no .gitignore.
+    char base[MAX_PATH] = { 0 };
+    size_t length = keep > 0 ? strlen(repository->levels[keep - 1].base) : 0;
+
+    if (keep > 0) memcpy(base, directory, length);
+
+    for (;;)
+    {
+        if (repository->numLevels > 0)
+        {
+            if (directory[length] == '\0') break;
+
+            const char *next = strchr(directory + length + (length > 0), '/');
+            length = next ? (size_t)(next - directory) : strlen(directory);
+            memcpy(base, directory, length);
+            base[length] = '\0';
+        }
+
+        if (repository->numLevels >= GIT_MAX_IGNORE_LEVELS) break;
+
+        char path[MAX_PATH];
+        char windowsBase[MAX_PATH];
+        strcpy_s(windowsBase, sizeof(windowsBase), base);
+
+        for (char *c = windowsBase; *c != '\0'; ++c) if (*c == '/') *c = '\\';
+
+        snprintf(path, sizeof(path), "%s%s%s\\.gitignore", repository->worktree, base[0] ? "\\" : "", windowsBase);
+        ReadIgnoreFile(path, base, &repository->levels[repository->numLevels++]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Find the root of the worktree of a directory, the closest parent
+ * with a '.git' directory or file.
+ *
+ * @param directory     full path of the directory
+ * @param worktree      buffer where the root is stored
+ * @param size          size of the buffer
+ * @return BOOL         TRUE if the directory is inside a worktree, FALSE otherwise
+ */
+local_function BOOL FindGitWorktree(const char *directory, char *worktree, size_t size)
+{
+    char path[MAX_PATH];
+    strcpy_s(worktree, size, directory);
+
+    size_t length = strlen(worktree);
+    while (length > 0 && (worktree[length - 1] == '\\' || worktree[length - 1] == '/')) worktree[--length] = '\0';
+
+    while (length > 0)
+    {
+        snprintf(path, sizeof(path), "%s\\.git", worktree);
+        if (GetFileAttributesA(path) != INVALID_FILE_ATTRIBUTES) return TRUE;
+
+        const char *delimiter = FindLastDelimiter(worktree, "\\/");
+        if (delimiter == NULL) return FALSE;
+
+        length = (size_t)(delimiter - worktree);
+        worktree[length] = '\0';
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Open the repository of a worktree. The '.git' can be a file with
+ * the path of the git directory (linked worktrees and submodules).
+ *
+ * @param worktree              root of the worktree
+ * @return git_repository_t*    the repository or NULL if it can not be read
+ */
+local_function git_repository_t *OpenGitRepository(const char *worktree)
+{
+    git_repository_t *repository = calloc(1, sizeof(git_repository_t));
+    if (repository == NULL) return NULL;
+
+    repository->levels = calloc(GIT_MAX_IGNORE_LEVELS, sizeof(git_ignore_level_t));
+    if (repository->levels == NULL) goto clean_up;
+
+    strcpy_s(repository->worktree, sizeof(repository->worktree), worktree);
+    repository->worktreeLength = strlen(worktree);
+
+    char path[MAX_PATH], text[MAX_PATH];
+    snprintf(repository->gitDir, sizeof(repository->gitDir), "%s\\.git", worktree);
+
+    if (!(GetFileAttributesA(repository->gitDir) & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        if (!ReadGitText(repository->gitDir, text, sizeof(text)) || strncmp(text, "gitdir: ", 8) != 0) goto clean_up;
+
+        BOOL absolute = text[8] == '/' || text[8] == '\\' || (text[8] != '\0' && text[9] == ':');
+        if (absolute) strcpy_s(repository->gitDir, sizeof(repository->gitDir), text + 8);
+        else snprintf(repository->gitDir, sizeof(repository->gitDir), "%s\\%s", worktree, text + 8);
+    }
+
+    strcpy_s(repository->commonDir, sizeof(repository->commonDir), repository->gitDir);
+    snprintf(path, sizeof(path), "%s\\commondir", repository->gitDir);
+
+    if (ReadGitText(path, text, sizeof(text)))
+    {
+        BOOL absolute = text[0] == '/' || text[0] == '\\' || (text[0] != '\0' && text[1] == ':');
+        if (absolute) strcpy_s(repository->commonDir, sizeof(repository->commonDir), text);
+        else snprintf(repository->commonDir, sizeof(repository->commonDir), "%s\\%s", repository->gitDir, text);
+    }
+
+    if (!ReadGitIndex(repository)) goto clean_up;
+
+    snprintf(path, sizeof(path), "%s\\info\\exclude", repository->commonDir);
+    ReadIgnoreFile(path, "", &repository->exclude);
+
+    OpenGitPacks(repository);
+    ReadGitHead(repository);
+
+    return repository;
+
+clean_up:
+    CloseGitRepository(repository);
+    return NULL;
+}
+
+/**
+ * @brief Check if a document differs from its index entry. The stat data
+ * decides when it can, the document is hashed otherwise.
+ *
+ * @param repository    pointer to the repository
+ * @param entry         index entry of the document
+ * @param asset         the document
+ * @return BOOL         TRUE if the document is modified, FALSE otherwise
+ */
+local_function BOOL IsGitModified(const git_repository_t *repository, const git_index_entry_t *entry, const asset_t *asset)
+{
+    if ((entry->flags & GIT_INDEX_ASSUME_VALID) || (entry->extended & GIT_INDEX_SKIP_WORKTREE)) return FALSE;
+    if (entry->size != (unsigned int)asset->size) return TRUE;
+
+    unsigned long long ticks = asset->timestamp.modification - UNIX_EPOCH_TICKS;
+    unsigned long long seconds = ticks / 10000000ULL;
+    unsigned long long nanoseconds = ticks % 10000000ULL * 100;
+
+    // NOTE(Andrei): The nanoseconds are only compared if git stored them.
+    //               A document written on the same second as the index
+    //               ("racily clean") can have changed without a new time.
+    BOOL sameTime = seconds == entry->mtime && (entry->mtimeNsec == 0 || nanoseconds == entry->mtimeNsec);
+    if (sameTime && seconds < repository->indexTime) return FALSE;
+
+    // NOTE(Andrei): The hash is of the content on disk, with autocrlf the
+    //               blob has other end of lines and it is reported modified.
+    unsigned char hash[GIT_HASH_SIZE];
+    if (!HashGitBlob(asset->path, hash)) return TRUE;
+
+    return memcmp(hash, entry->hash, GIT_HASH_SIZE) != 0;
+}
+
+/**
+ * @brief Status letter of the index compared with HEAD.
+ *
+ * @param repository    pointer to the repository, with the tree of the directory
+ * @param entry         index entry of the asset
+ * @param name          name of the asset
+ * @return char         ' ' if they are the same, 'A' if it is new, 'M' otherwise
+ */
+local_function char GetGitStagedStatus(const git_repository_t *repository, const git_index_entry_t *entry, const char *name)
+{
+    if (!repository->hasTree) return repository->hasHead ? ' ' : 'A';
+    if (repository->treeSize == 0) return 'A';
+
+    git_tree_entry_t key = { name, 0, NULL };
+    const git_tree_entry_t *head = bsearch(&key, repository->tree, repository->treeSize, sizeof(git_tree_entry_t), CompareGitTreeEntry);
+
+    if (head == NULL) return 'A';
+
+    return memcmp(head->hash, entry->hash, GIT_HASH_SIZE) == 0 && head->mode == entry->mode ? ' ' : 'M';
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ReadGitStatus(git_repository_t **repository, const char *directory, asset_t *assets, size_t count)
+{
+    if (count == 0) return;
+
+    char listed[MAX_PATH], fullPath[MAX_PATH], worktree[MAX_PATH];
+    GetDirectoryFromPath(directory, listed, MAX_PATH);
+
+    if (GetFullPathNameA(listed[0] ? listed : ".", MAX_PATH, fullPath, NULL) == 0) return;
+    if (!FindGitWorktree(fullPath, worktree, MAX_PATH)) return;
+
+    if (*repository == NULL || _stricmp((*repository)->worktree, worktree) != 0)
+    {
+        CloseGitRepository(*repository);
+        *repository = OpenGitRepository(worktree);
+    }
+
+    git_repository_t *repo = *repository;
+    if (repo == NULL) return;
+
+    // NOTE(Andrei): Paths relative to the worktree with '/' as git stores them.
+    char relative[MAX_PATH];
+    const char *rest = fullPath + repo->worktreeLength;
+    while (*rest == '\\' || *rest == '/') ++rest;
+
+    strcpy_s(relative, MAX_PATH, rest);
+    for (char *c = relative; *c != '\0'; ++c) if (*c == '\\') *c = '/';
+
+    size_t length = strlen(relative);
+    while (length > 0 && relative[length - 1] == '/') relative[--length] = '\0';
+
+    if (strcmp(relative, ".git") == 0 || strncmp(relative, ".git/", 5) == 0) return;
+
+    // NOTE(Andrei): The streamed rows come one by one, the ignore files
+    //               and the tree are only loaded when the directory changes.
+    if (!repo->loaded || strcmp(repo->directory, relative) != 0)
+    {
+        LoadIgnoreLevels(repo, relative);
+        LoadGitTree(repo, relative);
+
+        strcpy_s(repo->directory, MAX_PATH, relative);
+        repo->loaded = TRUE;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        asset_t *asset = &assets[i];
+        const char *name = asset->name;
+
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0 || strcmp(name, ".git") == 0) continue;
+
+        char path[MAX_PATH];
+        snprintf(path, MAX_PATH, "%s%s%s", relative, length ? "/" : "", name);
+
+        size_t index = LowerBoundGitIndex(repo, path);
+        const git_index_entry_t *entry = index < repo->numEntries && strcmp(repo->entries[index].path, path) == 0 ? &repo->entries[index] : NULL;
+
+        if (asset->type.directory && (entry == NULL || entry->mode != GIT_MODE_GITLINK))
+        {
+            // NOTE(Andrei): A directory is tracked if an entry of the index
+            //               starts with its path.
+            size_t pathLength = strlen(path);
+            path[pathLength] = '/';
+            path[pathLength + 1] = '\0';
+
+            index = LowerBoundGitIndex(repo, path);
+            BOOL tracked = index < repo->numEntries && strncmp(repo->entries[index].path, path, pathLength + 1) == 0;
+
+            path[pathLength] = '\0';
+            if (!tracked) strcpy_s(asset->gitStatus, sizeof(asset->gitStatus), IsGitIgnored(repo, path, TRUE) ? "!!" : "??");
+            else strcpy_s(asset->gitStatus, sizeof(asset->gitStatus), "  ");
+
+            continue;
+        }
+
+        if (entry == NULL)
+        {
+            strcpy_s(asset->gitStatus, sizeof(asset->gitStatus), IsGitIgnored(repo, path, FALSE) ? "!!" : "??");
+            continue;
+        }
+
+        if (GIT_INDEX_STAGE(entry->flags) != 0)
+        {
+            strcpy_s(asset->gitStatus, sizeof(asset->gitStatus), "UU");
+            continue;
+        }
+
+        if (entry->extended & GIT_INDEX_INTENT_TO_ADD)
+        {
+            strcpy_s(asset->gitStatus, sizeof(asset->gitStatus), " A");
+            continue;
+        }
+
+        asset->gitStatus[0] = GetGitStagedStatus(repo, entry, name);
+        asset->gitStatus[1] = entry->mode != GIT_MODE_GITLINK && IsGitModified(repo, entry, asset) ? 'M' : ' ';
+        asset->gitStatus[2] = '\0';
+    }
+}
+
+void CloseGitRepository(git_repository_t *repository)
+{
+    if (repository == NULL) return;
+
+    UnmapGitFile(&repository->index);
+    CHECK_DELETE(repository->entries);
+    CHECK_DELETE(repository->paths);
+
+    CHECK_DELETE(repository->exclude.text);
+    CHECK_DELETE(repository->exclude.patterns);
+
+    for (size_t i = 0; repository->levels != NULL && i < repository->numLevels; ++i)
+    {
+        CHECK_DELETE(repository->levels[i].text);
+        CHECK_DELETE(repository->levels[i].patterns);
+    }
+
+    for (size_t i = 0; i < repository->numPacks; ++i)
+    {
+        UnmapGitFile(&repository->packs[i].idx);
+        UnmapGitFile(&repository->packs[i].pack);
+    }
+
+    CHECK_DELETE(repository->levels);
+    CHECK_DELETE(repository->packs);
+    CHECK_DELETE(repository->treeData);
+    CHECK_DELETE(repository->tree);
+    CHECK_DELETE(repository);
+}
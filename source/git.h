@@ -0,0 +1,44 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Repository opened by 'ReadGitStatus': its index, its ignore rules
+ * and its object database.
+ */
+typedef struct git_repository_t git_repository_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Fill the git status of the assets of a directory with the two letters
+ * of 'git status --short' (see 'asset_t'):
+ *
+ * '??'     : untracked
+ * '!!'     : ignored (.gitignore files and .git\info\exclude)
+ * 'M '     : staged, the index differs from HEAD ('A ' if it is not on HEAD)
+ * ' M'     : modified, the document differs from the index
+ * 'UU'     : unmerged
+ *
+ * The index is read through a file mapping and its cached stat data is
+ * compared with the size and the modification time of the assets. The
+ * documents are only hashed when the stat data can not tell (same size
+ * and different time, or modified after the index was written).
+ *
+ * The repository is opened on the first call and kept while the next
+ * directories belong to it. The assets outside a repository have an
+ * empty status.
+ *
+ * @param repository    pointer to the repository of the previous call, NULL at the beginning
+ * @param directory     path of the listed directory
+ * @param assets        assets of the directory
+ * @param count         number of assets
+ */
+void ReadGitStatus(git_repository_t **repository, const char *directory, asset_t *assets, size_t count);
+
+/**
+ * @brief Release the repository and its mappings.
+ *
+ * @param repository    repository returned by 'ReadGitStatus'
+ */
+void CloseGitRepository(git_repository_t *repository);
@@ -0,0 +1,135 @@
+#include "glob.h"
+#include "types.h"
+#include "win32.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Check if the character is a path delimiter
+#define IS_DELIMITER(c)     ((c) == '\\' || (c) == '/')
+
+// Check if the character ends a pattern segment
+#define IS_SEGMENT_END(c)   ((c) == '\0' || IS_DELIMITER(c))
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Check if the pattern segment is a globstar, '**'.
+ *
+ * @param segment   pattern segment
+ * @return BOOL     TRUE if it is a globstar, FALSE otherwise
+ */
+local_function BOOL IsGlobstar(const char *segment)
+{
+    return segment[0] == '*' && segment[1] == '*' && IS_SEGMENT_END(segment[2]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BOOL HasWildcards(const char *str)
+{
+    return strpbrk(str, "*?") != NULL;
+}
+
+BOOL IsGlobPath(const char *path, BOOL recursive)
+{
+    char segment[MAX_PATH] = { 0 };
+    const char *rest = SplitPatternSegment(path, segment, sizeof(segment));
+
+    while (rest != NULL)
+    {
+        if (HasWildcards(segment))
+        {
+            return TRUE;
+        }
+
+        rest = SplitPatternSegment(rest, segment, sizeof(segment));
+    }
+
+    return IsGlobstar(segment) || (recursive && HasWildcards(segment));
+}
+
+BOOL MatchPattern(const char *pattern, const char *name)
+{
+    const char *p = pattern, *n = name;
+    const char *starPattern = NULL, *starName = NULL;
+
+    while (*n != '\0')
+    {
+        if (*p == '*')
+        {
+            // NOTE(Andrei): Remember the star position, on mismatch we
+            //               backtrack and let it consume one more char.
+            starPattern = p++;
+            starName = n;
+        }
+        else if (!IS_SEGMENT_END(*p) && (*p == '?' || tolower(*p) == tolower(*n)))
+        {
+            ++p; ++n;
+        }
+        else if (starPattern != NULL)
+        {
+            p = starPattern + 1;
+            n = ++starName;
+        }
+        else
+        {
+            return FALSE;
+        }
+    }
+
+    while (*p == '*') ++p;
+    return IS_SEGMENT_END(*p);
+}
+
+const char *SplitPatternSegment(const char *pattern, char *segment, size_t segmentSize)
+{
+    size_t length = 0;
+
+    while (!IS_SEGMENT_END(pattern[length]))
+    {
+        ++length;
+    }
+
+    snprintf(segment, segmentSize, "%.*s", (int)length, pattern);
+
+    if (pattern[length] == '\0' || pattern[length + 1] == '\0')
+    {
+        return NULL;
+    }
+
+    return &pattern[length + 1];
+}
+
+BOOL ResolveLiteralSegments(char *path, size_t pathSize, const char **pattern)
+{
+    BOOL descended = FALSE;
+    char segment[MAX_PATH] = { 0 };
+    const char *rest = SplitPatternSegment(*pattern, segment, sizeof(segment));
+
+    while (rest != NULL && !HasWildcards(segment))
+    {
+        size_t length = strlen(path);
+
+        if (segment[0] != '\0' && length > 0 && !IS_DELIMITER(path[length - 1]))
+        {
+            snprintf(path + length, pathSize - length, "\\%s", segment);
+        }
+        else
+        {
+            // NOTE(Andrei): An empty segment is a leading delimiter,
+            //               root of the drive or a network path.
+            snprintf(path + length, pathSize - length, "%s", segment[0] ? segment : "\\");
+        }
+
+        descended = TRUE;
+        *pattern = rest;
+
+        rest = SplitPatternSegment(rest, segment, sizeof(segment));
+    }
+
+    return !descended || IsValidDirectory(path);
+}
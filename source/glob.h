@@ -0,0 +1,61 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Check if the string contains any wild card character ('*' or '?').
+ *
+ * @param str       string to check
+ * @return BOOL     TRUE if it has wild cards, FALSE otherwise
+ */
+BOOL HasWildcards(const char *str);
+
+/**
+ * @brief Check if the path has to be resolved by the glob matcher instead of
+ * a simple directory listing. This happens if the path has a globstar ('**'),
+ * if a directory segment has wild cards or if the listing is recursive and
+ * the last segment has wild cards.
+ *
+ * @param path      path given by the user
+ * @param recursive is the listing recursive ('-R')
+ * @return BOOL     TRUE if it is a glob path, FALSE otherwise
+ */
+BOOL IsGlobPath(const char *path, BOOL recursive);
+
+/**
+ * @brief Match a single path segment against a pattern segment. The pattern
+ * can use '*' (zero or more characters) and '?' (exactly one character), the
+ * comparison is case insensitive. A path delimiter ends the pattern segment.
+ *
+ * @param pattern   pattern segment, ex: test_*.cpp
+ * @param name      name of the asset, ex: test_sort.cpp
+ * @return BOOL     TRUE if the name matches, FALSE otherwise
+ */
+BOOL MatchPattern(const char *pattern, const char *name);
+
+/**
+ * @brief Given a pattern, copy its first segment into a buffer and return the
+ * pointer to the remaining segments.
+ *
+ * ex: "**\include\*.h" -> "**" and "include\*.h"
+ *
+ * @param pattern       pattern to split
+ * @param segment       buffer where the first segment is stored
+ * @param segmentSize   size in bytes of the segment buffer
+ * @return const char*  pointer to the remaining pattern or NULL if it was the last segment
+ */
+const char *SplitPatternSegment(const char *pattern, char *segment, size_t segmentSize);
+
+/**
+ * @brief Descend directly into the leading literal segments of the pattern,
+ * without enumerating the directories they belong to. The last segment is
+ * never consumed, it is the one that selects the assets to list.
+ *
+ * ex: "C:\src" + "lib\*\include\*.h" -> "C:\src\lib" + "*\include\*.h"
+ *
+ * @param path      buffer with the directory path, it is extended in-place
+ * @param pathSize  size in bytes of the path buffer
+ * @param pattern   double pointer to the pattern, advanced in-place
+ * @return BOOL     FALSE if a descended directory does not exist, TRUE otherwise
+ */
+BOOL ResolveLiteralSegments(char *path, size_t pathSize, const char **pattern);
@@ -0,0 +1,194 @@
+#include "libls.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "directory.h"
+#include "format.h"
+#include "filter.h"
+#include "utils.h"
+#include "arena.h"
+
+#define LS_BATCH_SIZE 256 // maximum number of assets returned at once
+
+/**
+ * @brief Listing in progress, all its state is owned by the listing.
+ *
+ * 'arguments'  : arguments built from the options, with the directories to list
+ * 'arena'      : memory of the current batch, reset on each batch
+ * 'it'         : enumeration of the current directory
+ * 'current'    : directory being enumerated, NULL if none is open
+ */
+struct ls_listing_t
+{
+    arguments_t arguments;
+    arena_t arena;
+
+    directory_iterator_t it;
+    directory_list_t *current;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Close the directory being enumerated and remove it from the list of
+ * directories to list.
+ *
+ * @param listing   pointer to the listing
+ */
+local_function void PopListingDirectory(ls_listing_t *listing)
+{
+    arguments_t *arguments = &listing->arguments;
+    directory_list_t *dir = listing->current;
+
+    CloseDirectoryIterator(&listing->it);
+    listing->current = NULL;
+
+    arguments->headDir = dir->next;
+    if (arguments->headDir == NULL) arguments->tailDir = NULL;
+
+    CHECK_DELETE(dir);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+ls_listing_t *OpenListing(const char *path, const ls_options_t *options, char *error, size_t errorSize)
+{
+    ls_listing_t *listing = calloc(1, sizeof(ls_listing_t));
+
+    if (listing == NULL)
+    {
+        sprintf_s(error, errorSize, "Not enough memory");
+        return NULL;
+    }
+
+    arguments_t *arguments = &listing->arguments;
+
+    arguments->showAll = options->showAll || options->showAlmostAll;
+    arguments->showAlmostAll = options->showAlmostAll;
+    arguments->recursiveList = options->recursive;
+    arguments->maxDepth = options->maxDepth;
+    arguments->noDaemon = !options->useDaemon;
+
+    if (options->filter != NULL)
+    {
+        arguments->filter = CompileFilter(options->filter, error, errorSize);
+        if (arguments->filter == NULL) goto clean_up;
+    }
+
+    AddDirectoryToList(arguments, path);
+
+    if (arguments->headDir == NULL)
+    {
+        sprintf_s(error, errorSize, "Not enough memory");
+        goto clean_up;
+    }
+
+    return listing;
+
+clean_up:
+    DeleteFilter(arguments->filter);
+    CHECK_DELETE(listing);
+
+    return NULL;
+}
+
+size_t NextListingBatch(ls_listing_t *listing, const asset_t **assets, const char **directory)
+{
+    arguments_t *arguments = &listing->arguments;
+
+    // NOTE(Andrei): The assets of the previous batch are not used anymore.
+    ResetArena(&listing->arena);
+
+    asset_t *batch = PushArena(&listing->arena, sizeof(asset_t) * LS_BATCH_SIZE);
+    if (batch == NULL) return 0;
+
+    while (arguments->headDir != NULL)
+    {
+        if (listing->current == NULL)
+        {
+            listing->current = arguments->headDir;
+
+            // NOTE(Andrei): A directory that can not be listed is skipped,
+            //               the node is removed as an empty one.
+            if (!OpenDirectoryIterator(&listing->it, listing->current, arguments))
+            {
+                arguments->headDir = listing->current->next;
+                if (arguments->headDir == NULL) arguments->tailDir = NULL;
+
+                CHECK_DELETE(listing->current);
+                continue;
+            }
+        }
+
+        size_t count = 0;
+
+        while (count < LS_BATCH_SIZE && NextDirectoryAsset(&listing->it, arguments, &batch[count]))
+        {
+            if (CopyAssetToArena(&batch[count], &listing->arena)) ++count;
+        }
+
+        *directory = PushArenaString(&listing->arena, listing->current->path);
+        *assets = batch;
+
+        if (count < LS_BATCH_SIZE)
+        {
+            PopListingDirectory(listing);
+        }
+
+        if (count > 0)
+        {
+            return count;
+        }
+    }
+
+    return 0;
+}
+
+void CloseListing(ls_listing_t *listing)
+{
+    if (listing == NULL) return;
+
+    if (listing->current != NULL)
+    {
+        PopListingDirectory(listing);
+    }
+
+    while (listing->arguments.headDir != NULL)
+    {
+        directory_list_t *dir = listing->arguments.headDir;
+        listing->arguments.headDir = dir->next;
+
+        CHECK_DELETE(dir);
+    }
+
+    DeleteFilter(listing->arguments.filter);
+    DeleteArena(&listing->arena);
+
+    CHECK_DELETE(listing);
+}
+
+size_t RenderListingRow(const asset_t *asset, const ls_render_t *render, char *buffer, size_t size)
+{
+    if (size == 0) return 0;
+
+    char permissions[4], sizeText[SIZE_TEXT_SIZE], date[DATE_SIZE];
+
+    FormatPermissions(&asset->accessRights, permissions, sizeof(permissions));
+    FormatSize(asset->size, render->sizeFormat, sizeText, SIZE_TEXT_SIZE);
+    FormatDateTimeContext(&render->dates, GetDisplayTimestamp(asset, render->sortField), date, DATE_SIZE);
+
+    int domainWidth = (int)render->domainWidth;
+    int ownerWidth = (int)render->ownerWidth;
+
+    int length = snprintf(buffer, size, "%c%s%s  %*.*s  %*.*s  %s  %s",
+        FormatAssetType(asset), permissions, sizeText,
+        domainWidth, domainWidth, asset->domain,
+        ownerWidth, ownerWidth, asset->owner,
+        date, asset->name);
+
+    if (length < 0) return 0;
+    return (size_t)length < size ? (size_t)length : size - 1;
+}
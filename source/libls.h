@@ -0,0 +1,108 @@
+#pragma once
+
+#include "types.h"
+#include "datetime.h"
+
+#define LS_UNLIMITED_DEPTH ((size_t)-1)    // 'maxDepth' of a recursion without limit
+
+/**
+ * Embeddable listing engine. A listing enumerates a directory (and its
+ * sub-directories when it is recursive) and returns the assets in batches,
+ * each listing owns its arguments, directory list and memory so several
+ * listings can run at once, one per thread. The rows are rendered as text
+ * into the buffers of the caller, without colors nor console state.
+ *
+ * The owner names are cached for the whole process (the cache is locked).
+ * The statistics are only collected when the command line enables them.
+ */
+
+/**
+ * @brief Options of a listing.
+ *
+ * 'showAll'        : list all the assets, hidden, '.' and '..' included
+ * 'showAlmostAll'  : list the hidden assets but not '.' and '..'
+ * 'recursive'      : list the sub-directories
+ * 'maxDepth'       : maximum depth of the recursion (root is 0), as '--max-depth',
+ *                    'LS_UNLIMITED_DEPTH' for no limit
+ * 'filter'         : filter expression (see '--where'), NULL lists all
+ * 'useDaemon'      : ask the daemon for the directories (see 'daemon.h')
+ */
+typedef struct ls_options_t
+{
+    BOOL showAll, showAlmostAll;
+
+    BOOL recursive;
+    size_t maxDepth;
+
+    const char *filter;
+    BOOL useDaemon;
+} ls_options_t;
+
+/**
+ * @brief Options of the rendered rows, see 'RenderListingRow'.
+ *
+ * 'sizeFormat'     : see 'size_format_e'
+ * 'sortField'      : the timestamp shown is the sorted one (creation by default)
+ * 'dates'          : calendar context of the dates, see 'CreateDateContext'
+ * 'ownerWidth'     : width of the owner column
+ * 'domainWidth'    : width of the domain column
+ */
+typedef struct ls_render_t
+{
+    size_format_e sizeFormat;
+    sort_by_e sortField;
+    date_context_t dates;
+
+    size_t ownerWidth, domainWidth;
+} ls_render_t;
+
+/**
+ * @brief Listing in progress, see 'OpenListing'.
+ */
+typedef struct ls_listing_t ls_listing_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Start a listing. The path can be a directory, a document or a path
+ * with wild cards on the last segment (ex: C:\Windows\*.exe).
+ *
+ * @param path              path to list
+ * @param options           options of the listing
+ * @param error             buffer where the error is written
+ * @param errorSize         size of the error buffer
+ * @return ls_listing_t*    the listing or NULL if the filter is not valid or there is not enough memory
+ */
+ls_listing_t *OpenListing(const char *path, const ls_options_t *options, char *error, size_t errorSize);
+
+/**
+ * @brief Get the next assets of the listing, all of them belong to the same
+ * directory. The assets and the directory are valid until the next call.
+ *
+ * @param listing       pointer to the listing
+ * @param assets        pointer where the assets are stored
+ * @param directory     pointer where the path of their directory is stored
+ * @return size_t       number of assets, 0 at the end of the listing
+ */
+size_t NextListingBatch(ls_listing_t *listing, const asset_t **assets, const char **directory);
+
+/**
+ * @brief End a listing and release its memory.
+ *
+ * @param listing       pointer to the listing
+ */
+void CloseListing(ls_listing_t *listing);
+
+/**
+ * @brief Write an asset as a row of the long format, without colors nor the
+ * end of line.
+ *
+ * ex: -rw-     1.50K  DESKTOP-01  Andrei  01 Jan 10:00  notes.txt
+ *
+ * @param asset         pointer to the asset
+ * @param render        options of the row
+ * @param buffer        buffer where the row is written
+ * @param size          size of the buffer
+ * @return size_t       number of characters written
+ */
+size_t RenderListingRow(const asset_t *asset, const ls_render_t *render, char *buffer, size_t size);
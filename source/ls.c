@@ -14,6 +14,18 @@
 
 #include "utils.h"
 #include "sort.h"
+#include "glob.h"
+#include "filter.h"
+#include "visited.h"
+#include "stats.h"
+#include "arena.h"
+#include "datetime.h"
+#include "daemon.h"
+#include "content.h"
+#include "duplicates.h"
+#include "git.h"
+#include "count.h"
+#include "tree.h"
 
 #include "screen.h"
 
@@ -23,6 +35,91 @@ global_variable const char VERSION[] = "0.0.1 "__DATE__" "__TIME__;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief Root listed by a worker of 'ListRootsConcurrently'.
+ *
+ * 'dir'        : root to list
+ * 'directory'  : assets of the root already sorted, NULL if it can not be listed
+ * 'arena'      : arena of the assets, released once the root is printed
+ * 'done'       : event signaled when the root is listed
+ */
+typedef struct root_slot_t
+{
+    directory_list_t *dir;
+    directory_t *directory;
+
+    arena_t arena;
+    HANDLE done;
+} root_slot_t;
+
+/**
+ * @brief Roots shared by the workers, see 'ListRootsConcurrently'.
+ *
+ * 'slots'      : one slot per root in the order of the arguments (reorder buffer)
+ * 'count'      : number of roots
+ * 'next'       : index of the next root to list
+ * 'window'     : semaphore with the free places of the window, a root is listed
+ *                at most 'ROOT_WINDOW_SIZE' roots ahead of the printed one
+ * 'arguments'  : parsed arguments, they are only read
+ */
+typedef struct root_queue_t
+{
+    root_slot_t *slots;
+    size_t count;
+
+    volatile LONG next;
+    HANDLE window;
+
+    arguments_t *arguments;
+} root_queue_t;
+
+/**
+ * @brief Directory handed over by the stages of 'ListTreePipelined'.
+ *
+ * 'dir'        : directory that was listed
+ * 'directory'  : assets of the directory already sorted, NULL if it can not be listed
+ * 'arena'      : arena of the assets, its blocks are reused by the next batches of the slot
+ * 'repeated'   : the directory was already listed following links, it is not enumerated
+ */
+typedef struct pipeline_batch_t
+{
+    directory_list_t *dir;
+    directory_t *directory;
+
+    arena_t arena;
+    BOOL repeated;
+} pipeline_batch_t;
+
+/**
+ * @brief Ring between the enumeration stage (producer) and the render stage
+ * (consumer) of 'ListTreePipelined'.
+ *
+ * 'batches'    : slots of the ring
+ * 'head'       : number of rendered batches, only written by the render stage
+ * 'tail'       : number of enumerated batches, only written by the enumeration stage
+ * 'done'       : the enumeration stage has no more directories
+ *
+ * 'filled'     : event signaled when a batch is added
+ * 'freed'      : event signaled when a batch is rendered
+ *
+ * 'arguments'  : parsed arguments, the list of directories belongs to the enumeration stage
+ * 'visited'    : directories already listed following links
+ */
+typedef struct pipeline_ring_t
+{
+    pipeline_batch_t batches[PIPELINE_RING_SIZE];
+
+    volatile LONG head, tail;
+    volatile LONG done;
+
+    HANDLE filled, freed;
+
+    arguments_t *arguments;
+    visited_set_t *visited;
+} pipeline_ring_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
 /**
  * @brief Parse short arguments
  * ex: -l, -a, -laR, ...
@@ -39,10 +136,13 @@ local_function void ParseShortArgument(const char *arg, arguments_t *arguments)
             case 'A': arguments->showAlmostAll = arguments->showAll = TRUE; break;
             case 'l': arguments->showLongFormat = TRUE; break;
             case 'R': arguments->recursiveList = TRUE; break;
+            case 'T': arguments->showTree = TRUE; break;
             case 'r': arguments->reverseOrder = TRUE; break;
             case 'v': arguments->showVersion = TRUE; break;
             case '?': arguments->showHelp = TRUE; break;
             case 'a': arguments->showAll = TRUE; break;
+            case 'x': arguments->oneFileSystem = TRUE; break;
+            case 'L': arguments->followLinks = TRUE; break;
         }
     }
 }
@@ -70,6 +170,10 @@ local_function const char **ParseLongArgument(const char **arg, arguments_t *arg
     {
         arguments->recursiveList = TRUE;
     }
+    else if (strcmp(*arg, "--tree") == 0)
+    {
+        arguments->showTree = TRUE;
+    }
     else if (strcmp(*arg, "--version") == 0)
     {
         arguments->showVersion = TRUE;
@@ -107,6 +211,143 @@ local_function const char **ParseLongArgument(const char **arg, arguments_t *arg
         arguments->showIcons = TRUE;
         arguments->showMetaData = TRUE;
     }
+    else if (strcmp(*arg, "--stats") == 0)
+    {
+        arguments->showStats = TRUE;
+    }
+    else if (strcmp(*arg, "--perf-counters") == 0)
+    {
+        arguments->perfCounters = TRUE;
+    }
+    else if (strcmp(*arg, "--trace") == 0)
+    {
+        ++arg;
+
+        if (*arg == NULL)
+        {
+            printf_s("Invalid trace argument, a file name is expected");
+            exit(1);
+        }
+
+        arguments->traceFile = *arg;
+    }
+    else if (strcmp(*arg, "--dereference") == 0)
+    {
+        arguments->followLinks = TRUE;
+    }
+    else if (strcmp(*arg, "--one-file-system") == 0)
+    {
+        arguments->oneFileSystem = TRUE;
+    }
+    else if (strcmp(*arg, "--max-depth") == 0)
+    {
+        ++arg;
+        char *end = NULL;
+        arguments->maxDepth = *arg ? strtoul(*arg, &end, 10) : 0;
+
+        if (*arg == NULL || end == *arg || *end != '\0')
+        {
+            printf_s("Invalid max depth argument: %s\n", *arg ? *arg : "");
+            printf_s("Valid values are positive numbers, 0 only lists the directory itself");
+            exit(1);
+        }
+
+        arguments->recursiveList = TRUE;
+    }
+    else if (strcmp(*arg, "--depth-first") == 0)
+    {
+        arguments->depthFirst = TRUE;
+        arguments->recursiveList = TRUE;
+    }
+    else if (strcmp(*arg, "--prune") == 0)
+    {
+        ++arg;
+
+        if (*arg == NULL || arguments->numPrune >= MAX_PRUNE_PATTERNS)
+        {
+            printf_s("Invalid prune argument, a maximum of %d names can be pruned", MAX_PRUNE_PATTERNS);
+            exit(1);
+        }
+
+        arguments->prune[arguments->numPrune++] = *arg;
+    }
+    else if (strcmp(*arg, "--where") == 0)
+    {
+        ++arg;
+        char error[256] = { 0 };
+
+        DeleteFilter(arguments->filter);
+        arguments->filter = CompileFilter(*arg ? *arg : "", error, sizeof(error));
+
+        if (arguments->filter == NULL)
+        {
+            printf_s("Invalid filter expression: %s\n", error);
+            printf_s("Valid fields are: name, ext, type, hidden, size, ctime, atime, mtime, owner, group, perms");
+            exit(1);
+        }
+    }
+    else if (strcmp(*arg, "--daemon") == 0)
+    {
+        arguments->runDaemon = TRUE;
+    }
+    else if (strcmp(*arg, "--no-daemon") == 0)
+    {
+        arguments->noDaemon = TRUE;
+    }
+    else if (strcmp(*arg, "--checksum") == 0)
+    {
+        arguments->showChecksum = TRUE;
+    }
+    else if (strcmp(*arg, "--lines") == 0)
+    {
+        arguments->showLines = TRUE;
+    }
+    else if (strcmp(*arg, "--mime") == 0)
+    {
+        arguments->showMime = TRUE;
+    }
+    else if (strcmp(*arg, "--git") == 0)
+    {
+        arguments->showGit = TRUE;
+    }
+    else if (strcmp(*arg, "--duplicates") == 0)
+    {
+        arguments->findDuplicates = TRUE;
+        arguments->recursiveList = TRUE;
+    }
+    else if (strcmp(*arg, "--count") == 0)
+    {
+        arguments->countOnly = TRUE;
+    }
+    else if (strcmp(*arg, "--by-dir") == 0)
+    {
+        arguments->countOnly = TRUE;
+        arguments->countByDir = TRUE;
+    }
+    else if (strcmp(*arg, "--stream") == 0)
+    {
+        arguments->streamLongFormat = TRUE;
+    }
+    else if (strcmp(*arg, "--si") == 0)
+    {
+        arguments->sizeFormat = SIZE_FORMAT_SI;
+    }
+    else if (strcmp(*arg, "--bytes") == 0)
+    {
+        arguments->sizeFormat = SIZE_FORMAT_BYTES;
+    }
+    else if (strcmp(*arg, "--time-style") == 0)
+    {
+        ++arg;
+
+        if (*arg == NULL)
+        {
+            printf_s("Invalid time style argument, a style is expected");
+            exit(1);
+        }
+
+        arguments->timeStyle = *arg;
+    }
     else if (strcmp(*arg, "--sort") == 0)
     {
         ++arg;
@@ -149,6 +390,64 @@ local_function const char **ParseLongArgument(const char **arg, arguments_t *arg
     return arg;
 }
 
+/**
+ * @brief Convert the paths that need the glob matcher into a directory and
+ * a pattern relative to it. The leading literal segments are descended
+ * directly, if the listing is recursive and the pattern has no globstar
+ * it is applied to all the sub-directories.
+ * ex: -R C:\src\*.dll -> "C:\src" and "**\*.dll"
+ *
+ * @param arguments     pointer to arguments data structure with the directories
+ */
+local_function void ResolveGlobArguments(arguments_t *arguments)
+{
+    // NOTE(Andrei): The nodes have the exact size of their path,
+    //               the list is built again with the resolved ones.
+    directory_list_t *dir = arguments->headDir;
+    arguments->headDir = arguments->tailDir = NULL;
+
+    while (dir != NULL)
+    {
+        directory_list_t *next = dir->next;
+
+        if (!IsGlobPath(dir->path, arguments->recursiveList))
+        {
+            AddPatternToList(arguments, NULL, dir->path, dir->pattern);
+            goto next_dir;
+        }
+
+        char path[MAX_PATH] = { 0 };
+        char pattern[MAX_PATH] = { 0 };
+        const char *rest = dir->path;
+
+        ResolveLiteralSegments(path, MAX_PATH, &rest);
+
+        if (path[0] == '\0')
+        {
+            GetWorkingDirectory(path, MAX_PATH);
+        }
+
+        if (arguments->recursiveList && strstr(rest, "**") == NULL)
+        {
+            const char *c = FindLastDelimiter(rest, "\\/");
+            int length = c ? (int)(c - rest) : 0;
+
+            if (c == NULL) sprintf_s(pattern, MAX_PATH, "**\\%s", rest);
+            else sprintf_s(pattern, MAX_PATH, "%.*s\\**\\%s", length, rest, c + 1);
+        }
+        else
+        {
+            strcpy_s(pattern, MAX_PATH, rest);
+        }
+
+        AddPatternToList(arguments, NULL, path, pattern);
+
+    next_dir:
+        CHECK_DELETE(dir);
+        dir = next;
+    }
+}
+
 /**
  * @brief Parse program arguments.
  * ex: -l, -a, -la, --color, ...
@@ -166,6 +465,8 @@ local_function arguments_t ParseArguments(int argc, const char **argv)
     const char **currentArg = argv + 1;
     const char **lastArg = argv + argc;
 
+    retData.maxDepth = (size_t)-1;
+
     while (currentArg < lastArg)
     {
         if ((*currentArg)[0] == '-' && (*currentArg)[1] == '-')
@@ -184,9 +485,497 @@ local_function arguments_t ParseArguments(int argc, const char **argv)
         ++currentArg;
     }
 
+    ResolveGlobArguments(&retData);
     return retData;
 }
 
+/**
+ * @brief List a directory with the long format printing the rows as they are
+ * found, they are not sorted. The widths of the domain and owner columns are
+ * taken from the first assets (see 'STREAM_WINDOW_SIZE') and from the names
+ * already in the owner cache, the rest of the rows use the same widths.
+ *
+ * @param dir           directory to list
+ * @param arguments     pointer to the parsed arguments structure
+ * @param arena         arena where the first assets are stored
+ * @param repository    pointer to the git repository of the previous directory, see 'ReadGitStatus'
+ * @param assets        pointer where the number of listed assets is stored
+ * @return BOOL         TRUE if the directory can be listed, FALSE otherwise
+ */
+local_function BOOL StreamLongFormat(directory_list_t *dir, arguments_t *arguments, arena_t *arena, git_repository_t **repository, size_t *assets)
+{
+    directory_iterator_t it;
+    stats_timer_t timer = StartStatsTimer();
+
+    size_t count = 0;
+    *assets = 0;
+
+    if (!OpenDirectoryIterator(&it, dir, arguments))
+    {
+        return FALSE;
+    }
+
+    asset_t *window = PushArena(arena, sizeof(asset_t) * STREAM_WINDOW_SIZE);
+
+    if (window == NULL)
+    {
+        CloseDirectoryIterator(&it);
+        return FALSE;
+    }
+
+    while (count < STREAM_WINDOW_SIZE && NextDirectoryAsset(&it, arguments, &window[count]))
+    {
+        if (CopyAssetToArena(&window[count], arena)) ++count;
+    }
+
+    StopStatsPhase(STATS_PHASE_ENUMERATE, timer);
+
+    if (count == 0)
+    {
+        CloseDirectoryIterator(&it);
+        return TRUE;
+    }
+
+    if (HasContentColumns(arguments))
+    {
+        timer = StartStatsTimer();
+        ReadAssetsContent(window, count, arguments);
+        StopStatsPhase(STATS_PHASE_CONTENT, timer);
+    }
+
+    if (arguments->showGit)
+    {
+        timer = StartStatsTimer();
+        ReadGitStatus(repository, dir->path, window, count);
+        StopStatsPhase(STATS_PHASE_CONTENT, timer);
+    }
+
+    timer = StartStatsTimer();
+
+    size_t ownerWidth = 0, domainWidth = 0;
+    GetOwnerCacheWidths(&ownerWidth, &domainWidth);
+
+    long_format_t layout = GetLongFormatLayout(window, count, dir->path);
+    layout.ownerLength = layout.ownerLength < ownerWidth ? ownerWidth : layout.ownerLength;
+    layout.domainLength = layout.domainLength < domainWidth ? domainWidth : layout.domainLength;
+
+    StopStatsPhase(STATS_PHASE_LAYOUT, timer);
+    timer = StartStatsTimer();
+
+    if (dir->next) printf_s("%s\n", dir->path);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i > 0) putchar('\n');
+        PrintAssetLongRow(&window[i], &layout, arguments);
+    }
+
+    StopStatsPhase(STATS_PHASE_RENDER, timer);
+    timer = StartStatsTimer();
+
+    // NOTE(Andrei): The rest of the rows are printed while enumerating,
+    //               the time is reported as part of the enumeration. Their
+    //               content is read on this thread, one by one.
+    asset_t asset;
+    BOOL readContent = HasContentColumns(arguments);
+
+    while (NextDirectoryAsset(&it, arguments, &asset))
+    {
+        if (readContent) ReadAssetContent(&asset, arguments);
+        if (arguments->showGit) ReadGitStatus(repository, dir->path, &asset, 1);
+        putchar('\n');
+        PrintAssetLongRow(&asset, &layout, arguments);
+        ++count;
+    }
+
+    CloseDirectoryIterator(&it);
+    StopStatsPhase(STATS_PHASE_ENUMERATE, timer);
+
+    *assets = count;
+    return TRUE;
+}
+
+/**
+ * @brief Print the sorted assets of a directory, the path is printed before
+ * them if more directories are listed after it.
+ *
+ * @param dir           directory that was listed
+ * @param directory     assets of the directory
+ * @param arguments     pointer to the parsed arguments structure
+ */
+local_function void PrintDirectory(const directory_list_t *dir, const directory_t *directory, const arguments_t *arguments)
+{
+    if (dir->next) printf_s("%s\n", dir->path);
+
+    if (arguments->showLongFormat)
+    {
+        PrintAssetLongFormat(directory, dir->path, arguments);
+    }
+    else
+    {
+        PrintAssetShortFormat(directory, arguments);
+    }
+
+    if (dir->next != NULL) printf_s("\n\n");
+}
+
+/**
+ * @brief List a directory away from the main loop: enumerate it, read the
+ * content columns and sort it. Nothing is printed, see 'ListRootsConcurrently'
+ * and 'ListTreePipelined'.
+ *
+ * @param dir               directory to list
+ * @param arguments         pointer to the parsed arguments structure
+ * @param arena             arena where the assets are allocated
+ * @return directory_t*     assets of the directory sorted or NULL otherwise
+ */
+local_function directory_t *ListDirectory(directory_list_t *dir, arguments_t *arguments, arena_t *arena)
+{
+    directory_t *directory = GetDirectoryContent(dir, arguments, arena);
+
+    if (directory == NULL || directory->size == 0)
+    {
+        return directory;
+    }
+
+    if (arguments->showLongFormat && HasContentColumns(arguments))
+    {
+        ReadAssetsContent(directory->data, directory->size, arguments);
+    }
+
+    SortDirectoryContent(directory, arguments);
+    return directory;
+}
+
+/**
+ * @brief Thread listing roots, it takes them in order until all of them are
+ * taken. A place of the window is taken before each root.
+ *
+ * @param parameter     pointer to the queue of roots
+ * @return DWORD        always 0
+ */
+local_function DWORD WINAPI RootWorker(LPVOID parameter)
+{
+    root_queue_t *queue = parameter;
+
+    for (;;)
+    {
+        WaitForSingleObject(queue->window, INFINITE);
+        size_t i = (size_t)(InterlockedIncrement(&queue->next) - 1);
+
+        if (i >= queue->count)
+        {
+            // NOTE(Andrei): Give the place back, the rest of the
+            //               workers are waiting for it to end too.
+            ReleaseSemaphore(queue->window, 1, NULL);
+            return 0;
+        }
+
+        root_slot_t *slot = &queue->slots[i];
+        slot->directory = ListDirectory(slot->dir, queue->arguments, &slot->arena);
+        SetEvent(slot->done);
+    }
+}
+
+/**
+ * @brief Check if the listing has to run on the main loop, directory after
+ * directory: the modes with their own walk (count, tree, stream, duplicates)
+ * and the statistics, they are measured per directory.
+ *
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if it is listed by the main loop, FALSE otherwise
+ */
+local_function BOOL IsListedByMainLoop(const arguments_t *arguments)
+{
+    if (arguments->countOnly || arguments->showTree || arguments->findDuplicates) return TRUE;
+    if (arguments->streamLongFormat && arguments->showLongFormat) return TRUE;
+    if (arguments->showStats || arguments->traceFile != NULL || arguments->perfCounters) return TRUE;
+
+    return FALSE;
+}
+
+/**
+ * @brief Check if the roots can be listed at the same time. The listings
+ * that add directories to the list while enumerating (recursive, glob
+ * patterns, links) can not, see 'ListTreePipelined'.
+ *
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if they can be listed concurrently, FALSE otherwise
+ */
+local_function BOOL CanListRootsConcurrently(const arguments_t *arguments)
+{
+    if (arguments->headDir == NULL || arguments->headDir->next == NULL) return FALSE;
+    if (arguments->recursiveList || arguments->followLinks || IsListedByMainLoop(arguments)) return FALSE;
+
+    for (const directory_list_t *dir = arguments->headDir; dir != NULL; dir = dir->next)
+    {
+        if (dir->pattern[0] != '\0') return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief List all the roots at the same time and print them in the order of
+ * the arguments. Each root is enumerated, probed and sorted by a worker on
+ * its own arena, the calling thread prints a root as soon as it and all the
+ * roots before it are done, a slow root only delays the ones after it.
+ *
+ * The workers stay at most 'ROOT_WINDOW_SIZE' roots ahead of the printed
+ * one, the memory of the listed roots waiting to be printed is bounded.
+ * The roots are removed from the list once they are printed.
+ *
+ * The daemon is not asked, its single pipe would serve the workers one by
+ * one and make each of them wait for the others.
+ *
+ * @param arguments     pointer to the parsed arguments structure
+ * @param repository    pointer to the git repository of the previous root, see 'ReadGitStatus'
+ * @return BOOL         TRUE if the roots were listed, FALSE if the workers can not be started
+ */
+local_function BOOL ListRootsConcurrently(arguments_t *arguments, git_repository_t **repository)
+{
+    HANDLE threads[MAX_ROOT_THREADS] = { 0 };
+    DWORD numThreads = 0;
+
+    root_queue_t queue = { 0 };
+    directory_list_t *dir = NULL;
+    BOOL retValue = FALSE;
+
+    for (dir = arguments->headDir; dir != NULL; dir = dir->next)
+    {
+        ++queue.count;
+    }
+
+    DWORD maxThreads = queue.count < MAX_ROOT_THREADS ? (DWORD)queue.count : MAX_ROOT_THREADS;
+
+    BOOL noDaemon = arguments->noDaemon;
+    arguments->noDaemon = TRUE;
+
+    queue.arguments = arguments;
+    queue.slots = calloc(queue.count, sizeof(root_slot_t));
+    queue.window = CreateSemaphoreA(NULL, ROOT_WINDOW_SIZE, ROOT_WINDOW_SIZE, NULL);
+
+    if (queue.slots == NULL || queue.window == NULL) goto clean_up;
+
+    dir = arguments->headDir;
+
+    for (size_t i = 0; i < queue.count; ++i, dir = dir->next)
+    {
+        queue.slots[i].dir = dir;
+        queue.slots[i].done = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+        if (queue.slots[i].done == NULL) goto clean_up;
+    }
+
+    // NOTE(Andrei): The roots are mostly waiting on the disks or the network,
+    //               there is a thread per root and not per processor.
+    for (DWORD i = 0; i < maxThreads; ++i)
+    {
+        threads[numThreads] = CreateThread(NULL, 0, RootWorker, &queue, 0, NULL);
+        if (threads[numThreads] != NULL) ++numThreads;
+    }
+
+    if (numThreads == 0) goto clean_up;
+
+    for (size_t i = 0; i < queue.count; ++i)
+    {
+        root_slot_t *slot = &queue.slots[i];
+        WaitForSingleObject(slot->done, INFINITE);
+
+        if (slot->directory == NULL)
+        {
+            printf_s("\"%s\": No such file or directory\n", slot->dir->path);
+        }
+        else if (slot->directory->size > 0)
+        {
+            if (arguments->showLongFormat && arguments->showGit)
+            {
+                ReadGitStatus(repository, slot->dir->path, slot->directory->data, slot->directory->size);
+            }
+
+            PrintDirectory(slot->dir, slot->directory, arguments);
+        }
+
+        DeleteArena(&slot->arena);
+        ReleaseSemaphore(queue.window, 1, NULL);
+    }
+
+    WaitForMultipleObjects(numThreads, threads, TRUE, INFINITE);
+    retValue = TRUE;
+
+    clean_up:
+    for (DWORD i = 0; i < numThreads; ++i)
+    {
+        CloseHandle(threads[i]);
+    }
+
+    for (size_t i = 0; queue.slots != NULL && i < queue.count; ++i)
+    {
+        if (queue.slots[i].done != NULL) CloseHandle(queue.slots[i].done);
+        if (retValue) CHECK_DELETE(queue.slots[i].dir);
+    }
+
+    if (retValue)
+    {
+        arguments->headDir = arguments->tailDir = NULL;
+    }
+
+    if (queue.window != NULL) CloseHandle(queue.window);
+    CHECK_DELETE(queue.slots);
+
+    arguments->noDaemon = noDaemon;
+
+    return retValue;
+}
+
+/**
+ * @brief Enumeration stage of the pipeline, it lists the directories in the
+ * same order as the main loop and adds them to the ring. It owns the list of
+ * directories, the nodes are released by the render stage.
+ *
+ * @param parameter     pointer to the ring
+ * @return DWORD        always 0
+ */
+local_function DWORD WINAPI EnumerationStage(LPVOID parameter)
+{
+    pipeline_ring_t *ring = parameter;
+    arguments_t *arguments = ring->arguments;
+
+    while (arguments->headDir != NULL)
+    {
+        directory_list_t *dir = arguments->headDir;
+
+        while (ring->tail - ring->head == PIPELINE_RING_SIZE)
+        {
+            WaitForSingleObject(ring->freed, INFINITE);
+        }
+
+        pipeline_batch_t *batch = &ring->batches[ring->tail % PIPELINE_RING_SIZE];
+        file_identity_t identity = { 0 };
+
+        batch->dir = dir;
+        batch->directory = NULL;
+        batch->repeated = arguments->followLinks && GetFileIdentity(dir->path, &identity) && !InsertVisitedDirectory(ring->visited, identity);
+
+        if (!batch->repeated)
+        {
+            arguments->insertDir = arguments->depthFirst ? dir : NULL;
+            batch->directory = ListDirectory(dir, arguments, &batch->arena);
+        }
+
+        // NOTE(Andrei): The sub-directories are already on the list, the
+        //               next node is read before the batch is handed over.
+        arguments->headDir = dir->next;
+
+        InterlockedIncrement(&ring->tail);
+        SetEvent(ring->filled);
+    }
+
+    InterlockedExchange(&ring->done, TRUE);
+    SetEvent(ring->filled);
+
+    return 0;
+}
+
+/**
+ * @brief List the directories of a recursive listing as a pipeline of two
+ * stages: a thread enumerates, probes and sorts the directories and the
+ * calling thread renders them, so the disk and the console are used at the
+ * same time. The output is the same as the main loop.
+ *
+ * The directories are handed over by a ring of 'PIPELINE_RING_SIZE' batches
+ * with one producer and one consumer, each index is only written by its
+ * own stage and a stage only waits when the ring is full or empty. Each
+ * batch has its own arena, the blocks are reused by the next directories.
+ *
+ * Without colors the output is fully buffered ('PIPELINE_OUTPUT_SIZE', set
+ * by main before the first output), it is written while the next directories
+ * are enumerated and flushed when the render stage has to wait for them.
+ *
+ * @param arguments     pointer to the parsed arguments structure
+ * @param visited       directories already listed following links
+ * @param repository    pointer to the git repository of the previous directory, see 'ReadGitStatus'
+ * @return BOOL         TRUE if the directories were listed, FALSE if the enumeration stage can not be started
+ */
+local_function BOOL ListTreePipelined(arguments_t *arguments, visited_set_t *visited, git_repository_t **repository)
+{
+    pipeline_ring_t ring = { 0 };
+    HANDLE thread = NULL;
+    BOOL retValue = FALSE;
+
+    ring.arguments = arguments;
+    ring.visited = visited;
+    ring.filled = CreateEventA(NULL, FALSE, FALSE, NULL);
+    ring.freed = CreateEventA(NULL, FALSE, FALSE, NULL);
+
+    if (ring.filled == NULL || ring.freed == NULL) goto clean_up;
+
+    thread = CreateThread(NULL, 0, EnumerationStage, &ring, 0, NULL);
+    if (thread == NULL) goto clean_up;
+
+    for (;;)
+    {
+        // NOTE(Andrei): Once the stage is done the tail does not move,
+        //               it is read after the flag.
+        LONG done = ring.done;
+        MemoryBarrier();
+
+        if (ring.head == ring.tail)
+        {
+            if (done) break;
+
+            fflush(stdout);
+            WaitForSingleObject(ring.filled, INFINITE);
+            continue;
+        }
+
+        MemoryBarrier();
+        pipeline_batch_t *batch = &ring.batches[ring.head % PIPELINE_RING_SIZE];
+
+        if (batch->repeated)
+        {
+            printf_s("\"%s\": not listing already-listed directory\n", batch->dir->path);
+        }
+        else if (batch->directory == NULL)
+        {
+            printf_s("\"%s\": No such file or directory\n", batch->dir->path);
+        }
+        else if (batch->directory->size > 0)
+        {
+            if (arguments->showLongFormat && arguments->showGit)
+            {
+                ReadGitStatus(repository, batch->dir->path, batch->directory->data, batch->directory->size);
+            }
+
+            PrintDirectory(batch->dir, batch->directory, arguments);
+        }
+
+        ResetArena(&batch->arena);
+        CHECK_DELETE(batch->dir);
+
+        InterlockedIncrement(&ring.head);
+        SetEvent(ring.freed);
+    }
+
+    WaitForSingleObject(thread, INFINITE);
+    fflush(stdout);
+
+    arguments->headDir = arguments->tailDir = NULL;
+    retValue = TRUE;
+
+    clean_up:
+    if (thread != NULL) CloseHandle(thread);
+    if (ring.filled != NULL) CloseHandle(ring.filled);
+    if (ring.freed != NULL) CloseHandle(ring.freed);
+
+    for (size_t i = 0; i < PIPELINE_RING_SIZE; ++i)
+    {
+        DeleteArena(&ring.batches[i].arena);
+    }
+
+    return retValue;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 int main(int argc, char *argv[])
@@ -200,7 +989,15 @@ int main(int argc, char *argv[])
 
     arguments_t arguments = ParseArguments(argc, (const char **)argv);
 
-    if (arguments.showIcons && !SetConsoleOutputCP(65001))
+    // NOTE(Andrei): The buffering of a stream can only be changed before
+    //               its first output, it is set here for the whole run
+    //               when the tree is listed by 'ListTreePipelined'.
+    if (arguments.recursiveList && !arguments.colors && !IsListedByMainLoop(&arguments))
+    {
+        setvbuf(stdout, NULL, _IOFBF, PIPELINE_OUTPUT_SIZE);
+    }
+
+    if ((arguments.showIcons || arguments.showTree) && !SetConsoleOutputCP(65001))
     {
         printf_s("WARNING:\n");
         printf_s("Can not set console to UNICODE-UTF8. Some characters may not display correctly.\n\n");
@@ -230,15 +1027,170 @@ int main(int argc, char *argv[])
         return EXIT_SUCCESS;
     }
 
+    if (arguments.runDaemon)
+    {
+        return RunDaemon();
+    }
+
+    if (!InitializeDateTime(arguments.timeStyle))
+    {
+        printf_s("Invalid time style argument: %s\n", arguments.timeStyle);
+        printf_s("Valid values are: iso, long-iso, full or +FORMAT");
+        exit(1);
+    }
+
+    if (arguments.showStats)
+    {
+        EnableStats();
+    }
+
+    if (arguments.perfCounters && !EnablePerfCounters())
+    {
+        printf_s("WARNING:\n");
+        printf_s("Can not read the thread cycles, only the page faults will be measured.\n\n");
+    }
+
+    if (arguments.traceFile != NULL && !OpenStatsTrace(arguments.traceFile))
+    {
+        char error[256] = { 0 };
+        GetLastErrorAsString(error, sizeof(error));
+
+        printf_s("WARNING:\n");
+        printf_s("Can not create the trace file \"%s\". %s\n\n", arguments.traceFile, error);
+    }
+
     if (arguments.headDir == NULL)
     {
-        AddDirectoryToList(&arguments, GetWorkingDirectory());
+        char workingDir[MAX_PATH] = { 0 };
+        AddDirectoryToList(&arguments, GetWorkingDirectory(workingDir, MAX_PATH));
+    }
+
+    // NOTE(Andrei): The count only uses the find data, the predicates and
+    //               the patterns it can not apply are rejected instead of
+    //               counting assets that do not match them.
+    if (arguments.countOnly && FilterHasStage(arguments.filter, FILTER_STAGE_OWNER))
+    {
+        printf_s("Invalid filter expression for --count: owner, group and perms can not be counted\n");
+        printf_s("Valid fields are: name, ext, type, hidden, size, ctime, atime, mtime");
+        exit(1);
+    }
+
+    for (directory_list_t *dir = arguments.headDir; arguments.countOnly && dir != NULL; dir = dir->next)
+    {
+        if (!IsCountPattern(dir->pattern))
+        {
+            printf_s("Invalid pattern for --count: %s\\%s\n", dir->path, dir->pattern);
+            printf_s("Valid patterns are a name, it is matched at any depth, ex: *.log or **\\*.log");
+            exit(1);
+        }
+    }
+
+    // NOTE(Andrei): The tree walks the sub-directories itself, only the
+    //               root level can be matched by the pattern.
+    for (directory_list_t *dir = arguments.headDir; arguments.showTree && !arguments.findDuplicates && dir != NULL; dir = dir->next)
+    {
+        char segment[MAX_PATH] = { 0 };
+
+        if (SplitPatternSegment(dir->pattern, segment, sizeof(segment)) != NULL || strcmp(segment, "**") == 0)
+        {
+            printf_s("Invalid pattern for --tree: %s\\%s\n", dir->path, dir->pattern);
+            printf_s("Valid patterns are a name of the root level, ex: *.log");
+            exit(1);
+        }
+    }
+
+    visited_set_t visited = { 0 };
+    duplicate_finder_t duplicates = { 0 };
+    git_repository_t *repository = NULL;
+    arena_t arena = { 0 };
+
+    // NOTE(Andrei): If the workers can not be started the
+    //               roots are listed one by one below.
+    if (CanListRootsConcurrently(&arguments))
+    {
+        ListRootsConcurrently(&arguments, &repository);
+    }
+    else if (arguments.recursiveList && !IsListedByMainLoop(&arguments))
+    {
+        ListTreePipelined(&arguments, &visited, &repository);
     }
 
     while (arguments.headDir != NULL)
     {
         directory_list_t *dir = arguments.headDir;
-        directory_t *directory = GetDirectoryContent(dir->path, &arguments);
+        directory_t *directory = NULL;
+        size_t streamed = 0;
+
+        stats_timer_t directoryTimer = BeginStatsDirectory(dir->path);
+        stats_timer_t timer = StartStatsTimer();
+
+        // NOTE(Andrei): Following links the same directory can be reached
+        //               again, report it instead of listing it in a loop.
+        file_identity_t identity = { 0 };
+
+        if (arguments.followLinks)
+        {
+            stats_timer_t probeTimer = StartStatsTimer();
+            BOOL identified = GetFileIdentity(dir->path, &identity);
+            StopStatsProbe(STATS_PROBE_IDENTITY, probeTimer);
+
+            if (identified && !InsertVisitedDirectory(&visited, identity))
+            {
+                printf_s("\"%s\": not listing already-listed directory\n", dir->path);
+                goto next_dir;
+            }
+        }
+
+        arguments.insertDir = arguments.depthFirst ? dir : NULL;
+
+        if (arguments.countOnly)
+        {
+            count_totals_t totals = { 0 };
+
+            if (!CountAssetTree(dir->path, dir->pattern, &arguments, &totals))
+            {
+                printf_s("\"%s\": No such file or directory\n", dir->path);
+            }
+
+            StopStatsPhase(STATS_PHASE_ENUMERATE, timer);
+            streamed = totals.documents + totals.directories + totals.links;
+
+            goto next_dir;
+        }
+
+        if (arguments.showTree && !arguments.findDuplicates)
+        {
+            timer = StartStatsTimer();
+
+            if (!PrintDirectoryTree(dir, &arguments))
+            {
+                printf_s("\"%s\": No such file or directory\n", dir->path);
+            }
+            else if (arguments.headDir->next != NULL)
+            {
+                printf_s("\n\n");
+            }
+
+            StopStatsPhase(STATS_PHASE_RENDER, timer);
+            goto next_dir;
+        }
+
+        if (arguments.streamLongFormat && arguments.showLongFormat && !arguments.findDuplicates)
+        {
+            if (!StreamLongFormat(dir, &arguments, &arena, &repository, &streamed))
+            {
+                printf_s("\"%s\": No such file or directory\n", dir->path);
+            }
+            else if (streamed > 0 && arguments.headDir->next != NULL)
+            {
+                printf_s("\n\n");
+            }
+
+            goto next_dir;
+        }
+
+        directory = GetDirectoryContent(dir, &arguments, &arena);
+        StopStatsPhase(STATS_PHASE_ENUMERATE, timer);
 
         if (directory == NULL)
         {
@@ -251,30 +1203,63 @@ int main(int argc, char *argv[])
             goto next_dir;
         }
 
-        SortDirectoryContent(directory, &arguments);
-        if (dir->next) printf_s("%s\n", dir->path);
+        if (arguments.findDuplicates)
+        {
+            for (size_t i = 0; i < directory->size; ++i)
+            {
+                AddDuplicateCandidate(&duplicates, &directory->data[i]);
+            }
+
+            goto next_dir;
+        }
 
-        if (arguments.showLongFormat)
+        if (arguments.showLongFormat && HasContentColumns(&arguments))
         {
-            PrintAssetLongFormat(directory, dir->path, &arguments);
-            if (arguments.headDir->next != NULL) printf_s("\n\n");
+            timer = StartStatsTimer();
+            ReadAssetsContent(directory->data, directory->size, &arguments);
+            StopStatsPhase(STATS_PHASE_CONTENT, timer);
         }
-        else
+
+        if (arguments.showLongFormat && arguments.showGit)
         {
-            PrintAssetShortFormat(directory, &arguments);
-            if (arguments.headDir->next != NULL) printf_s("\n\n");
+            timer = StartStatsTimer();
+            ReadGitStatus(&repository, dir->path, directory->data, directory->size);
+            StopStatsPhase(STATS_PHASE_CONTENT, timer);
         }
 
+        timer = StartStatsTimer();
+        SortDirectoryContent(directory, &arguments);
+        StopStatsPhase(STATS_PHASE_SORT, timer);
+
+        PrintDirectory(dir, directory, &arguments);
+
     next_dir:
         arguments.headDir = arguments.headDir->next;
-        CHECK_DELETE(directory);
+        EndStatsDirectory(directoryTimer, directory ? directory->size : streamed);
+
+        // NOTE(Andrei): All the memory of the directory is released at once.
+        ResetArena(&arena);
         CHECK_DELETE(dir);
     }
 
+    if (arguments.findDuplicates)
+    {
+        PrintDuplicates(&duplicates, &arguments);
+    }
+
     if (arguments.virtualTerminal)
     {
         DisableVirtualTerminal();
     }
 
+    DeleteFilter(arguments.filter);
+    DeleteDuplicateFinder(&duplicates);
+    CloseGitRepository(repository);
+    DeleteVisitedSet(&visited);
+    DeleteArena(&arena);
+
+    PrintStats();
+    CloseStatsTrace();
+
     return EXIT_SUCCESS;
 }
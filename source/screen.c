@@ -2,6 +2,10 @@
 #include "types.h"
 #include "utils.h"
 #include "win32.h"
+#include "stats.h"
+#include "arena.h"
+#include "datetime.h"
+#include "format.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,70 +23,9 @@
 // Colorize the output or not
 global_variable BOOL g_PrintWithColor = FALSE;
 
-// Maximum number of columns
-#define MAX_NUM_COLS 64
-
-///////////////////////////////////////////////////////////////////////////////
-
-/**
- * @brief Some predefined colors.
- */
-typedef enum text_color_t
-{
-    BLACK = 0,
-    DARKBLUE = FOREGROUND_BLUE,
-    DARKGREEN = FOREGROUND_GREEN,
-    DARKCYAN = FOREGROUND_GREEN | FOREGROUND_BLUE,
-    DARKRED = FOREGROUND_RED,
-    DARKMAGENTA = FOREGROUND_RED | FOREGROUND_BLUE,
-    DARKYELLOW = FOREGROUND_RED | FOREGROUND_GREEN,
-    DARKGRAY = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
-    GRAY = FOREGROUND_INTENSITY,
-    BLUE = FOREGROUND_INTENSITY | FOREGROUND_BLUE,
-    GREEN = FOREGROUND_INTENSITY | FOREGROUND_GREEN,
-    CYAN = FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_BLUE,
-    RED = FOREGROUND_INTENSITY | FOREGROUND_RED,
-    MAGENTA = FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE,
-    YELLOW = FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN,
-    WHITE = FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
-} text_color_t;
-
-///////////////////////////////////////////////////////////////////////////////
-
-/**
- * @brief Column information.
- *
- * 'size'   : number of character needed for the column
- */
-typedef struct col_t
-{
-    size_t size;
-} col_t;
-
-/**
- * @brief Row information.
- *
- * 'size'   : number of columns in the row
- * 'cols'   : information of each column (maximun of 'MAX_NUM_COLS')
- */
-typedef struct row_t
-{
-    size_t size;
-    col_t cols[MAX_NUM_COLS];
-} row_t;
-
 ///////////////////////////////////////////////////////////////////////////////
 
-/**
- * @brief Prints text on the screen with a given color. If the global variable
- * 'g_PrintWithColor' is not set the text it will be printed using the default
- * console text color.
- *
- * @param textColor text color, see 'ETextColor' (types.h)
- * @param fmt       format of the text or the text itself
- * @param ...       variable arguments list
- */
-local_function void color_printf(text_color_t textColor, const char *fmt, ...)
+void color_printf(text_color_t textColor, const char *fmt, ...)
 {
     if (!g_PrintWithColor)
     {
@@ -114,21 +57,7 @@ local_function void color_printf(text_color_t textColor, const char *fmt, ...)
     return;
 }
 
-/**
- * @brief Prints text on the screen with a given color. If the global variable
- * 'g_PrintWithColor' is not set the text it will be printed using the default
- * console text color.
- *
- * It makes use of the Virtual Console sequence
- * https://docs.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences
- *
- * @param r         red channel intensity (0 to 255)
- * @param g         green channel intensity (0 to 255)
- * @param b         blue channel intensity (0 to 255)
- * @param fmt       format of the text or the text itself
- * @param ...       variable arguments list
- */
-local_function void color_printf_vt(int r, int g, int b, const char *fmt, ...)
+void color_printf_vt(int r, int g, int b, const char *fmt, ...)
 {
     if (!g_PrintWithColor)
     {
@@ -199,42 +128,10 @@ local_function text_color_t GetTextNameColor(const asset_t *asset)
     return textColor;
 }
 
-/**
- * @brief Given an asset, return char with its representation.
- * It tells us if is a directory, symbolic link or other type.
- *
- * 'd' for directory
- * 'l' for symbolic links
- * '-' for any other format
- *
- * @param data      pointer to the asset data structure
- * @return char     'd', 'l' or '-'
- */
-local_function char GetContentType(const asset_t *data)
-{
-    // NOTE(Andrei): Order dependency, a symlink can also have
-    //               the directory attribute marked.
-
-    if (data->type.symlink)   return 'l';
-    if (data->type.directory) return 'd';
-
-    return '-';
-}
-
-/**
- * @brief Get the number of columns to display the content as grid.
- *
- * @param content   pointer to the directory containing the assets
- * @param showIcons take into account the icons?
- * @return row_t    number of columns
- */
-local_function row_t GetNumberOfColumns(const directory_t *content, BOOL showIcons, size_t padding)
+row_t GetNumberOfColumns(const directory_t *content, BOOL showIcons, size_t padding, size_t width)
 {
     size_t totalSize = 0;
-    size_t width = 0, height = 0;
-
-    GetScreenBufferSize(&width, &height);
-    size_t *textSizeArray = (size_t*)malloc(sizeof(size_t) * content->size);
+    size_t *textSizeArray = (size_t*)PushArena(content->arena, sizeof(size_t) * content->size);
 
     for (size_t i = 0; i < content->size; ++i)
     {
@@ -274,117 +171,229 @@ compute_column_size:
 
     // Note(Andrei): Remove padding from last column
     ret.cols[ret.size - 1].size -= padding;
-
-    CHECK_DELETE(textSizeArray);
     return ret;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void PrintAssetLongFormat(const directory_t *content, const char *directoryName, const arguments_t *arguments)
+long_format_t GetLongFormatLayout(const asset_t *assets, size_t count, const char *directoryName)
 {
-    g_PrintWithColor = arguments->colors;
+    long_format_t layout = { 0 };
 
     char currentPath[MAX_PATH] = { 0 };
     GetDirectoryFromPath(directoryName, currentPath, MAX_PATH);
+    layout.directoryLength = strlen(currentPath);
 
-    size_t ownerLength = 0, domainLength = 0;
-    size_t directoryLength = strlen(currentPath);
-
-    for (size_t i = 0; i < content->size && arguments->showLongFormat; ++i)
+    for (size_t i = 0; i < count; ++i)
     {
-        size_t s = strlen(content->data[i].domain);
-        domainLength = domainLength < s ? s : domainLength;
+        size_t s = strlen(assets[i].domain);
+        layout.domainLength = layout.domainLength < s ? s : layout.domainLength;
 
-        s = strlen(content->data[i].owner);
-        ownerLength = ownerLength < s ? s : ownerLength;
+        s = strlen(assets[i].owner);
+        layout.ownerLength = layout.ownerLength < s ? s : layout.ownerLength;
+
+        const content_info_t *c = &assets[i].content;
+        s = c->read ? (size_t)snprintf(NULL, 0, "%zu", c->lines) : 1;
+        layout.linesLength = layout.linesLength < s ? s : layout.linesLength;
+
+        s = c->read ? strlen(c->mime) : 1;
+        layout.mimeLength = layout.mimeLength < s ? s : layout.mimeLength;
     }
 
-    for (size_t i = 0; i < content->size; ++i)
-    {
-        // Content type
-        text_color_t textColor = GRAY;
-        color_printf(textColor, "%c", GetContentType(&content->data[i]));
+    return layout;
+}
 
-        // Permission read
-        textColor = YELLOW;
-        color_printf(textColor, "%c", content->data[i].accessRights.read ? 'r' : '-');
+void PrintAssetLongRow(const asset_t *asset, const long_format_t *layout, const arguments_t *arguments)
+{
+    g_PrintWithColor = arguments->colors;
 
-        // Permission write
-        textColor = RED;
-        color_printf(textColor, "%c", content->data[i].accessRights.write ? 'w' : '-');
+    char permissions[4], size[SIZE_TEXT_SIZE];
+    FormatPermissions(&asset->accessRights, permissions, sizeof(permissions));
+    FormatSize(asset->size, arguments->sizeFormat, size, SIZE_TEXT_SIZE);
 
-        // Permission execution
-        textColor = GREEN;
-        color_printf(textColor, "%c", content->data[i].accessRights.execution ? 'x' : '-');
+    // Content type
+    text_color_t textColor = GRAY;
+    color_printf(textColor, "%c", FormatAssetType(asset));
 
-        // File size
-        textColor = GREEN;
-        color_printf(textColor, "%s  ", GetFileSizeAsText(content->data[i].size));
+    // Permission read
+    textColor = YELLOW;
+    color_printf(textColor, "%c", permissions[0]);
 
-        // Domain
-        textColor = YELLOW;
-        color_printf(textColor, "%*.*s  ", domainLength, domainLength, content->data[i].domain);
+    // Permission write
+    textColor = RED;
+    color_printf(textColor, "%c", permissions[1]);
 
-        // Owner
-        textColor = DARKYELLOW;
-        color_printf(textColor, "%*.*s  ", ownerLength, ownerLength, content->data[i].owner);
+    // Permission execution
+    textColor = GREEN;
+    color_printf(textColor, "%c", permissions[2]);
 
-        // Creation date
-        textColor = CYAN;
-        color_printf(textColor, "%s  ", content->data[i].date);
+    // File size
+    textColor = GREEN;
+    color_printf(textColor, "%s  ", size);
 
-        // File name
-        textColor = GetTextNameColor(&content->data[i]);
-        const asset_metadata_t *m = content->data[i].metadata;
+    // Domain
+    textColor = YELLOW;
+    color_printf(textColor, "%*.*s  ", layout->domainLength, layout->domainLength, asset->domain);
 
-        if (arguments->showIcons)
+    // Owner
+    textColor = DARKYELLOW;
+    color_printf(textColor, "%*.*s  ", layout->ownerLength, layout->ownerLength, asset->owner);
+
+    // Creation date, formatted only for the printed rows
+    char date[DATE_SIZE];
+    FormatDateTime(GetDisplayTimestamp(asset, arguments->sortField), date, DATE_SIZE);
+
+    textColor = CYAN;
+    color_printf(textColor, "%s  ", date);
+
+    // Content columns, '-' if the document was not read
+    const content_info_t *c = &asset->content;
+
+    if (arguments->showChecksum)
+    {
+        textColor = DARKGRAY;
+        if (c->read) color_printf(textColor, "%016llx  ", c->checksum);
+        else color_printf(textColor, "%16s  ", "-");
+    }
+
+    if (arguments->showLines)
+    {
+        textColor = DARKCYAN;
+        if (c->read) color_printf(textColor, "%*zu  ", (int)layout->linesLength, c->lines);
+        else color_printf(textColor, "%*s  ", (int)layout->linesLength, "-");
+    }
+
+    if (arguments->showMime)
+    {
+        textColor = DARKMAGENTA;
+        color_printf(textColor, "%-*s  ", (int)layout->mimeLength, c->read ? c->mime : "-");
+    }
+
+    // Git status, staged letter in green and worktree letter in red as git does
+    if (arguments->showGit)
+    {
+        const char *g = asset->gitStatus;
+
+        if (g[0] == '\0') color_printf(DARKGRAY, "    ");
+        else if (g[0] == '!') color_printf(DARKGRAY, "%s  ", g);
+        else if (g[0] == '?' || g[0] == 'U') color_printf(RED, "%s  ", g);
+        else
         {
-            if (arguments->virtualTerminal)
-            {
-                color_printf_vt(m->r, m->g, m->b, "%s ", m->icon);
-            }
-            else
-            {
-                color_printf(textColor, "%s ", m->icon);
-            }
+            color_printf(GREEN, "%c", g[0]);
+            color_printf(RED, "%c  ", g[1]);
         }
+    }
 
-        if (arguments->recursiveList)
+    // File name
+    textColor = GetTextNameColor(asset);
+    const asset_metadata_t *m = asset->metadata;
+
+    if (arguments->showIcons)
+    {
+        if (arguments->virtualTerminal)
         {
-            if (arguments->virtualTerminal)
-            {
-                color_printf_vt(m->r, m->g, m->b, "%s", &content->data[i].path[directoryLength + 1]);
-            }
-            else
-            {
-                color_printf(textColor, "%s", &content->data[i].path[directoryLength + 1]);
-            }
+            color_printf_vt(m->r, m->g, m->b, "%s ", m->icon);
         }
         else
         {
-            if (arguments->virtualTerminal)
-            {
-                color_printf_vt(m->r, m->g, m->b, "%s", content->data[i].name);
-            }
-            else
-            {
-                color_printf(textColor, "%s", content->data[i].name);
-            }
+            color_printf(textColor, "%s ", m->icon);
         }
+    }
 
-        // Show where symlink is pointing
-        if (content->data[i].link[0] != '\0')
+    if (arguments->recursiveList)
+    {
+        if (arguments->virtualTerminal)
+        {
+            color_printf_vt(m->r, m->g, m->b, "%s", &asset->path[layout->directoryLength + 1]);
+        }
+        else
+        {
+            color_printf(textColor, "%s", &asset->path[layout->directoryLength + 1]);
+        }
+    }
+    else
+    {
+        if (arguments->virtualTerminal)
         {
-            printf_s(" -> ");
-            color_printf(textColor, "%s", content->data[i].link);
+            color_printf_vt(m->r, m->g, m->b, "%s", asset->name);
         }
+        else
+        {
+            color_printf(textColor, "%s", asset->name);
+        }
+    }
+
+    // Show where symlink is pointing
+    if (asset->link != NULL)
+    {
+        printf_s(" -> ");
+        color_printf(textColor, "%s", asset->link);
+    }
+}
+
+void PrintAssetTreeRow(const asset_t *asset, const char *prefix, BOOL last, const arguments_t *arguments)
+{
+    g_PrintWithColor = arguments->colors;
+
+    text_color_t textColor = GetTextNameColor(asset);
+    const asset_metadata_t *m = asset->metadata;
+
+    color_printf(DARKGRAY, "%s%s", prefix, last ? u8"\u2514\u2500\u2500 " : u8"\u251c\u2500\u2500 ");
+
+    if (arguments->showIcons)
+    {
+        if (arguments->virtualTerminal)
+        {
+            color_printf_vt(m->r, m->g, m->b, "%s ", m->icon);
+        }
+        else
+        {
+            color_printf(textColor, "%s ", m->icon);
+        }
+    }
+
+    if (arguments->virtualTerminal)
+    {
+        color_printf_vt(m->r, m->g, m->b, "%s", asset->name);
+    }
+    else
+    {
+        color_printf(textColor, "%s", asset->name);
+    }
+
+    if (asset->link != NULL)
+    {
+        printf_s(" -> ");
+        color_printf(textColor, "%s", asset->link);
+    }
+
+    putchar('\n');
+}
+
+void PrintAssetLongFormat(const directory_t *content, const char *directoryName, const arguments_t *arguments)
+{
+    stats_timer_t timer = StartStatsTimer();
+    long_format_t layout = GetLongFormatLayout(content->data, content->size, directoryName);
+
+    StopStatsPhase(STATS_PHASE_LAYOUT, timer);
+    timer = StartStatsTimer();
+
+    for (size_t i = 0; i < content->size; ++i)
+    {
+        PrintAssetLongRow(&content->data[i], &layout, arguments);
 
         if (i < content->size - 1)
         {
             putchar('\n');
         }
     }
+
+    StopStatsPhase(STATS_PHASE_RENDER, timer);
+}
+
+void SetColorOutput(BOOL enabled)
+{
+    g_PrintWithColor = enabled;
 }
 
 void PrintAssetShortFormat(const directory_t *content, const arguments_t *arguments)
@@ -392,8 +401,15 @@ void PrintAssetShortFormat(const directory_t *content, const arguments_t *argume
     g_PrintWithColor = arguments->colors;
     BOOL showIcons = arguments->showIcons;
 
+    size_t width = 0, height = 0;
+    stats_timer_t timer = StartStatsTimer();
+    GetScreenBufferSize(&width, &height);
+
     size_t extraspace = showIcons ? 3 : 2;
-    row_t row = GetNumberOfColumns(content, arguments->showIcons, extraspace);
+    row_t row = GetNumberOfColumns(content, arguments->showIcons, extraspace, width);
+
+    StopStatsPhase(STATS_PHASE_LAYOUT, timer);
+    timer = StartStatsTimer();
 
     for (size_t i = 0; i < content->size; ++i)
     {
@@ -433,6 +449,8 @@ void PrintAssetShortFormat(const directory_t *content, const arguments_t *argume
             printf_s("%*.*s", padLen, padLen, " ");
         }
     }
+
+    StopStatsPhase(STATS_PHASE_RENDER, timer);
 }
 
 void ShowMetaData(const arguments_t *arguments)
@@ -2,6 +2,106 @@
 
 #include "types.h"
 
+#define MAX_NUM_COLS 64 // maximum number of columns
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Some predefined colors.
+ */
+typedef enum text_color_t
+{
+    BLACK = 0,
+    DARKBLUE = FOREGROUND_BLUE,
+    DARKGREEN = FOREGROUND_GREEN,
+    DARKCYAN = FOREGROUND_GREEN | FOREGROUND_BLUE,
+    DARKRED = FOREGROUND_RED,
+    DARKMAGENTA = FOREGROUND_RED | FOREGROUND_BLUE,
+    DARKYELLOW = FOREGROUND_RED | FOREGROUND_GREEN,
+    DARKGRAY = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
+    GRAY = FOREGROUND_INTENSITY,
+    BLUE = FOREGROUND_INTENSITY | FOREGROUND_BLUE,
+    GREEN = FOREGROUND_INTENSITY | FOREGROUND_GREEN,
+    CYAN = FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_BLUE,
+    RED = FOREGROUND_INTENSITY | FOREGROUND_RED,
+    MAGENTA = FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE,
+    YELLOW = FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN,
+    WHITE = FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,
+} text_color_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Column information.
+ *
+ * 'size'   : number of character needed for the column
+ */
+typedef struct col_t
+{
+    size_t size;
+} col_t;
+
+/**
+ * @brief Row information.
+ *
+ * 'size'   : number of columns in the row
+ * 'cols'   : information of each column (maximun of 'MAX_NUM_COLS')
+ */
+typedef struct row_t
+{
+    size_t size;
+    col_t cols[MAX_NUM_COLS];
+} row_t;
+
+/**
+ * @brief Widths of the columns of the long format.
+ *
+ * 'directoryLength'    : length of the listed directory, removed from the paths on recursive listings
+ * 'domainLength'       : width of the domain column
+ * 'ownerLength'        : width of the owner column
+ * 'linesLength'        : width of the lines column
+ * 'mimeLength'         : width of the MIME type column
+ */
+typedef struct long_format_t
+{
+    size_t directoryLength;
+    size_t domainLength, ownerLength;
+    size_t linesLength, mimeLength;
+} long_format_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Compute the widths of the long format columns from the given assets.
+ *
+ * @param assets            assets to measure
+ * @param count             number of assets
+ * @param directoryName     name of the listed directory
+ * @return long_format_t    widths of the columns
+ */
+long_format_t GetLongFormatLayout(const asset_t *assets, size_t count, const char *directoryName);
+
+/**
+ * @brief Print one row of the long format without the end of line. The domain
+ * and owner longer than the column width are truncated.
+ *
+ * @param asset         pointer to the asset
+ * @param layout        widths of the columns, see 'GetLongFormatLayout'
+ * @param arguments     pointer to the parsed arguments structure
+ */
+void PrintAssetLongRow(const asset_t *asset, const long_format_t *layout, const arguments_t *arguments);
+
+/**
+ * @brief Print one row of the tree view ('-T') with its end of line: the
+ * prefix of the parents, the branch of the asset, its icon and its name.
+ *
+ * @param asset         pointer to the asset
+ * @param prefix        branches of the parent directories (UTF-8 box drawing)
+ * @param last          the asset is the last one of its directory
+ * @param arguments     pointer to the parsed arguments structure
+ */
+void PrintAssetTreeRow(const asset_t *asset, const char *prefix, BOOL last, const arguments_t *arguments);
+
 /**
  * @brief Prints to screen the assets found. This functions show the type of
  * file, the user permissions, group, owner, date, etc...
@@ -30,3 +130,50 @@ void PrintAssetShortFormat(const directory_t *content, const arguments_t *argume
  * @param arguments pointer to the parsed arguments structure
  */
 void ShowMetaData(const arguments_t *arguments);
+
+/**
+ * @brief Prints text on the screen with a given color. If the global variable
+ * 'g_PrintWithColor' is not set the text it will be printed using the default
+ * console text color.
+ *
+ * @param textColor text color, see 'ETextColor' (types.h)
+ * @param fmt       format of the text or the text itself
+ * @param ...       variable arguments list
+ */
+void color_printf(text_color_t textColor, const char *fmt, ...);
+
+/**
+ * @brief Prints text on the screen with a given color. If the global variable
+ * 'g_PrintWithColor' is not set the text it will be printed using the default
+ * console text color.
+ *
+ * It makes use of the Virtual Console sequence
+ * https://docs.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences
+ *
+ * @param r         red channel intensity (0 to 255)
+ * @param g         green channel intensity (0 to 255)
+ * @param b         blue channel intensity (0 to 255)
+ * @param fmt       format of the text or the text itself
+ * @param ...       variable arguments list
+ */
+void color_printf_vt(int r, int g, int b, const char *fmt, ...);
+
+/**
+ * @brief Enable or disable the colors of 'color_printf' and 'color_printf_vt',
+ * the print functions of the assets set it from the arguments.
+ *
+ * @param enabled   colorize the output or not
+ */
+void SetColorOutput(BOOL enabled);
+
+/**
+ * @brief Get the number of columns to display the content as grid. The
+ * temporary sizes are allocated on the arena of the content.
+ *
+ * @param content   pointer to the directory containing the assets
+ * @param showIcons take into account the icons?
+ * @param padding   characters added after each name
+ * @param width     number of characters of the screen row
+ * @return row_t    number of columns
+ */
+row_t GetNumberOfColumns(const directory_t *content, BOOL showIcons, size_t padding, size_t width);
@@ -39,25 +39,25 @@ int OrderByOwner(const void *lhv, const void *rhv)
 int OrderBySize(const void *lhv, const void *rhv)
 {
     const asset_t *a = lhv; const asset_t *b = rhv;
-    return (int)((long long)b->size - (long long)a->size);
+    return (b->size > a->size) - (b->size < a->size);
 }
 
 int OrderByCreationTimestamp(const void *lhv, const void *rhv)
 {
     const asset_t *a = lhv; const asset_t *b = rhv;
-    return (int)((long long)b->timestamp.creation - (long long)a->timestamp.creation);
+    return (b->timestamp.creation > a->timestamp.creation) - (b->timestamp.creation < a->timestamp.creation);
 }
 
 int OrderByAccessedTimestamp(const void *lhv, const void *rhv)
 {
     const asset_t *a = lhv; const asset_t *b = rhv;
-    return (int)((long long)b->timestamp.access - (long long)a->timestamp.access);
+    return (b->timestamp.access > a->timestamp.access) - (b->timestamp.access < a->timestamp.access);
 }
 
 int OrderByModifiedTimestamp(const void *lhv, const void *rhv)
 {
     const asset_t *a = lhv; const asset_t *b = rhv;
-    return (int)((long long)b->timestamp.modification - (long long)a->timestamp.modification);
+    return (b->timestamp.modification > a->timestamp.modification) - (b->timestamp.modification < a->timestamp.modification);
 }
 
 void ReverseOrder(directory_t *directory)
@@ -0,0 +1,420 @@
+#include "stats.h"
+#include "types.h"
+
+#include <Psapi.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#pragma comment(lib, "psapi.lib")
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Counters of a phase or a probe.
+ *
+ * 'count'  : number of times it was measured
+ * 'ticks'  : total time in performance counter ticks
+ * 'cycles' : total cycles of the thread (only with the performance counters)
+ * 'faults' : total page faults (only with the performance counters)
+ * 'calls'  : number of system calls (only probes)
+ * 'opens'  : number of opened files or directories (only probes)
+ */
+typedef struct stats_counter_t
+{
+    size_t count;
+    unsigned long long ticks, cycles;
+    size_t faults;
+    size_t calls, opens;
+} stats_counter_t;
+
+/**
+ * @brief Statistics of the whole execution.
+ *
+ * 'enabled'    : the statistics are collected
+ * 'report'     : the statistics are printed at the end
+ * 'perf'       : the performance counters are collected and printed
+ * 'frequency'  : performance counter frequency (ticks per second)
+ * 'assets'     : number of listed assets
+ *
+ * 'phases'     : counters of each phase
+ * 'probes'     : counters of each probe
+ * 'allocated'  : bytes allocated by the arenas
+ * 'freed'      : bytes freed by the arenas
+ * 'allocations': number of arena blocks allocated
+ *
+ * 'trace'      : file of the trace events or NULL
+ * 'traceStart' : time of the first trace event
+ * 'traceEvents': number of written trace events
+ * 'directory'  : path of the directory being listed
+ * 'probeTicks' : probe ticks when the directory started
+ */
+typedef struct stats_t
+{
+    BOOL enabled, report, perf;
+    unsigned long long frequency;
+    size_t assets;
+
+    stats_counter_t phases[STATS_PHASE_COUNT];
+    stats_counter_t probes[STATS_PROBE_COUNT];
+
+    size_t allocated, freed;
+    size_t allocations;
+
+    FILE *trace;
+    unsigned long long traceStart;
+    size_t traceEvents;
+
+    const char *directory;
+    unsigned long long probeTicks[STATS_PROBE_COUNT];
+} stats_t;
+
+global_variable stats_t g_Stats = { 0 };
+
+global_variable const char *g_PhaseNames[STATS_PHASE_COUNT] =
+{
+    "enumerate", "probe", "content", "sort", "layout", "render"
+};
+
+global_variable const char *g_ProbeNames[STATS_PROBE_COUNT] =
+{
+    "find", "attributes", "timestamps", "permissions", "owner", "metadata", "link", "identity"
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Convert performance counter ticks to milliseconds.
+ *
+ * @param ticks     performance counter ticks
+ * @return double   milliseconds
+ */
+local_function double TicksToMilliseconds(unsigned long long ticks)
+{
+    return (double)ticks * 1000.0 / (double)g_Stats.frequency;
+}
+
+/**
+ * @brief Start collecting the statistics.
+ */
+local_function void EnableCollection()
+{
+    LARGE_INTEGER frequency = { 0 };
+    QueryPerformanceFrequency(&frequency);
+
+    g_Stats.frequency = (unsigned long long)frequency.QuadPart;
+    g_Stats.enabled = TRUE;
+}
+
+/**
+ * @brief Add the measure from the start until now to the counter.
+ *
+ * @param counter   counter where the measure is added
+ * @param start     start of the measure
+ * @param now       end of the measure
+ */
+local_function void AddMeasure(stats_counter_t *counter, const stats_timer_t *start, const stats_timer_t *now)
+{
+    counter->count += 1;
+    counter->ticks += now->ticks - start->ticks;
+    counter->cycles += now->cycles - start->cycles;
+    counter->faults += now->faults - start->faults;
+}
+
+/**
+ * @brief Remove the measures of the probes from the enumeration, the probes
+ * run inside of it.
+ *
+ * @param enumerate     counter of the enumeration
+ * @param probe         counter of the probes
+ */
+local_function void RemoveProbeMeasures(stats_counter_t *enumerate, const stats_counter_t *probe)
+{
+    enumerate->ticks = enumerate->ticks > probe->ticks ? enumerate->ticks - probe->ticks : 0;
+    enumerate->cycles = enumerate->cycles > probe->cycles ? enumerate->cycles - probe->cycles : 0;
+    enumerate->faults = enumerate->faults > probe->faults ? enumerate->faults - probe->faults : 0;
+}
+
+/**
+ * @brief Print the performance counters of each phase.
+ */
+local_function void PrintPerfCounters()
+{
+    fprintf(stderr, "\n%-12s  %14s  %12s  %12s  %12s  %12s  %13s\n", "phase", "cycles", "cycles/asset", "page faults", "instructions", "cache misses", "branch misses");
+
+    for (size_t i = 0; i < STATS_PHASE_COUNT; ++i)
+    {
+        const stats_counter_t *c = &g_Stats.phases[i];
+        double perAsset = g_Stats.assets ? (double)c->cycles / (double)g_Stats.assets : 0.0;
+
+        fprintf(stderr, "%-12s  %14llu  %12.1lf  %12zu  %12s  %12s  %13s\n", g_PhaseNames[i], c->cycles, perAsset, c->faults, "n/a", "n/a", "n/a");
+    }
+
+    fprintf(stderr, "\nThe instructions, cache and branch misses need the performance monitoring unit,\n");
+    fprintf(stderr, "it is not available to user mode programs on Windows.\n");
+}
+
+/**
+ * @brief Write a JSON string, the text is converted from the ANSI code page
+ * to UTF-8 and the quotes, backslashes and control characters are escaped.
+ *
+ * @param file  file where the string is written
+ * @param text  text to write
+ */
+local_function void WriteJsonString(FILE *file, const char *text)
+{
+    wchar_t wide[MAX_PATH] = { 0 };
+    char utf8[MAX_PATH * 4] = { 0 };
+
+    if (MultiByteToWideChar(CP_ACP, 0, text, -1, wide, MAX_PATH) == 0 ||
+        WideCharToMultiByte(CP_UTF8, 0, wide, -1, utf8, sizeof(utf8), NULL, NULL) == 0)
+    {
+        strcpy_s(utf8, sizeof(utf8), "?");
+    }
+
+    fputc('"', file);
+
+    for (const unsigned char *c = (const unsigned char *)utf8; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+        else if (*c < 0x20) fprintf(file, "\\u%04x", *c);
+        else fputc(*c, file);
+    }
+
+    fputc('"', file);
+}
+
+/**
+ * @brief Write the beginning of a complete ('X') trace event, the arguments
+ * object is left open with the path of the directory so more arguments can
+ * be added before 'EndTraceEvent'.
+ *
+ * @param name      name of the event
+ * @param category  category of the event
+ * @param start     start time in performance counter ticks
+ * @param end       end time in performance counter ticks
+ */
+local_function void BeginTraceEvent(const char *name, const char *category, unsigned long long start, unsigned long long end)
+{
+    double ts = (double)(start - g_Stats.traceStart) * 1000000.0 / (double)g_Stats.frequency;
+    double dur = (double)(end - start) * 1000000.0 / (double)g_Stats.frequency;
+
+    fprintf
+    (
+        g_Stats.trace,
+        "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3lf,\"dur\":%.3lf,\"pid\":%lu,\"tid\":%lu,\"args\":{\"path\":",
+        g_Stats.traceEvents++ > 0 ? "," : "", name, category, ts, dur, GetCurrentProcessId(), GetCurrentThreadId()
+    );
+
+    WriteJsonString(g_Stats.trace, g_Stats.directory ? g_Stats.directory : "");
+}
+
+/**
+ * @brief Close the arguments and the event started by 'BeginTraceEvent'.
+ */
+local_function void EndTraceEvent()
+{
+    fputs("}}", g_Stats.trace);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void EnableStats()
+{
+    EnableCollection();
+    g_Stats.report = TRUE;
+}
+
+BOOL EnablePerfCounters()
+{
+    unsigned long long cycles = 0;
+
+    // NOTE(Andrei): Without the thread cycles the page faults are still
+    //               measured, the cycles are reported as zero.
+    BOOL oK = QueryThreadCycleTime(GetCurrentThread(), &cycles);
+
+    EnableCollection();
+    g_Stats.perf = TRUE;
+
+    return oK;
+}
+
+BOOL OpenStatsTrace(const char *path)
+{
+    if (fopen_s(&g_Stats.trace, path, "w") != 0 || g_Stats.trace == NULL)
+    {
+        g_Stats.trace = NULL;
+        return FALSE;
+    }
+
+    EnableCollection();
+    g_Stats.traceStart = StartStatsTimer().ticks;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", g_Stats.trace);
+    fprintf
+    (
+        g_Stats.trace,
+        "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"main\"}}",
+        GetCurrentProcessId(), GetCurrentThreadId()
+    );
+
+    ++g_Stats.traceEvents;
+    return TRUE;
+}
+
+void CloseStatsTrace()
+{
+    if (g_Stats.trace == NULL) return;
+
+    fputs("\n]}\n", g_Stats.trace);
+    fclose(g_Stats.trace);
+
+    g_Stats.trace = NULL;
+}
+
+stats_timer_t BeginStatsDirectory(const char *path)
+{
+    if (!g_Stats.enabled) return (stats_timer_t){ 0 };
+
+    g_Stats.directory = path;
+
+    for (size_t i = 0; i < STATS_PROBE_COUNT; ++i)
+    {
+        g_Stats.probeTicks[i] = g_Stats.probes[i].ticks;
+    }
+
+    return StartStatsTimer();
+}
+
+void EndStatsDirectory(stats_timer_t start, size_t assets)
+{
+    if (!g_Stats.enabled) return;
+    g_Stats.assets += assets;
+
+    if (g_Stats.trace != NULL)
+    {
+        BeginTraceEvent("directory", "directory", start.ticks, StartStatsTimer().ticks);
+        fprintf(g_Stats.trace, ",\"assets\":%zu", assets);
+
+        // NOTE(Andrei): The probes run once per asset, only the time
+        //               spent by each one on the directory is written.
+        for (size_t i = 0; i < STATS_PROBE_COUNT; ++i)
+        {
+            unsigned long long ticks = g_Stats.probes[i].ticks - g_Stats.probeTicks[i];
+            fprintf(g_Stats.trace, ",\"%s ms\":%.3lf", g_ProbeNames[i], TicksToMilliseconds(ticks));
+        }
+
+        EndTraceEvent();
+    }
+
+    g_Stats.directory = NULL;
+}
+
+stats_timer_t StartStatsTimer()
+{
+    stats_timer_t timer = { 0 };
+    if (!g_Stats.enabled) return timer;
+
+    LARGE_INTEGER counter = { 0 };
+    QueryPerformanceCounter(&counter);
+    timer.ticks = (unsigned long long)counter.QuadPart;
+
+    if (g_Stats.perf)
+    {
+        PROCESS_MEMORY_COUNTERS pmc = { sizeof(PROCESS_MEMORY_COUNTERS) };
+        GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+
+        QueryThreadCycleTime(GetCurrentThread(), &timer.cycles);
+        timer.faults = pmc.PageFaultCount;
+    }
+
+    return timer;
+}
+
+void StopStatsPhase(stats_phase_e phase, stats_timer_t start)
+{
+    if (!g_Stats.enabled) return;
+
+    stats_timer_t now = StartStatsTimer();
+    AddMeasure(&g_Stats.phases[phase], &start, &now);
+
+    if (g_Stats.trace != NULL)
+    {
+        BeginTraceEvent(g_PhaseNames[phase], "phase", start.ticks, now.ticks);
+        EndTraceEvent();
+    }
+}
+
+void StopStatsProbe(stats_probe_e probe, stats_timer_t start)
+{
+    if (!g_Stats.enabled) return;
+
+    stats_timer_t now = StartStatsTimer();
+    AddMeasure(&g_Stats.probes[probe], &start, &now);
+
+    // NOTE(Andrei): Opening the directory is part of the enumeration.
+    if (probe == STATS_PROBE_FIND) return;
+
+    AddMeasure(&g_Stats.phases[STATS_PHASE_PROBE], &start, &now);
+}
+
+void CountStatsCalls(stats_probe_e probe, size_t calls, size_t opens)
+{
+    if (!g_Stats.enabled) return;
+
+    g_Stats.probes[probe].calls += calls;
+    g_Stats.probes[probe].opens += opens;
+}
+
+void CountStatsMemory(size_t allocated, size_t freed)
+{
+    if (!g_Stats.enabled) return;
+
+    g_Stats.allocated += allocated;
+    g_Stats.freed += freed;
+    g_Stats.allocations += allocated > 0;
+}
+
+void PrintStats()
+{
+    if (!g_Stats.report && !g_Stats.perf) return;
+
+    // NOTE(Andrei): The probes are measured inside the enumeration,
+    //               remove them so each phase has its own measures.
+    RemoveProbeMeasures(&g_Stats.phases[STATS_PHASE_ENUMERATE], &g_Stats.phases[STATS_PHASE_PROBE]);
+
+    if (g_Stats.perf)
+    {
+        PrintPerfCounters();
+    }
+
+    if (!g_Stats.report) return;
+
+    fprintf(stderr, "\n%-12s  %10s  %12s\n", "phase", "count", "ms");
+
+    for (size_t i = 0; i < STATS_PHASE_COUNT; ++i)
+    {
+        const stats_counter_t *c = &g_Stats.phases[i];
+        fprintf(stderr, "%-12s  %10zu  %12.3lf\n", g_PhaseNames[i], c->count, TicksToMilliseconds(c->ticks));
+    }
+
+    fprintf(stderr, "\n%-12s  %10s  %10s  %10s  %12s\n", "probe", "count", "syscalls", "opens", "ms");
+
+    for (size_t i = 0; i < STATS_PROBE_COUNT; ++i)
+    {
+        const stats_counter_t *c = &g_Stats.probes[i];
+        fprintf(stderr, "%-12s  %10zu  %10zu  %10zu  %12.3lf\n", g_ProbeNames[i], c->count, c->calls, c->opens, TicksToMilliseconds(c->ticks));
+    }
+
+    fprintf(stderr, "\narenas        %zu blocks, %zu bytes allocated, %zu bytes freed\n", g_Stats.allocations, g_Stats.allocated, g_Stats.freed);
+
+    PROCESS_MEMORY_COUNTERS pmc = { sizeof(PROCESS_MEMORY_COUNTERS) };
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        double peakWorkingSet = pmc.PeakWorkingSetSize / (1024.0 * 1024.0);
+        double peakCommit = pmc.PeakPagefileUsage / (1024.0 * 1024.0);
+
+        fprintf(stderr, "peak memory   %.2lf MB working set, %.2lf MB committed\n", peakWorkingSet, peakCommit);
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Phases of a listing. The probes run inside the enumeration, their
+ * time is reported on its own phase and not as part of the enumeration.
+ */
+typedef enum stats_phase_e
+{
+    /** @brief Directory enumeration and glob/filter matching. */
+    STATS_PHASE_ENUMERATE,
+
+    /** @brief Information retrieval of each asset, see 'stats_probe_e'. */
+    STATS_PHASE_PROBE,
+
+    /** @brief Content of the documents (checksum, lines and MIME type). */
+    STATS_PHASE_CONTENT,
+
+    /** @brief Sort of the assets. */
+    STATS_PHASE_SORT,
+
+    /** @brief Column sizes of the output. */
+    STATS_PHASE_LAYOUT,
+
+    /** @brief Output of the assets. */
+    STATS_PHASE_RENDER,
+
+    /** @brief Number of phases. */
+    STATS_PHASE_COUNT
+} stats_phase_e;
+
+/**
+ * @brief Information retrieved for each asset, the ones asking the system
+ * report the calls and the files they open.
+ */
+typedef enum stats_probe_e
+{
+    /** @brief FindFirstFile and FindNextFile, only FindFirstFile is timed. */
+    STATS_PROBE_FIND,
+
+    /** @brief Attributes of a path (directory or document). */
+    STATS_PROBE_ATTRIBUTES,
+
+    /** @brief Timestamps and size of the find data. */
+    STATS_PROBE_TIMESTAMPS,
+
+    /** @brief Access check of the current user. */
+    STATS_PROBE_PERMISSIONS,
+
+    /** @brief Owner and domain lookup. */
+    STATS_PROBE_OWNER,
+
+    /** @brief Icon and color of the extension. */
+    STATS_PROBE_METADATA,
+
+    /** @brief Target of the symbolic links. */
+    STATS_PROBE_LINK,
+
+    /** @brief Volume and file index of the directories. */
+    STATS_PROBE_IDENTITY,
+
+    /** @brief Number of probes. */
+    STATS_PROBE_COUNT
+} stats_probe_e;
+
+/**
+ * @brief Start point of a measure, see 'StartStatsTimer'.
+ *
+ * 'ticks'  : performance counter, 0 if the statistics are disabled
+ * 'cycles' : cycles run by the thread (only with the performance counters)
+ * 'faults' : page faults of the process (only with the performance counters)
+ */
+typedef struct stats_timer_t
+{
+    unsigned long long ticks, cycles;
+    size_t faults;
+} stats_timer_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Enable the collection of the statistics and print them at the end,
+ * until it (or 'OpenStatsTrace') is called all the functions of this module
+ * return without doing anything.
+ */
+void EnableStats();
+
+/**
+ * @brief Enable the collection of the statistics and write each phase of each
+ * directory as a Chrome trace event (chrome://tracing, ui.perfetto.dev).
+ *
+ * @param path      path of the JSON file to write
+ * @return BOOL     TRUE if the file can be created, FALSE otherwise
+ */
+BOOL OpenStatsTrace(const char *path);
+
+/**
+ * @brief Enable the collection of the statistics with the hardware counters
+ * of each phase and print them at the end. The cycles of the thread and the
+ * page faults are measured, the counters that need the performance
+ * monitoring unit (instructions, cache and branch misses) are not available
+ * to user mode on Windows and are reported as not available.
+ *
+ * @return BOOL     TRUE if the thread cycles can be read, FALSE otherwise
+ */
+BOOL EnablePerfCounters();
+
+/**
+ * @brief Finish the trace events and close the file.
+ */
+void CloseStatsTrace();
+
+/**
+ * @brief Start the work of a directory, the phases until 'EndStatsDirectory'
+ * belong to it.
+ *
+ * @param path              path of the directory, valid until 'EndStatsDirectory'
+ * @return stats_timer_t    start of the directory
+ */
+stats_timer_t BeginStatsDirectory(const char *path);
+
+/**
+ * @brief End the work of a directory. With trace enabled a span is written
+ * with the time of each probe and the number of assets.
+ *
+ * @param start     value returned by 'BeginStatsDirectory'
+ * @param assets    number of listed assets
+ */
+void EndStatsDirectory(stats_timer_t start, size_t assets);
+
+/**
+ * @brief Start measuring a phase or a probe.
+ *
+ * @return stats_timer_t    start of the measure
+ */
+stats_timer_t StartStatsTimer();
+
+/**
+ * @brief Stop measuring a phase, the time is added to the phase total. With
+ * trace enabled a span of the phase is written.
+ *
+ * @param phase     phase that was measured
+ * @param start     value returned by 'StartStatsTimer'
+ */
+void StopStatsPhase(stats_phase_e phase, stats_timer_t start);
+
+/**
+ * @brief Stop measuring a probe, the time is added to the probe total and
+ * to the probe phase (except for 'STATS_PROBE_FIND').
+ *
+ * @param probe     probe that was measured
+ * @param start     value returned by 'StartStatsTimer'
+ */
+void StopStatsProbe(stats_probe_e probe, stats_timer_t start);
+
+/**
+ * @brief Count the system calls done by a probe. It is called right after
+ * each call that enters the kernel, the closes of the handles included, the
+ * frees of the buffers returned by the system are not counted.
+ *
+ * @param probe     probe doing the calls
+ * @param calls     number of system calls
+ * @param opens     number of them that open a file or directory
+ */
+void CountStatsCalls(stats_probe_e probe, size_t calls, size_t opens);
+
+/**
+ * @brief Count the memory of the arenas (see 'arena.h').
+ *
+ * @param allocated     bytes allocated
+ * @param freed         bytes freed
+ */
+void CountStatsMemory(size_t allocated, size_t freed);
+
+/**
+ * @brief Print the statistics to stderr: time of each phase, calls and
+ * opens of each probe, arena memory and peak memory of the process.
+ * With the performance counters enabled the counters of each phase too.
+ */
+void PrintStats();
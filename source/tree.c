@@ -0,0 +1,196 @@
+#include "tree.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "directory.h"
+#include "screen.h"
+#include "glob.h"
+
+#define TREE_PREFIX_SIZE (MAX_PATH * 8) // bytes of the branches of the parents, up to 6 per level
+
+/**
+ * @brief State of a directory on the current path of the tree.
+ *
+ * 'it'         : enumeration of the directory
+ * 'asset'      : asset waiting to be printed until the next one is found
+ * 'name'       : copy of the name of the asset, the iterator reuses its buffers
+ * 'path'       : copy of the path of the asset
+ * 'link'       : copy of the target of the asset if it is a link
+ */
+typedef struct tree_level_t
+{
+    directory_iterator_t it;
+    asset_t asset;
+
+    char name[MAX_PATH];
+    char path[MAX_PATH];
+    char link[MAX_PATH];
+} tree_level_t;
+
+/**
+ * @brief Number of assets printed, shown after the tree.
+ */
+typedef struct tree_summary_t
+{
+    size_t directories, documents;
+} tree_summary_t;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Keep an asset of the iterator until the next one is found, its
+ * strings are copied to the buffers of the level.
+ *
+ * @param level     state of the directory
+ * @param asset     asset returned by the iterator
+ */
+local_function void HoldTreeAsset(tree_level_t *level, const asset_t *asset)
+{
+    level->asset = *asset;
+
+    strcpy_s(level->name, MAX_PATH, asset->name);
+    strcpy_s(level->path, MAX_PATH, asset->path);
+    level->asset.name = level->name;
+    level->asset.path = level->path;
+
+    if (asset->link != NULL)
+    {
+        strcpy_s(level->link, MAX_PATH, asset->link);
+        level->asset.link = level->link;
+    }
+}
+
+/**
+ * @brief Check if the tree goes down into a directory.
+ *
+ * @param asset         the asset
+ * @param dir           directory that contains the asset
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if its assets are printed, FALSE otherwise
+ */
+local_function BOOL ShouldTreeRecurse(const asset_t *asset, const directory_list_t *dir, const arguments_t *arguments)
+{
+    if (!asset->type.directory || asset->type.symlink) return FALSE;
+    if (strcmp(asset->name, ".") == 0 || strcmp(asset->name, "..") == 0) return FALSE;
+    if (dir->depth >= arguments->maxDepth) return FALSE;
+
+    for (size_t i = 0; i < arguments->numPrune; ++i)
+    {
+        if (MatchPattern(arguments->prune[i], asset->name)) return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Print the assets of a directory and, right after each of its sub-
+ * directories, their own assets.
+ *
+ * @param dir           directory to print
+ * @param arguments     pointer to the parsed arguments structure
+ * @param prefix        branches of the parents, it is extended in-place
+ * @param prefixLength  length of the prefix
+ * @param summary       pointer to the number of assets printed
+ * @param root          print the path of the directory first, it is the root of the tree
+ * @return BOOL         TRUE if the directory can be listed, FALSE otherwise
+ */
+local_function BOOL PrintTreeLevel(directory_list_t *dir, arguments_t *arguments, char *prefix, size_t prefixLength, tree_summary_t *summary, BOOL root)
+{
+    // NOTE(Andrei): The levels are on the heap, a deep tree would use
+    //               a few KB of stack per directory otherwise.
+    tree_level_t *level = malloc(sizeof(tree_level_t));
+    if (level == NULL) return FALSE;
+
+    if (!OpenDirectoryIterator(&level->it, dir, arguments))
+    {
+        CHECK_DELETE(level);
+        return FALSE;
+    }
+
+    if (root) color_printf(BLUE, "%s\n", dir->path);
+
+    BOOL held = FALSE;
+    asset_t next;
+
+    for (;;)
+    {
+        BOOL found = NextDirectoryAsset(&level->it, arguments, &next);
+        if (!held && !found) break;
+
+        if (held)
+        {
+            const asset_t *asset = &level->asset;
+            PrintAssetTreeRow(asset, prefix, !found, arguments);
+
+            if (asset->type.directory) summary->directories++;
+            else summary->documents++;
+
+            const char *branch = !found ? "    " : u8"\u2502   ";
+            size_t branchLength = strlen(branch);
+            size_t pathSize = strlen(asset->path) + 1;
+
+            if (ShouldTreeRecurse(asset, dir, arguments) && prefixLength + branchLength < TREE_PREFIX_SIZE)
+            {
+                directory_list_t *child = malloc(sizeof(directory_list_t) + pathSize + 1);
+
+                if (child != NULL)
+                {
+                    memcpy(child->path, asset->path, pathSize);
+                    child->path[pathSize] = '\0';
+
+                    child->pattern = child->path + pathSize;
+                    child->next = NULL;
+                    child->depth = dir->depth + 1;
+                    child->volume = dir->volume;
+
+                    memcpy(prefix + prefixLength, branch, branchLength + 1);
+                    PrintTreeLevel(child, arguments, prefix, prefixLength + branchLength, summary, FALSE);
+                    prefix[prefixLength] = '\0';
+
+                    CHECK_DELETE(child);
+                }
+            }
+        }
+
+        if (!found) break;
+
+        HoldTreeAsset(level, &next);
+        held = TRUE;
+    }
+
+    CloseDirectoryIterator(&level->it);
+    CHECK_DELETE(level);
+
+    return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BOOL PrintDirectoryTree(directory_list_t *dir, arguments_t *arguments)
+{
+    tree_summary_t summary = { 0 };
+    char *prefix = malloc(TREE_PREFIX_SIZE);
+
+    if (prefix == NULL) return FALSE;
+    prefix[0] = '\0';
+
+    // NOTE(Andrei): The sub-directories are walked by the tree, the list
+    //               of directories to list must not get them too.
+    BOOL recursive = arguments->recursiveList;
+    arguments->recursiveList = FALSE;
+
+    SetColorOutput(arguments->colors);
+    BOOL retValue = PrintTreeLevel(dir, arguments, prefix, 0, &summary, TRUE);
+    arguments->recursiveList = recursive;
+
+    if (retValue)
+    {
+        printf_s("\n%zu directories, %zu documents", summary.directories, summary.documents);
+    }
+
+    CHECK_DELETE(prefix);
+    return retValue;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Print a directory and its sub-directories as a tree ('-T'), with the
+ * branches drawn with box drawing characters and the icons and colors of
+ * the assets.
+ *
+ * The tree is walked depth first while it is printed, each row is printed
+ * as soon as the next asset of its directory tells if it is the last one.
+ * Only the iterator and the last asset of each directory on the current
+ * path are kept, the memory grows with the depth and not with the size of
+ * the tree. The assets are in enumeration order, they are not sorted.
+ *
+ * The links are not followed, '--max-depth' and '--prune' limit the
+ * directories that are walked.
+ *
+ * @param dir           root of the tree
+ * @param arguments     pointer to the parsed arguments structure
+ * @return BOOL         TRUE if the root can be listed, FALSE otherwise
+ */
+BOOL PrintDirectoryTree(directory_list_t *dir, arguments_t *arguments);
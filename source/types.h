@@ -4,13 +4,23 @@
 #include <Windows.h>
 
 #define STARTUP_CONTAINER_SIZE  128  // startup capacity of the list container
+#define STREAM_WINDOW_SIZE      256  // assets read before the first streamed row
+#define DIRECTORY_RECORDS_SIZE  (64 * 1024) // bytes of directory records read per call
 
 #define PATH_SIZE MAX_PATH          // number of characters used for the path
-#define DATE_SIZE       32          // number of characters used for the date
+#define DATE_SIZE       64          // number of characters used for the date
+#define SIZE_TEXT_SIZE  32          // number of characters used for the size
 
 #define DOMAIN_SIZE 32              // number of characters used for the user domain (group)
 #define OWNER_SIZE  32              // number of characters used for the user name (owner)
 
+#define MAX_PRUNE_PATTERNS 32       // maximum number of '--prune' patterns
+#define MAX_CONTENT_THREADS 16      // maximum number of threads reading the contents
+#define MAX_ROOT_THREADS    16      // maximum number of roots listed at the same time
+#define ROOT_WINDOW_SIZE    32      // roots listed ahead of the one being printed
+#define PIPELINE_RING_SIZE  8       // directories of '-R' enumerated ahead of the one being printed
+#define PIPELINE_OUTPUT_SIZE (64 * 1024) // bytes of the output buffer of '-R' without colors
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /** @brief Check if pointer is not NULL, free it and assign NULL to it. */
@@ -63,6 +73,21 @@ typedef enum sort_by_e
     SORT_BY_LAST_ACCESSED
 } sort_by_e;
 
+/**
+ * @brief Enumerator indicating how the size of the assets is shown.
+ */
+typedef enum size_format_e
+{
+    /** @brief Powers of 1024 with two decimals (1.50K). */
+    SIZE_FORMAT_HUMAN,
+
+    /** @brief Powers of 1000 with two decimals (1.54k). */
+    SIZE_FORMAT_SI,
+
+    /** @brief Exact number of bytes. */
+    SIZE_FORMAT_BYTES
+} size_format_e;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 
@@ -145,6 +170,36 @@ typedef struct timestamp_t
     unsigned long long modification;
 } timestamp_t;
 
+/**
+ * @brief Unique identity of a file or directory, the same asset reached
+ * through different paths (links, mount points) has the same identity.
+ */
+typedef struct file_identity_t
+{
+    /** @brief Serial number of the volume. */
+    DWORD volume;
+
+    /** @brief Index of the file inside the volume. */
+    unsigned long long index;
+} file_identity_t;
+
+/**
+ * @brief Information computed from the content of a document, see 'content.h'.
+ *
+ * 'read'       : the content was read, FALSE for directories and unreadable documents
+ * 'checksum'   : XXH64 hash of the content (seed 0)
+ * 'lines'      : number of '\n' characters
+ * 'mime'       : MIME type detected from the leading bytes
+ */
+typedef struct content_info_t
+{
+    BOOL read;
+
+    unsigned long long checksum;
+    size_t lines;
+    const char *mime;
+} content_info_t;
+
 /**
  * @brief It contains the main information of an asset.
  * By asset we understand document or directory.
@@ -152,15 +207,18 @@ typedef struct timestamp_t
  * 'accessRights'   : see 'access_rights_t' structure
  * 'type'           : see 'asset_type_t' structure
  *
- * 'timestamp'      : FILETIME timestamp, creation, modification, based on sorting (by default creation)
+ * 'timestamp'      : FILETIME timestamps (creation, access and modification)
  * 'size'           : size in bytes (only for files, directory don't have size)
+ * 'content'        : checksum, lines and MIME type, only with the content columns
+ * 'gitStatus'      : two letters of 'git status --short', empty outside a repository (see 'git.h')
  *
- * 'date'           : creation | accessed | modified date, based on sorting (by default creation)
  * 'name'           : name of the asset
  *
- * 'link'           : only for symlinks, contains the real path
+ * 'link'           : only for symlinks, contains the real path (NULL otherwise)
  * 'path'           : full path to the asset
  *
+ * The strings are allocated on the arena of the directory listing.
+ *
  * 'domain'         : domain of the asset owner
  * 'owner'          : owner of the asset
  */
@@ -173,41 +231,66 @@ typedef struct asset_t
 
     timestamp_t timestamp;
     size_t size;
+    content_info_t content;
 
-    char date[DATE_SIZE];
-    char name[PATH_SIZE];
-    char link[PATH_SIZE];
-    char path[PATH_SIZE];
+    const char *name;
+    const char *link;
+    const char *path;
 
     char domain[DOMAIN_SIZE];
     char owner[OWNER_SIZE];
+    char gitStatus[3];
 } asset_t;
 
+/**
+ * @brief Bump pointer allocator, see 'arena.h'.
+ */
+typedef struct arena_t arena_t;
+
 /**
  * @brief Data structure containing a list of assets inside a directory.
  *
  * 'capacity'   : amount of space available on the 'data' array
  * 'size'       : number of elements on the 'data' array
+ * 'arena'      : arena where the directory and its strings are allocated
  * 'data'       : array with asset information
  */
 typedef struct directory_t
 {
     size_t size, capacity;
+    arena_t *arena;
     asset_t data[0];
 } directory_t;
 
 /**
  * @brief Linked list that contains the directories to list.
  *
- * 'next'   pointer to the next directory to list
- * 'path'   current directory path to list
+ * 'next'       pointer to the next directory to list
+ * 'depth'      number of directories below the listed root (root is 0)
+ * 'volume'     serial number of the root volume, only with '--one-file-system'
+ *
+ * 'pattern'    glob pattern still to match relative to 'path', empty if none
+ * 'path'       current directory path to list
+ *
+ * The path and the pattern are stored after the node, in the same
+ * allocation, with the exact size they need.
  */
 typedef struct directory_list_t
 {
     struct directory_list_t *next;
-    char path[MAX_PATH];
+
+    size_t depth;
+    DWORD volume;
+
+    const char *pattern;
+    char path[0];
 } directory_list_t;
 
+/**
+ * @brief Compiled filter expression ('--where'), see 'filter.h'.
+ */
+typedef struct filter_t filter_t;
+
 /**
  * @brief Contais information of the user input arguments.
  *
@@ -217,6 +300,7 @@ typedef struct directory_list_t
  *
  * 'reverseOrder'           : '-r', '--reverse'     reverse the sort order
  * 'recursiveList'          : '-R', '--recursive'   recursive list folders
+ * 'showTree'               : '-T', '--tree'        show the directories as a tree, printed while they are walked
  *
  * 'colors'                 :       '--colors'      colorize the output
  * 'showIcons'              :       '--icons'       show icons related to the asset
@@ -227,6 +311,29 @@ typedef struct directory_list_t
  * 'showMetaData'           :       '--smd'         display colors, icons and the file extensions
  * 'virtualTerminal'        :       '--virterm'     use virtual terminal for better color display
  *
+ * 'filter'                 :       '--where'       only list the assets matching the expression
+ * 'timeStyle'              :       '--time-style'  format of the dates, NULL for the default one
+ * 'sizeFormat'             :       '--si', '--bytes' show the sizes in powers of 1000 or in bytes
+ * 'streamLongFormat'       :       '--stream'      print the long format rows as they are found, unsorted
+ * 'runDaemon'              :       '--daemon'      serve the directory snapshots to the other instances
+ * 'noDaemon'               :       '--no-daemon'   do not ask the daemon, list the directories in process
+ * 'showChecksum'           :       '--checksum'    show the XXH64 hash of the documents on the long format
+ * 'showLines'              :       '--lines'       show the number of lines of the documents on the long format
+ * 'showMime'               :       '--mime'        show the MIME type of the documents on the long format
+ * 'showGit'                :       '--git'         show the git status of the assets on the long format
+ * 'findDuplicates'         :       '--duplicates'  print the groups of documents with the same content instead of the listing
+ * 'countOnly'              :       '--count'       print the number of documents, directories and links of each tree
+ * 'countByDir'             :       '--by-dir'      with '--count' print the totals of each directory
+ * 'showStats'              :       '--stats'       print the time of each phase and the system calls to stderr
+ * 'traceFile'              :       '--trace'       write the phases of each directory as Chrome trace events
+ * 'perfCounters'           :       '--perf-counters' print the cycles and page faults of each phase to stderr
+ *
+ * 'maxDepth'               :       '--max-depth'   maximum depth of the recursion
+ * 'oneFileSystem'          : '-x', '--one-file-system' do not recurse into other volumes
+ * 'followLinks'            : '-L', '--dereference' recurse into symbolic links and junctions
+ * 'prune', 'numPrune'      :       '--prune'       do not recurse into the directories matching the patterns
+ * 'depthFirst'             :       '--depth-first' list the sub-directories before the siblings (GNU ls -R order)
+ *
  * 'sortField'              :                       which field is used to sort (name, size, owner, group, etc)
  * 'currentDir', 'lastDir'  :                       linked list of the directories to list
  */
@@ -247,6 +354,9 @@ typedef struct arguments_t
     /** @brief List current directory and the subdirectories. */
     BOOL recursiveList;
 
+    /** @brief Show the directories as a tree. */
+    BOOL showTree;
+
     /** @brief Colorieze the output. */
     BOOL colors;
 
@@ -265,11 +375,78 @@ typedef struct arguments_t
     /** @brief Use virtual terminal for better color output. */
     BOOL virtualTerminal;
 
+    /** @brief Print the time of each phase and the system calls to stderr. */
+    BOOL showStats;
+
+    /** @brief File where the Chrome trace events are written, NULL disables it. */
+    const char *traceFile;
+
+    /** @brief Print the hardware counters of each phase to stderr. */
+    BOOL perfCounters;
+
+    /** @brief Only list the assets matching the expression, NULL lists all. */
+    filter_t *filter;
+
+    /** @brief Format of the dates (iso, long-iso, full, +FORMAT), NULL for the default one. */
+    const char *timeStyle;
+
+    /** @brief How the size of the assets is shown (human, SI or bytes). */
+    size_format_e sizeFormat;
+
+    /** @brief Print the long format rows as they are found, without sorting. */
+    BOOL streamLongFormat;
+
+    /** @brief Run as the daemon serving the directory snapshots. */
+    BOOL runDaemon;
+
+    /** @brief Do not ask the daemon for the directory snapshots. */
+    BOOL noDaemon;
+
+    /** @brief Show the hash of the documents content. */
+    BOOL showChecksum;
+
+    /** @brief Show the number of lines of the documents. */
+    BOOL showLines;
+
+    /** @brief Show the MIME type of the documents. */
+    BOOL showMime;
+
+    /** @brief Show the git status of the assets. */
+    BOOL showGit;
+
+    /** @brief Print the documents with the same content instead of the listing. */
+    BOOL findDuplicates;
+
+    /** @brief Print the number of assets of each tree instead of the listing. */
+    BOOL countOnly;
+
+    /** @brief Print the number of assets of each directory. */
+    BOOL countByDir;
+
+    /** @brief Maximum depth of the recursion (root is 0). */
+    size_t maxDepth;
+
+    /** @brief Do not recurse into directories of other volumes. */
+    BOOL oneFileSystem;
+
+    /** @brief Recurse into symbolic links and junctions. */
+    BOOL followLinks;
+
+    /** @brief Patterns of the directory names that are not recursed. */
+    const char *prune[MAX_PRUNE_PATTERNS];
+    size_t numPrune;
+
     /** @brief Which field is used for sorting (name, size, owner, etc). */
     sort_by_e sortField;
 
+    /** @brief List the sub-directories of a directory before its siblings. */
+    BOOL depthFirst;
+
     /** @brief Linked list of the directories to list. */
     directory_list_t *headDir, *tailDir;
+
+    /** @brief Node after which the new directories are inserted, NULL appends them. */
+    directory_list_t *insertDir;
 } arguments_t;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 /**
@@ -54,9 +55,27 @@ void ShowHelp()
             "DISPLAY OPTION\n"
             "  -l, --long                       display extended file metadata as a table\n"
             "  -R, --recursive                  recurse into directories\n"
+            "  -T, --tree                       show the directories as a tree while they are walked (unsorted)\n"
+            "  -x, --one-file-system            do not recurse into directories of other volumes\n"
+            "  -L, --dereference                recurse into symbolic links and junctions\n"
+            "      --max-depth [N]              recurse at most N levels below the directory\n"
+            "      --prune [NAME]               do not recurse into directories matching the name\n"
+            "      --depth-first                recurse into each directory before its siblings (GNU ls -R order)\n"
+            "      --checksum                   with -l show the XXH64 hash of the documents\n"
+            "      --lines                      with -l show the number of lines of the documents\n"
+            "      --mime                       with -l show the MIME type detected from the content\n"
+            "      --git                        with -l show the git status of the assets (git status --short)\n"
+            "      --duplicates                 print the groups of documents with the same content (recursive)\n"
+            "      --count                      print the number of documents, directories and links of each tree\n"
+            "      --by-dir                     like --count with the totals of each directory, as du does\n"
             "      --icons                      show icons associated to file/folder\n"
             "      --colors                     colorize the output\n"
-            "      --virterm                    use virtual terminal for better colors\n\n";
+            "      --virterm                    use virtual terminal for better colors\n"
+            "      --stats                      print the time of each phase and the system calls to stderr\n"
+            "      --trace [FILE]               write the phases of each directory as Chrome trace events\n"
+            "      --perf-counters              print the cycles and page faults of each phase to stderr\n"
+            "      --daemon                     keep the directories warm and serve them to the other ls\n"
+            "      --no-daemon                  list the directories without asking the daemon\n\n";
 
         printf_s("%s", help);
     }
@@ -68,6 +87,11 @@ void ShowHelp()
             "  -A, --almost-all                 show all files avoiding '.' and '..'\n"
             "  -r, --reverse                    reverse the sort order\n"
             "      --sort [FIELD]               which field to sort by\n"
+            "      --where [EXPR]               only list the assets matching the expression\n"
+            "      --time-style [STYLE]         format of the dates: iso, long-iso, full or +FORMAT\n"
+            "      --si                         show the sizes in powers of 1000 instead of 1024\n"
+            "      --bytes                      show the exact sizes in bytes\n"
+            "      --stream                     with -l print the rows as they are found, unsorted\n"
             "      --group-directories-first    list directories before other files\n\n";
 
         printf_s("%s", help);
@@ -78,12 +102,64 @@ void ShowHelp()
             "TIPS\n"
             "  pattern      Specifies the search pattern for the files to match\n"
             "               Wildcards * and ? can be used in the pattern.\n"
-            "               ex: ls -l C:\\Windows\\System32\\*.dll\n\n"
+            "               ex: ls -l C:\\Windows\\System32\\*.dll\n"
+            "               Use ** to match any number of directories, with -R\n"
+            "               the pattern is applied to all the sub-directories.\n"
+            "               ex: ls src\\**\\test_*.cpp\n\n"
+
+            "  archives     A path can continue inside a .zip or an uncompressed .tar, its\n"
+            "               members are listed without extracting them. The archive alone\n"
+            "               is listed as a document, add a \\ to list its content.\n"
+            "               ex: ls -lR D:\\builds\\bundle.zip\\bin\\x64\n\n"
 
             "  sort         Valid fields are: NAME, SIZE, OWNER, GROUP,\n"
             "               CREATED, ACCESSED and MODIFIED.\n"
             "               Fields are insensitive case.\n\n"
 
+            "  where        Compare fields with == != < <= > >= and ~ (pattern),\n"
+            "               join them with && || ! and parenthesis.\n"
+            "               Fields: name, ext, type (d, l, f), hidden, size, ctime,\n"
+            "               atime, mtime, owner, group and perms (ex: rw-).\n"
+            "               Sizes accept K, M, G, T, times are relative to now\n"
+            "               with s, m, h, d, w, y (-30d is 30 days ago).\n"
+            "               ex: ls --where \"size > 100M && ext in ('.log', '.tmp')\"\n\n"
+
+            "  time-style   iso is 01-15 10:00 this year and 2022-01-15 older,\n"
+            "               long-iso is 2022-01-15 10:00, full has seconds, nanoseconds\n"
+            "               and time zone. +FORMAT accepts %Y %y %m %d %e %b %H %M %S\n"
+            "               %N %z %F %T %R and %%.\n"
+            "               ex: ls -l --time-style \"+%d/%m/%Y %T\"\n\n"
+
+            "  trace        Open the file with chrome://tracing or https://ui.perfetto.dev,\n"
+            "               each directory has the time of its phases and probes.\n"
+            "               ex: ls -lR --trace ls.json C:\\src\n\n"
+
+            "  content      The documents are read once by a pool of threads (one per\n"
+            "               processor) for all the content columns, the biggest first.\n"
+            "               ex: ls -l --checksum --lines --mime C:\\src\n\n"
+
+            "  git          The status is read from .git\\index, its stat data tells which\n"
+            "               documents changed. Only the documents modified after the index\n"
+            "               are hashed, with core.autocrlf they can show as modified.\n"
+            "               ex: ls -l --git C:\\src\\project\n\n"
+
+            "  duplicates   The documents are grouped by size, then by the hash of their\n"
+            "               first 4 KB and only then by the hash of their content, each\n"
+            "               stage reads only the documents that are not unique yet.\n"
+            "               ex: ls --duplicates --where \"size > 1M\" D:\\backups\n\n"
+
+            "  count        Only the names and the attributes of the enumeration are read,\n"
+            "               no document is opened, the sub-directories are counted by a\n"
+            "               pool of threads. Hidden assets are counted with -a or -A.\n"
+            "               A name pattern and --where (without owner, group and perms)\n"
+            "               only count the matching assets, at any depth as -R.\n"
+            "               ex: ls --count --prune node_modules C:\\src\n\n"
+
+            "  daemon       Run ls --daemon in its own console, the other ls ask it for the\n"
+            "               directories. A directory is read again only after it changes,\n"
+            "               without the daemon each ls lists the directories itself.\n"
+            "               ex: start /min ls --daemon\n\n"
+
             "  icons        To be able to see the icons correctly you have to use the NerdFonts\n"
             "               https://github.com/ryanoasis/nerd-fonts\n"
             "               https://www.nerdfonts.com/";
@@ -94,13 +170,39 @@ void ShowHelp()
 
 void AddDirectoryToList(arguments_t *arguments, const char *path)
 {
-    directory_list_t *dir = malloc(sizeof(directory_list_t));
+    AddPatternToList(arguments, NULL, path, "");
+}
+
+void AddPatternToList(arguments_t *arguments, const directory_list_t *parent, const char *path, const char *pattern)
+{
+    size_t pathSize = strlen(path) + 1;
+    size_t patternSize = strlen(pattern) + 1;
+
+    directory_list_t *dir = malloc(sizeof(directory_list_t) + pathSize + patternSize);
     if (dir == NULL) return;
 
-    strncpy_s(dir->path, MAX_PATH, path, MAX_PATH);
+    memcpy(dir->path, path, pathSize);
+    memcpy(dir->path + pathSize, pattern, patternSize);
+
+    dir->pattern = dir->path + pathSize;
     dir->next = NULL;
 
-    if (arguments->tailDir == NULL)
+    dir->depth = parent ? parent->depth + 1 : 0;
+    dir->volume = parent ? parent->volume : 0;
+
+    // NOTE(Andrei): Depth first the sub-directories go right after the
+    //               directory being listed, in the order they are found,
+    //               so the pending list only holds the siblings of the
+    //               directories on the current path instead of a whole level.
+    if (arguments->insertDir != NULL)
+    {
+        dir->next = arguments->insertDir->next;
+        arguments->insertDir->next = dir;
+
+        if (arguments->tailDir == arguments->insertDir) arguments->tailDir = dir;
+        arguments->insertDir = dir;
+    }
+    else if (arguments->tailDir == NULL)
     {
         arguments->tailDir = dir;
         arguments->headDir = arguments->tailDir;
@@ -120,7 +222,7 @@ const char *GetDirectoryFromPath(const char *path, char *buffer, size_t bufferSi
     {
         char *c = (char *)FindLastDelimiter(buffer, "\\/");
 
-        if (c == NULL) strncpy_s(buffer, bufferSize, GetWorkingDirectory(), bufferSize);
+        if (c == NULL) GetWorkingDirectory(buffer, bufferSize);
         else *c = '\0';
     }
 
@@ -133,36 +235,10 @@ const char *GetDirectoryFromPath(const char *path, char *buffer, size_t bufferSi
     return buffer;
 }
 
-const char *GetFileSizeAsText(size_t bytes)
+const char *GetWorkingDirectory(char *buffer, size_t bufferSize)
 {
-    local_variable char buffer[256];
-    double sz = (double)bytes;
-    char ex = 'B';
-
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'K'; }
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'M'; }
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'G'; }
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'T'; }
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'P'; }
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'E'; }
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'Z'; }
-    if (sz > 1024.0) { sz /= 1024.0; ex = 'Y'; }
-
-    if (sz < 0.01)
-    {
-        sprintf_s(buffer, sizeof(buffer), "        -");
-    }
-    else
-    {
-        sprintf_s(buffer, sizeof(buffer), "% 8.2lf%c", sz, ex);
-    }
+    DWORD length = GetCurrentDirectoryA((DWORD)bufferSize, buffer);
+    if (length == 0 || length >= bufferSize) buffer[0] = '\0';
 
     return buffer;
 }
-
-const char *GetWorkingDirectory()
-{
-    local_variable char workingDir[MAX_PATH] = { 0 };
-    GetCurrentDirectoryA(MAX_PATH, workingDir);
-    return workingDir;
-}
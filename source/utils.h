@@ -2,6 +2,16 @@
 
 #include "types.h"
 
+/**
+ * @brief Find the last character of the string that is one of the delimiters,
+ * each character of the delimiters string is a delimiter.
+ *
+ * @param str           pointer to a valid string
+ * @param delimiters    pointer to a valid list of delimiters
+ * @return const char*  pointer to the character or NULL if not found.
+ */
+const char *FindLastDelimiter(const char *str, const char *delimiters);
+
 /**
  * @brief Prints the help to the screen.
  */
@@ -15,6 +25,18 @@ void ShowHelp();
  */
 void AddDirectoryToList(arguments_t *arguments, const char *path);
 
+/**
+ * @brief Add a new directory to be listed, only the assets matching the glob
+ * pattern will be listed. The pattern is relative to the directory path and
+ * it can use '*', '?' and '**' (any number of directories).
+ *
+ * @param arguments  pointer to the arguments data structure where path will be stored
+ * @param parent     directory where it was found or NULL if it is a root
+ * @param path       the directory path to be stored
+ * @param pattern    the pattern to match relative to the path
+ */
+void AddPatternToList(arguments_t *arguments, const directory_list_t *parent, const char *path, const char *pattern);
+
 /**
  * @brief Given a filename, extract directory from filename.
  * By default it will return the filename if path can not be
@@ -27,24 +49,12 @@ void AddDirectoryToList(arguments_t *arguments, const char *path);
  */
 const char *GetDirectoryFromPath(const char *path, char *buffer, size_t bufferSize);
 
-/**
- * @brief Get a human readable representation for the size,
- * if the size is zero a hyphen it will shown instead,
- * print sizes like 1K / 234M / 2G / etc.
- *
- * This function can not multi-threaded as it has a
- * static member variable to store the file size
- * as string and returns a pointer to it.
- *
- * @param bytes         size of the asset in bytes
- * @return const char*  human readable representation
- */
-const char *GetFileSizeAsText(size_t bytes);
-
 /**
  * @brief The current working directory. The directory has
  * a maximum length of 260 characters (MAX_PATH).
  *
- * @return const char* name of the directory.
+ * @param buffer        buffer where the directory is stored
+ * @param bufferSize    size of the buffer
+ * @return const char*  the buffer, empty if the directory does not fit
  */
-const char *GetWorkingDirectory();
+const char *GetWorkingDirectory(char *buffer, size_t bufferSize);
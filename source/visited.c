@@ -0,0 +1,116 @@
+#include "visited.h"
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define VISITED_STARTUP_CAPACITY 1024  // startup number of slots of the set
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Hash of the directory identity (64-bit mixer of splitmix64).
+ *
+ * @param identity  identity of the directory
+ * @return size_t   the hash
+ */
+local_function size_t HashIdentity(file_identity_t identity)
+{
+    unsigned long long x = identity.index ^ ((unsigned long long)identity.volume << 32);
+
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+    return (size_t)(x ^ (x >> 31));
+}
+
+/**
+ * @brief Find the slot of the identity or the empty slot where it goes.
+ *
+ * @param set               pointer to the set with at least one empty slot
+ * @param identity          identity of the directory
+ * @return file_identity_t* pointer to the slot
+ */
+local_function file_identity_t *FindVisitedSlot(const visited_set_t *set, file_identity_t identity)
+{
+    size_t mask = set->capacity - 1;
+
+    for (size_t i = HashIdentity(identity) & mask;; i = (i + 1) & mask)
+    {
+        file_identity_t *slot = &set->data[i];
+
+        if (slot->volume == identity.volume && slot->index == identity.index)
+        {
+            return slot;
+        }
+
+        if (slot->volume == 0 && slot->index == 0)
+        {
+            return slot;
+        }
+    }
+}
+
+/**
+ * @brief Double the capacity of the set (or allocate it), the load factor
+ * is kept below a half.
+ *
+ * @param set       pointer to the set
+ * @return BOOL     TRUE on success, FALSE otherwise
+ */
+local_function BOOL ResizeVisitedSet(visited_set_t *set)
+{
+    visited_set_t newSet = { 0 };
+
+    newSet.capacity = set->capacity ? set->capacity * 2 : VISITED_STARTUP_CAPACITY;
+    newSet.data = calloc(newSet.capacity, sizeof(file_identity_t));
+
+    if (newSet.data == NULL)
+    {
+        return FALSE;
+    }
+
+    for (size_t i = 0; i < set->capacity; ++i)
+    {
+        if (set->data[i].volume != 0 || set->data[i].index != 0)
+        {
+            *FindVisitedSlot(&newSet, set->data[i]) = set->data[i];
+            ++newSet.size;
+        }
+    }
+
+    CHECK_DELETE(set->data);
+    *set = newSet;
+
+    return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BOOL InsertVisitedDirectory(visited_set_t *set, file_identity_t identity)
+{
+    if ((set->size + 1) * 2 > set->capacity && !ResizeVisitedSet(set))
+    {
+        // NOTE(Andrei): Without memory the cycles can not be detected,
+        //               do not stop the listing because of it.
+        return TRUE;
+    }
+
+    file_identity_t *slot = FindVisitedSlot(set, identity);
+
+    if (slot->volume == identity.volume && slot->index == identity.index)
+    {
+        return FALSE;
+    }
+
+    *slot = identity;
+    ++set->size;
+
+    return TRUE;
+}
+
+void DeleteVisitedSet(visited_set_t *set)
+{
+    CHECK_DELETE(set->data);
+    set->size = set->capacity = 0;
+}
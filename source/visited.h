@@ -0,0 +1,34 @@
+#pragma once
+
+#include "types.h"
+
+/**
+ * @brief Set of the directories already listed, identified by the volume
+ * serial number and the file index. It is an open addressing hash table,
+ * zero initialize it before the first use.
+ *
+ * 'size'       : number of identities stored
+ * 'capacity'   : number of slots of the table (power of 2)
+ * 'data'       : slots of the table, an empty slot is all zeros
+ */
+typedef struct visited_set_t
+{
+    size_t size, capacity;
+    file_identity_t *data;
+} visited_set_t;
+
+/**
+ * @brief Add a directory identity to the set.
+ *
+ * @param set       pointer to the set
+ * @param identity  identity of the directory
+ * @return BOOL     TRUE if it was added, FALSE if it was already in the set
+ */
+BOOL InsertVisitedDirectory(visited_set_t *set, file_identity_t identity);
+
+/**
+ * @brief Release the memory used by the set, it can be used again.
+ *
+ * @param set       pointer to the set
+ */
+void DeleteVisitedSet(visited_set_t *set);
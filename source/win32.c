@@ -1,64 +1,109 @@
 #include "win32.h"
 #include "types.h"
+#include "stats.h"
 
 #include <AccCtrl.h>
 #include <AclAPI.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #pragma comment(lib, "advapi32.lib")
 
-// Check if handle is not NULL, close it and assign NULL to it
-#define CHECK_CLOSE_HANDLE(x) do { if(x) { CloseHandle(x); x = NULL; } } while(0)
+// Check if handle is not NULL, close it, count the close on the probe and assign NULL to it
+// NOTE(Andrei): Each call that enters the kernel is counted right after it,
+//               the closes included. The frees of the buffers returned by
+//               the system (LocalFree) are not, they stay on the heap.
+#define CHECK_CLOSE_COUNTED(probe, x) do { if(x) { CloseHandle(x); CountStatsCalls(probe, 1, 0); x = NULL; } } while(0)
+
+#define OWNER_CACHE_SIZE 1024       // number of owners remembered (power of two)
+
+/**
+ * @brief Owner and domain of a SID, the same few owners are repeated on the
+ * whole listing so the account lookup is done once per owner.
+ *
+ * 'sidLength'  : number of bytes of the SID, 0 if the entry is empty
+ * 'sid'        : the owner SID
+ * 'owner'      : name of the owner
+ * 'domain'     : domain of the owner
+ */
+typedef struct owner_cache_entry_t
+{
+    DWORD sidLength;
+    BYTE sid[SECURITY_MAX_SID_SIZE];
+
+    char owner[OWNER_SIZE];
+    char domain[DOMAIN_SIZE];
+} owner_cache_entry_t;
+
+// NOTE(Andrei): The cache is shared by all the threads of the process
+//               (see 'libls.h'), the lock protects the entries and widths.
+global_variable SRWLOCK g_OwnerCacheLock = SRWLOCK_INIT;
+global_variable owner_cache_entry_t g_OwnerCache[OWNER_CACHE_SIZE];
+global_variable size_t g_OwnerCacheCount = 0;
+
+// Longest owner and domain names of the cache
+global_variable size_t g_OwnerCacheWidth = 0;
+global_variable size_t g_DomainCacheWidth = 0;
 
 ///////////////////////////////////////////////////////////////////////////////
 
-local_function const char *GetLastErrorAsString()
+/**
+ * @brief Find the entry of a SID on the owner cache, open addressing with
+ * linear probing on the FNV-1a hash of the SID bytes.
+ *
+ * @param sid                       valid SID
+ * @return owner_cache_entry_t*     the entry of the SID or the empty entry where
+ *                                  it has to be stored, NULL if the cache is full
+ */
+local_function owner_cache_entry_t *FindOwnerCacheEntry(PSID sid)
 {
+    DWORD length = GetLengthSid(sid);
+    const BYTE *bytes = (const BYTE *)sid;
+    unsigned long long hash = 14695981039346656037ULL;
 
-    DWORD errorMessageID = GetLastError();
-    local_variable char buffer[4096]; buffer[0] = '\0';
-
-    if (errorMessageID == 0)
+    for (DWORD i = 0; i < length; ++i)
     {
-        return "";
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
     }
 
-    FormatMessageA
-    (
-        FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS, NULL,
-        errorMessageID, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-        (LPSTR)&buffer, sizeof(buffer), NULL
-    );
+    for (size_t i = 0; i < OWNER_CACHE_SIZE; ++i)
+    {
+        owner_cache_entry_t *entry = &g_OwnerCache[(hash + i) & (OWNER_CACHE_SIZE - 1)];
+
+        if (entry->sidLength == 0)
+        {
+            // NOTE(Andrei): Keep some entries empty so the probing is short.
+            return g_OwnerCacheCount < OWNER_CACHE_SIZE / 4 * 3 ? entry : NULL;
+        }
+
+        if (entry->sidLength == length && memcmp(entry->sid, bytes, length) == 0)
+        {
+            return entry;
+        }
+    }
 
-    return buffer;
+    return NULL;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-
-void GetPermissions(const char *path, asset_t *asset)
+/**
+ * @brief Check the READ, WRITE and EXECUTION permissions of the current user
+ * on a security descriptor, see 'GetPermissions'.
+ *
+ * @param security  security descriptor with the owner, group and DACL
+ * @param asset     pointer of the asset data structure where information is stored
+ */
+local_function void CheckAccessRights(PSECURITY_DESCRIPTOR security, asset_t *asset)
 {
-    PSECURITY_DESCRIPTOR security = NULL;
-    DWORD length = 0, genericAccessRights = 0;
+    DWORD genericAccessRights = 0;
     HANDLE hToken = NULL, hImpersonatedToken = NULL;
 
-    asset->accessRights.read = FALSE;
-    asset->accessRights.write = FALSE;
-    asset->accessRights.execution = FALSE;
-
-    BOOL oK = GetFileSecurityA(path, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION, NULL, 0, &length);
-    if (oK) goto clean_up;
-
-    if (ERROR_INSUFFICIENT_BUFFER == GetLastError()) security = malloc(length);
-    if (!security) goto clean_up;
-
-    oK = GetFileSecurityA(path, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION, security, length, &length);
-    if (!oK) goto clean_up;
-
-    oK = OpenProcessToken(GetCurrentProcess(), TOKEN_IMPERSONATE | TOKEN_QUERY | TOKEN_DUPLICATE | STANDARD_RIGHTS_READ, &hToken);
+    BOOL oK = OpenProcessToken(GetCurrentProcess(), TOKEN_IMPERSONATE | TOKEN_QUERY | TOKEN_DUPLICATE | STANDARD_RIGHTS_READ, &hToken);
+    CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 0);
     if (!oK) goto clean_up;
 
     oK = DuplicateToken(hToken, SecurityImpersonation, &hImpersonatedToken);
+    CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 0);
     if (!oK) goto clean_up;
 
     GENERIC_MAPPING mapping = { 0xFFFFFFFF };
@@ -77,6 +122,7 @@ void GetPermissions(const char *path, asset_t *asset)
         MapGenericMask(&genericAccessRights, &mapping);
 
         AccessCheck(security, hImpersonatedToken, genericAccessRights, &mapping, &privileges, &privilegesLength, &grantedAccess, &result);
+        CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 0);
         asset->accessRights.read = result == TRUE;
     }
 
@@ -85,6 +131,7 @@ void GetPermissions(const char *path, asset_t *asset)
         MapGenericMask(&genericAccessRights, &mapping);
 
         AccessCheck(security, hImpersonatedToken, genericAccessRights, &mapping, &privileges, &privilegesLength, &grantedAccess, &result);
+        CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 0);
         asset->accessRights.write = result == TRUE;
     }
 
@@ -93,46 +140,215 @@ void GetPermissions(const char *path, asset_t *asset)
         MapGenericMask(&genericAccessRights, &mapping);
 
         AccessCheck(security, hImpersonatedToken, genericAccessRights, &mapping, &privileges, &privilegesLength, &grantedAccess, &result);
+        CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 0);
         asset->accessRights.execution = result == TRUE;
     }
 
+    clean_up:
+    CHECK_CLOSE_COUNTED(STATS_PROBE_PERMISSIONS, hToken);
+    CHECK_CLOSE_COUNTED(STATS_PROBE_PERMISSIONS, hImpersonatedToken);
+}
+
+/**
+ * @brief Get the owner and the domain of a SID, the names are looked up once
+ * and kept on the owner cache, see 'GetOwnerAndDomain'.
+ *
+ * @param pSidOwner     valid owner SID
+ * @param asset         pointer of the asset data structure where information is stored
+ * @return BOOL         TRUE if owner and domain can be retrieved, FALSE otherwise
+ */
+local_function BOOL LookupOwnerAndDomain(PSID pSidOwner, asset_t *asset)
+{
+    BOOL result = FALSE;
+
+    AcquireSRWLockShared(&g_OwnerCacheLock);
+    owner_cache_entry_t *entry = FindOwnerCacheEntry(pSidOwner);
+
+    if (entry != NULL && entry->sidLength != 0)
+    {
+        strcpy_s(asset->owner, OWNER_SIZE, entry->owner);
+        strcpy_s(asset->domain, DOMAIN_SIZE, entry->domain);
+        result = TRUE;
+    }
+
+    ReleaseSRWLockShared(&g_OwnerCacheLock);
+    if (result) return TRUE;
+
+    SID_NAME_USE eUse = SidTypeUnknown; DWORD ownerSize = OWNER_SIZE, domainSize = DOMAIN_SIZE;
+    result = LookupAccountSidA(NULL, pSidOwner, asset->owner, (LPDWORD)&ownerSize, asset->domain, (LPDWORD)&domainSize, &eUse);
+    CountStatsCalls(STATS_PROBE_OWNER, 1, 0);
+
+    // NOTE(Andrei): The failed lookups are not cached, the owner could be
+    //               a domain account that can not be resolved right now.
+    AcquireSRWLockExclusive(&g_OwnerCacheLock);
+
+    // NOTE(Andrei): Another thread could have stored it meanwhile.
+    if (result) entry = FindOwnerCacheEntry(pSidOwner);
+
+    if (result && entry != NULL && entry->sidLength == 0)
+    {
+        entry->sidLength = GetLengthSid(pSidOwner);
+        memcpy(entry->sid, pSidOwner, entry->sidLength);
+
+        strcpy_s(entry->owner, OWNER_SIZE, asset->owner);
+        strcpy_s(entry->domain, DOMAIN_SIZE, asset->domain);
+        ++g_OwnerCacheCount;
+
+        size_t s = strlen(entry->owner);
+        g_OwnerCacheWidth = g_OwnerCacheWidth < s ? s : g_OwnerCacheWidth;
+
+        s = strlen(entry->domain);
+        g_DomainCacheWidth = g_DomainCacheWidth < s ? s : g_DomainCacheWidth;
+    }
+
+    ReleaseSRWLockExclusive(&g_OwnerCacheLock);
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char *GetLastErrorAsString(char *buffer, size_t bufferSize)
+{
+    DWORD errorMessageID = GetLastError();
+    buffer[0] = '\0';
+
+    if (errorMessageID == 0)
+    {
+        return buffer;
+    }
+
+    DWORD length = FormatMessageA
+    (
+        FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS, NULL,
+        errorMessageID, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+        buffer, (DWORD)bufferSize, NULL
+    );
+
+    // NOTE(Andrei): The system messages end with a new line.
+    while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r'))
+    {
+        buffer[--length] = '\0';
+    }
+
+    return buffer;
+}
+
+void GetPermissions(const char *path, asset_t *asset)
+{
+    PSECURITY_DESCRIPTOR security = NULL;
+    DWORD length = 0;
+
+    asset->accessRights.read = FALSE;
+    asset->accessRights.write = FALSE;
+    asset->accessRights.execution = FALSE;
+
+    BOOL oK = GetFileSecurityA(path, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION, NULL, 0, &length);
+    CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 1);
+    if (oK) goto clean_up;
+
+    if (ERROR_INSUFFICIENT_BUFFER == GetLastError()) security = malloc(length);
+    if (!security) goto clean_up;
+
+    oK = GetFileSecurityA(path, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION, security, length, &length);
+    CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 1);
+    if (!oK) goto clean_up;
+
+    CheckAccessRights(security, asset);
+
     clean_up:
     CHECK_DELETE(security);
-    CHECK_CLOSE_HANDLE(hToken);
-    CHECK_CLOSE_HANDLE(hImpersonatedToken);
+}
+
+void GetPermissionsByHandle(HANDLE hFile, asset_t *asset)
+{
+    PSECURITY_DESCRIPTOR security = NULL;
+
+    asset->accessRights.read = FALSE;
+    asset->accessRights.write = FALSE;
+    asset->accessRights.execution = FALSE;
+
+    if (hFile == INVALID_HANDLE_VALUE) return;
+
+    DWORD dwRtnCode = GetSecurityInfo(hFile, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION, NULL, NULL, NULL, NULL, &security);
+    CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 0);
+
+    if (dwRtnCode == ERROR_SUCCESS && security != NULL)
+    {
+        CheckAccessRights(security, asset);
+    }
+
+    if (security != NULL) LocalFree(security);
 }
 
 BOOL GetOwnerAndDomain(const char *path, asset_t *asset)
+{
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    CountStatsCalls(STATS_PROBE_OWNER, 1, 1);
+
+    BOOL result = GetOwnerAndDomainByHandle(hFile, asset);
+    if (hFile != INVALID_HANDLE_VALUE) CHECK_CLOSE_COUNTED(STATS_PROBE_OWNER, hFile);
+
+    return result;
+}
+
+BOOL GetOwnerAndDomainByHandle(HANDLE hFile, asset_t *asset)
 {
     PSID pSidOwner = NULL;
     PSECURITY_DESCRIPTOR pSD = NULL;
+    BOOL result = FALSE;
 
     strcpy_s(asset->owner, OWNER_SIZE, "-");
     strcpy_s(asset->domain, DOMAIN_SIZE, "-");
 
-    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) { GetLastErrorAsString(); return FALSE; }
+    if (hFile == INVALID_HANDLE_VALUE) return FALSE;
 
     DWORD dwRtnCode = GetSecurityInfo(hFile, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION, &pSidOwner, NULL, NULL, NULL, &pSD);
-    if (dwRtnCode != ERROR_SUCCESS || pSidOwner == NULL) { GetLastErrorAsString(); CHECK_CLOSE_HANDLE(hFile); return FALSE; }
+    CountStatsCalls(STATS_PROBE_OWNER, 1, 0);
 
-    SID_NAME_USE eUse = SidTypeUnknown; DWORD ownerSize = OWNER_SIZE, domainSize = DOMAIN_SIZE;
-    BOOL result = LookupAccountSidA(NULL, pSidOwner, asset->owner, (LPDWORD)&ownerSize, asset->domain, (LPDWORD)&domainSize, &eUse);
+    if (dwRtnCode == ERROR_SUCCESS && pSidOwner != NULL && IsValidSid(pSidOwner))
+    {
+        result = LookupOwnerAndDomain(pSidOwner, asset);
+    }
 
-    CHECK_CLOSE_HANDLE(hFile);
+    if (pSD != NULL) LocalFree(pSD);
     return result;
 }
 
+HANDLE OpenAssetById(HANDLE directory, LARGE_INTEGER id)
+{
+    FILE_ID_DESCRIPTOR descriptor = { 0 };
+
+    descriptor.dwSize = sizeof(descriptor);
+    descriptor.Type = FileIdType;
+    descriptor.FileId = id;
+
+    HANDLE hFile = OpenFileById(directory, &descriptor, READ_CONTROL, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, FILE_FLAG_BACKUP_SEMANTICS);
+    CountStatsCalls(STATS_PROBE_PERMISSIONS, 1, 1);
+
+    return hFile;
+}
 
-BOOL GetLinkTarget(const char *path, asset_t *asset)
+void GetOwnerCacheWidths(size_t *ownerWidth, size_t *domainWidth)
+{
+    AcquireSRWLockShared(&g_OwnerCacheLock);
+
+    *ownerWidth = g_OwnerCacheWidth;
+    *domainWidth = g_DomainCacheWidth;
+
+    ReleaseSRWLockShared(&g_OwnerCacheLock);
+}
+
+BOOL GetLinkTarget(const char *path, char *buffer, size_t bufferSize)
 {
     HANDLE h = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    CountStatsCalls(STATS_PROBE_LINK, 1, 1);
     if (h == INVALID_HANDLE_VALUE) { return FALSE; }
 
-    DWORD wBytes = GetFinalPathNameByHandleA(h, asset->link, MAX_PATH, VOLUME_NAME_DOS);
-    CHECK_CLOSE_HANDLE(h);
+    DWORD wBytes = GetFinalPathNameByHandleA(h, buffer, (DWORD)bufferSize, VOLUME_NAME_DOS);
+    CountStatsCalls(STATS_PROBE_LINK, 1, 0);
+    CHECK_CLOSE_COUNTED(STATS_PROBE_LINK, h);
 
-    return wBytes < MAX_PATH;
+    return wBytes > 0 && wBytes < bufferSize;
 }
 
 
@@ -157,15 +373,39 @@ void TranslateAttributes(size_t attributes, asset_t *asset)
 BOOL IsValidDirectory(const char *path)
 {
     DWORD dwAttrib = GetFileAttributesA(path);
+    CountStatsCalls(STATS_PROBE_ATTRIBUTES, 1, 0);
     return (dwAttrib != INVALID_FILE_ATTRIBUTES) && (dwAttrib & FILE_ATTRIBUTE_DIRECTORY);
 }
 
 BOOL IsValidDocument(const char *path)
 {
     DWORD dwAttrib = GetFileAttributesA(path);
+    CountStatsCalls(STATS_PROBE_ATTRIBUTES, 1, 0);
     return (dwAttrib != INVALID_FILE_ATTRIBUTES) && !(dwAttrib & FILE_ATTRIBUTE_DIRECTORY);
 }
 
+BOOL GetFileIdentity(const char *path, file_identity_t *identity)
+{
+    BY_HANDLE_FILE_INFORMATION info = { 0 };
+
+    HANDLE h = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    CountStatsCalls(STATS_PROBE_IDENTITY, 1, 1);
+    if (h == INVALID_HANDLE_VALUE) { return FALSE; }
+
+    BOOL result = GetFileInformationByHandle(h, &info);
+    CountStatsCalls(STATS_PROBE_IDENTITY, 1, 0);
+    CHECK_CLOSE_COUNTED(STATS_PROBE_IDENTITY, h);
+
+    ULARGE_INTEGER ul;
+    ul.HighPart = info.nFileIndexHigh;
+    ul.LowPart = info.nFileIndexLow;
+
+    identity->volume = info.dwVolumeSerialNumber;
+    identity->index = ul.QuadPart;
+
+    return result;
+}
+
 size_t TranslateFileSize(WIN32_FIND_DATAA *fd)
 {
     ULARGE_INTEGER ul;
@@ -12,9 +12,19 @@
  */
 void GetPermissions(const char *path, asset_t *asset);
 
+/**
+ * @brief Get the asset permission for the current user from an open handle,
+ * see 'GetPermissions'. The path is not resolved again.
+ *
+ * @param hFile  handle opened with READ_CONTROL (see 'OpenAssetById'), INVALID_HANDLE_VALUE sets no permission
+ * @param asset  pointer of the asset data structure where information is stored
+ */
+void GetPermissionsByHandle(HANDLE hFile, asset_t *asset);
+
 /**
  * @brief Get the owner and the owner domain of the asset.
- * By default an hyphen it will be show.
+ * By default an hyphen it will be show. The names are cached
+ * by owner SID, the account is only looked up once.
  *
  * @param path      full path of the asset
  * @param asset     pointer of the asset data structure where information is stored
@@ -23,13 +33,42 @@ void GetPermissions(const char *path, asset_t *asset);
 BOOL GetOwnerAndDomain(const char *path, asset_t *asset);
 
 /**
- * @brief Get symbolic link real path.
+ * @brief Get the owner and the owner domain of the asset from an open handle,
+ * see 'GetOwnerAndDomain'. The path is not resolved again.
  *
- * @param path      full path of the symbolic link
+ * @param hFile     handle opened with READ_CONTROL (see 'OpenAssetById'), INVALID_HANDLE_VALUE sets an hyphen
  * @param asset     pointer of the asset data structure where information is stored
- * @return BOOL     TRUE is path can be retrieved, FALSE otherwise
+ * @return BOOL     TRUE if owner and domain can be retrieved, FALSE otherwise
+ */
+BOOL GetOwnerAndDomainByHandle(HANDLE hFile, asset_t *asset);
+
+/**
+ * @brief Open an asset by its file id, relative to the volume of an open
+ * directory, with READ_CONTROL access. No path is parsed or walked.
+ *
+ * @param directory     handle of a directory on the same volume
+ * @param id            file id of the asset (see 'FILE_ID_BOTH_DIR_INFO')
+ * @return HANDLE       handle of the asset or INVALID_HANDLE_VALUE otherwise
+ */
+HANDLE OpenAssetById(HANDLE directory, LARGE_INTEGER id);
+
+/**
+ * @brief Longest owner and domain names found so far (see 'GetOwnerAndDomain').
+ *
+ * @param ownerWidth    valid pointer where the owner width is stored
+ * @param domainWidth   valid pointer where the domain width is stored
  */
-BOOL GetLinkTarget(const char *path, asset_t *asset);
+void GetOwnerCacheWidths(size_t *ownerWidth, size_t *domainWidth);
+
+/**
+ * @brief Get symbolic link real path.
+ *
+ * @param path          full path of the symbolic link
+ * @param buffer        char array where the real path is stored
+ * @param bufferSize    size in bytes of the buffer
+ * @return BOOL         TRUE is path can be retrieved, FALSE otherwise
+ */
+BOOL GetLinkTarget(const char *path, char *buffer, size_t bufferSize);
 
 /**
  * @brief Translate the Win32 attributes to the asset data types.
@@ -55,6 +94,16 @@ BOOL IsValidDirectory(const char *path);
  */
 BOOL IsValidDocument(const char *path);
 
+/**
+ * @brief Get the identity of the asset, the volume serial number and the
+ * file index. Links and mount points are followed.
+ *
+ * @param path      full path of the asset
+ * @param identity  valid pointer where the identity is stored
+ * @return BOOL     TRUE if it can be retrieved, FALSE otherwise
+ */
+BOOL GetFileIdentity(const char *path, file_identity_t *identity);
+
 /**
  * @brief Translate the Win32 file size format to bytes size.
  *
@@ -86,3 +135,12 @@ BOOL DisableVirtualTerminal();
  * @return BOOL     TRUE if it can be retrieved, FALSE otherwise
  */
 BOOL GetScreenBufferSize(size_t *width, size_t *height);
+
+/**
+ * @brief Description of the last error of the thread (GetLastError).
+ *
+ * @param buffer        buffer where the description is stored
+ * @param bufferSize    size of the buffer
+ * @return const char*  the buffer, empty if there is no error
+ */
+const char *GetLastErrorAsString(char *buffer, size_t bufferSize);